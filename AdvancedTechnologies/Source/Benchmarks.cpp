@@ -0,0 +1,360 @@
+/*
+  ==============================================================================
+    Benchmarks.cpp
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "PadToneBank.h"
+#include "SamplePlayer.h"
+#include "SynthVoiceBank.h"
+#include "OversampledDrive.h"
+#include "ModMatrix.h"
+
+#include <iostream>
+
+namespace
+{
+    constexpr int    kBlockSize  = 512;
+    constexpr double kSampleRate = 48000.0;
+    constexpr int    kNumBlocks  = 4000;
+
+    // Times fn over kNumBlocks calls and prints microseconds per block
+    template <typename Fn>
+    double measure (const juce::String& name, Fn&& fn)
+    {
+        for (int i = 0; i < 50; ++i)   // warm caches and branch predictors
+            fn();
+
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < kNumBlocks; ++i)
+            fn();
+
+        const auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+        const auto usPerBlock = seconds * 1.0e6 / kNumBlocks;
+        const auto budgetUs   = kBlockSize / kSampleRate * 1.0e6;
+
+        std::cout << "  " << name.paddedRight (' ', 44)
+                  << juce::String (usPerBlock, 2).paddedLeft (' ', 9) << " us/block"
+                  << juce::String (100.0 * usPerBlock / budgetUs, 2).paddedLeft (' ', 8) << " % of budget"
+                  << std::endl;
+
+        return usPerBlock;
+    }
+
+    void fillWithNoise (juce::AudioBuffer<float>& buffer, juce::Random& random)
+    {
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample (channel, i, random.nextFloat() * 2.0f - 1.0f);
+    }
+
+    //==========================================================================
+    void benchmarkPadToneBank()
+    {
+        std::cout << "PadToneBank: 16 pads x (filter + EQ) x stereo, "
+                  << PadToneBank::kNumPads << " pads active" << std::endl;
+
+        PadToneBank bank;
+        juce::Random random (1);
+
+        for (int pad = 0; pad < PadToneBank::kNumPads; ++pad)
+        {
+            PadToneBank::PadTone tone;
+            tone.filterType = pad % 2 == 0 ? PadToneBank::FilterType::lowPass : PadToneBank::FilterType::highPass;
+            tone.cutoffHz   = 200.0f + 500.0f * (float) pad;
+            tone.resonance  = 1.2f;
+            tone.eqGainDb   = 6.0f;
+            bank.setTone (pad, tone);
+        }
+
+        bank.prepare (kBlockSize, kSampleRate);
+        bank.update();
+
+        // The filters work in place, so every run starts again from the same
+        // noise; left to feed back, the boosted EQ would run off to inf/NaN
+        std::array<juce::AudioBuffer<float>, PadToneBank::kNumPads> inputs, pads;
+
+        for (size_t pad = 0; pad < pads.size(); ++pad)
+        {
+            inputs[pad].setSize (2, kBlockSize);
+            fillWithNoise (inputs[pad], random);
+            pads[pad].setSize (2, kBlockSize);
+        }
+
+        const auto restoreInputs = [&]
+        {
+            for (size_t pad = 0; pad < pads.size(); ++pad)
+                pads[pad].makeCopyOf (inputs[pad], true);
+        };
+
+        constexpr std::uint32_t allPads = (1u << PadToneBank::kNumPads) - 1u;
+
+        const auto scalar = measure ("scalar (one pad at a time)", [&]
+        {
+            restoreInputs();
+            bank.processScalar (pads, allPads, kBlockSize);
+        });
+
+        bank.reset();
+
+        const auto simd = measure ("SIMD (pads across lanes)", [&]
+        {
+            restoreInputs();
+            bank.process (pads, allPads, kBlockSize);
+        });
+
+        std::cout << "  speed-up: " << juce::String (scalar / simd, 2) << "x" << std::endl << std::endl;
+    }
+
+    //==========================================================================
+    void benchmarkSynthVoices()
+    {
+        constexpr int kNumVoices = SynthVoiceBank::kMaxVoices;
+
+        std::cout << "SynthVoiceBank: " << kNumVoices << " held sine voices, stereo out" << std::endl;
+
+        SynthVoiceBank bank;
+        bank.prepare (kBlockSize, kSampleRate);
+
+        // Held notes sit at full level after the 1 ms attack, so the voice
+        // count stays constant for the whole run
+        for (int voice = 0; voice < kNumVoices; ++voice)
+            bank.noteOn (voice, 0.5f, 1.0f);
+
+        juce::AudioBuffer<float> output (2, kBlockSize);
+
+        const auto run = [&] (const juce::String& name, float endGain, auto renderFn)
+        {
+            return measure (name, [&]
+            {
+                output.clear();
+                (bank.*renderFn) (output.getArrayOfWritePointers(), 2, kBlockSize, 0.01f, endGain);
+            });
+        };
+
+        const auto scalar = run ("scalar (one voice at a time)", 0.01f, &SynthVoiceBank::renderScalar);
+        const auto simd   = run ("SIMD, options tested per sample", 0.01f, &SynthVoiceBank::renderGeneric);
+        const auto kernel = run ("SIMD, specialised kernel", 0.01f, &SynthVoiceBank::render);
+
+        std::cout << "  speed-up: " << juce::String (scalar / simd, 2) << "x from SIMD, "
+                  << juce::String (simd / kernel, 2) << "x more from the kernel" << std::endl;
+
+        // A volume move in progress: the gain ramps across every block
+        const auto rampGeneric = run ("SIMD + gain ramp, tested per sample", 0.02f, &SynthVoiceBank::renderGeneric);
+        const auto rampKernel  = run ("SIMD + gain ramp, specialised kernel", 0.02f, &SynthVoiceBank::render);
+
+        std::cout << "  speed-up: " << juce::String (rampGeneric / rampKernel, 2) << "x" << std::endl << std::endl;
+    }
+
+    //==========================================================================
+    void benchmarkOversampledDrive()
+    {
+        std::cout << "OversampledDrive: mono synth bus, drive 0.5" << std::endl;
+
+        OversampledDrive drive;
+        drive.prepare (kBlockSize);
+
+        juce::Random random (3);
+        juce::AudioBuffer<float> input (1, kBlockSize), work (1, kBlockSize);
+        fillWithNoise (input, random);
+
+        const char* names[] = { "1x (no oversampling)", "2x", "4x", "8x" };
+        double baseline = 0.0;
+
+        for (int factorLog2 = 0; factorLog2 <= OversampledDrive::kMaxFactorLog2; ++factorLog2)
+        {
+            const auto us = measure (names[factorLog2], [&]
+            {
+                work.copyFrom (0, 0, input, 0, 0, kBlockSize);
+                drive.process (work.getWritePointer (0), kBlockSize, 0.5f, factorLog2);
+            });
+
+            if (factorLog2 == 0)
+                baseline = us;
+
+            std::cout << "    " << juce::String (us / baseline, 2) << "x the cost of 1x, latency "
+                      << juce::String (drive.getLatencySamples (factorLog2), 1) << " samples" << std::endl;
+        }
+
+        std::cout << std::endl;
+    }
+
+    //==========================================================================
+    void benchmarkSamplePlayback()
+    {
+        constexpr int kNumVoices = 16;
+
+        std::cout << "SamplePlayer: " << kNumVoices << " voices, mono 1 s noise, stereo out" << std::endl;
+
+        juce::Random random (2);
+        juce::AudioBuffer<float> noise (1, (int) kSampleRate);
+        fillWithNoise (noise, random);
+
+        std::array<SamplePlayer, kNumVoices> voices;
+
+        for (auto& voice : voices)
+        {
+            voice.setSample (noise, kSampleRate, "noise");
+            voice.prepareToPlay (kBlockSize, kSampleRate);
+        }
+
+        juce::AudioBuffer<float> output (2, kBlockSize);
+
+        const auto run = [&] (const juce::String& name, SamplePlayer::Interpolation quality, double pitchRatio)
+        {
+            for (auto& voice : voices)
+                voice.setInterpolation (quality);
+
+            return measure (name, [&]
+            {
+                output.clear();
+
+                for (auto& voice : voices)
+                {
+                    if (! voice.isPlaying())
+                        voice.trigger (pitchRatio);
+
+                    voice.renderNextBlock (output, 0, kBlockSize);
+                }
+            });
+        };
+
+        const double fifthUp = std::exp2 (7.0 / 12.0);
+
+        const auto plain = run ("native pitch (no interpolation)", SamplePlayer::Interpolation::cubic, 1.0);
+
+        const std::pair<const char*, SamplePlayer::Interpolation> levels[] =
+        {
+            { "+7 st linear",          SamplePlayer::Interpolation::linear },
+            { "+7 st cubic (Hermite)", SamplePlayer::Interpolation::cubic },
+            { "+7 st sinc (16 taps)",  SamplePlayer::Interpolation::sinc }
+        };
+
+        for (const auto& [name, quality] : levels)
+        {
+            const auto tuned = run (name, quality, fifthUp);
+            std::cout << "    " << juce::String (tuned / plain, 2) << "x native" << std::endl;
+        }
+
+        std::cout << std::endl;
+    }
+
+    //==========================================================================
+    void benchmarkModulation()
+    {
+        std::cout << "ModMatrix: LFO routings, evaluated across each block" << std::endl;
+
+        ModMatrix matrix;
+        matrix.prepare (kSampleRate);
+        matrix.setLfo (0, 5.0f, ModMatrix::LfoShape::sine,     0.0);
+        matrix.setLfo (1, 0.5f, ModMatrix::LfoShape::triangle, 0.0);
+
+        volatile float sink = 0.0f;    // keeps the evaluation from being optimised away
+
+        for (const int interval : { 1, 16, 32 })
+        {
+            matrix.setControlInterval (interval);
+            double none = 0.0;
+
+            for (int numRoutings = 0; numRoutings <= ModMatrix::kMaxRoutings; ++numRoutings)
+            {
+                for (int slot = 0; slot < ModMatrix::kMaxRoutings; ++slot)
+                {
+                    ModMatrix::Routing routing;
+
+                    if (slot < numRoutings)
+                    {
+                        routing.source = slot % 2 == 0 ? ModMatrix::Source::lfo1 : ModMatrix::Source::lfo2;
+                        routing.target = slot < 2 ? ModMatrix::Target::pitch : ModMatrix::Target::volume;
+                        routing.depth  = 0.1f;
+                    }
+
+                    matrix.setRouting (slot, routing);
+                }
+
+                const auto us = measure ("every " + juce::String (interval) + " samples, "
+                                         + juce::String (numRoutings) + " routings", [&]
+                {
+                    for (int done = 0; done < kBlockSize; done += interval)
+                    {
+                        matrix.advance (interval);
+                        sink = sink + matrix.getEndValue (ModMatrix::Target::pitch);
+                    }
+                });
+
+                if (numRoutings == 0)
+                    none = us;
+                else
+                    std::cout << "    " << juce::String ((us - none) / numRoutings, 3)
+                              << " us/block per routing" << std::endl;
+            }
+        }
+
+        // ---------------------------------------------------------------------
+        // What the synth pays for the interpolation: a pitch glide and a gain
+        // ramp in every 32-sample control interval, against a static render
+        // ---------------------------------------------------------------------
+        constexpr int kInterval = ModMatrix::kDefaultControlInterval;
+        juce::AudioBuffer<float> output (2, kBlockSize);
+
+        for (const int numVoices : { 16, SynthVoiceBank::kMaxVoices })
+        {
+            std::cout << "  SynthVoiceBank, " << numVoices << " held voices, "
+                      << kInterval << "-sample intervals" << std::endl;
+
+            SynthVoiceBank bank;
+            bank.prepare (kBlockSize, kSampleRate);
+
+            for (int voice = 0; voice < numVoices; ++voice)
+                bank.noteOn (voice, 0.5f, 1.0f);
+
+            const auto run = [&] (const juce::String& name, bool modulated)
+            {
+                bool up = false;
+
+                return measure (name, [&]
+                {
+                    output.clear();
+
+                    for (int offset = 0; offset < kBlockSize; offset += kInterval)
+                    {
+                        float* outputs[] = { output.getWritePointer (0, offset), output.getWritePointer (1, offset) };
+
+                        if (! modulated)
+                        {
+                            bank.render (outputs, 2, kInterval, 0.01f, 0.01f);
+                            continue;
+                        }
+
+                        up = ! up;
+                        bank.setDetune (up ? 0.1f : -0.1f, true);
+                        bank.render (outputs, 2, kInterval, up ? 0.01f : 0.02f, up ? 0.02f : 0.01f);
+                    }
+                });
+            };
+
+            const auto still     = run ("static", false);
+            const auto modulated = run ("pitch glide + gain ramp", true);
+
+            std::cout << "    " << juce::String (modulated / still, 2) << "x static" << std::endl;
+        }
+
+        std::cout << std::endl;
+    }
+}
+
+//==============================================================================
+void Benchmarks::runAll()
+{
+    std::cout << "Advanced Technologies benchmarks ("
+              << kBlockSize << " samples @ " << kSampleRate << " Hz, "
+              << kNumBlocks << " blocks each)" << std::endl << std::endl;
+
+    benchmarkPadToneBank();
+    benchmarkSynthVoices();
+    benchmarkOversampledDrive();
+    benchmarkSamplePlayback();
+    benchmarkModulation();
+}
@@ -0,0 +1,24 @@
+/*
+  ==============================================================================
+    Benchmarks.h
+    Micro-benchmarks for the DSP kernels, run with:
+
+        AdvancedTechnologies --benchmark
+
+    Results are printed to stdout and the app quits without opening a window.
+
+    CONCEPT: Each benchmark times many blocks of a realistic size and reports
+             the cost per block and as a percentage of that block's real-time
+             budget (512 samples at 48 kHz = 10.7 ms). Always compare builds
+             in Release — Debug timings say little about real performance.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace Benchmarks
+{
+    // Runs every benchmark and prints a table of results
+    void runAll();
+}
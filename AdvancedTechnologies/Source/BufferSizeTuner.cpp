@@ -0,0 +1,245 @@
+/*
+  ==============================================================================
+    BufferSizeTuner.cpp
+  ==============================================================================
+*/
+
+#include "BufferSizeTuner.h"
+
+namespace
+{
+    juce::PropertiesFile::Options getSettingsOptions()
+    {
+        juce::PropertiesFile::Options options;
+        options.applicationName     = "AdvancedTechnologies";
+        options.folderName          = "AdvancedTechnologies";
+        options.filenameSuffix      = ".settings";
+        options.osxLibrarySubFolder = "Application Support";
+        return options;
+    }
+
+    juce::String describeSize (int bufferSize, double sampleRate)
+    {
+        return juce::String (bufferSize) + " samples ("
+             + juce::String (1000.0 * bufferSize / juce::jmax (1.0, sampleRate), 2) + " ms)";
+    }
+}
+
+BufferSizeTuner::BufferSizeTuner (juce::AudioDeviceManager& dm, LoadGovernor& g)
+    : deviceManager (dm),
+      governor (g),
+      settings (getSettingsOptions())
+{
+}
+
+BufferSizeTuner::~BufferSizeTuner()
+{
+    stopTimer();
+    settings.saveIfNeeded();
+}
+
+//==============================================================================
+juce::String BufferSizeTuner::getDeviceKey() const
+{
+    auto* device = deviceManager.getCurrentAudioDevice();
+
+    if (device == nullptr)
+        return {};
+
+    return "bufferSize " + device->getTypeName() + "/" + device->getName()
+         + "@" + juce::String (juce::roundToInt (device->getCurrentSampleRate()));
+}
+
+bool BufferSizeTuner::applySavedBufferSize()
+{
+    const auto key = getDeviceKey();
+    const int saved = settings.getIntValue (key, 0);
+
+    auto setup = deviceManager.getAudioDeviceSetup();
+
+    if (key.isEmpty() || saved <= 0 || saved == setup.bufferSize)
+        return false;
+
+    setup.bufferSize = saved;
+    return deviceManager.setAudioDeviceSetup (setup, true).isEmpty();
+}
+
+void BufferSizeTuner::saveBufferSize (int bufferSize)
+{
+    settings.setValue (getDeviceKey(), bufferSize);
+    settings.saveIfNeeded();
+}
+
+//==============================================================================
+void BufferSizeTuner::start (std::function<void()> generateLoad,
+                             std::function<void (const juce::String&)> onFinished)
+{
+    auto* device = deviceManager.getCurrentAudioDevice();
+
+    if (device == nullptr || isRunning())
+        return;
+
+    loadCallback     = std::move (generateLoad);
+    finishedCallback = std::move (onFinished);
+
+    // Written back so the margin shows up in the file, ready to be edited
+    safetyMargin = juce::jlimit (0.0, 0.9, settings.getDoubleValue ("calibrationSafetyMargin", kDefaultSafetyMargin));
+    settings.setValue ("calibrationSafetyMargin", safetyMargin);
+
+    originalSize = device->getCurrentBufferSizeSamples();
+    stableSize   = 0;
+    steppingUp   = false;
+
+    candidates.clear();
+
+    for (const int size : device->getAvailableBufferSizes())
+        if (size <= kMaxBufferSize)
+            candidates.addIfNotAlreadyThere (size);
+
+    candidates.addIfNotAlreadyThere (originalSize);
+    candidates.sort();
+
+    startTimer (50);
+    tryBufferSize (candidates.indexOf (originalSize));
+}
+
+void BufferSizeTuner::cancel()
+{
+    if (! isRunning())
+        return;
+
+    stopTimer();
+
+    auto setup = deviceManager.getAudioDeviceSetup();
+    setup.bufferSize = originalSize;
+    deviceManager.setAudioDeviceSetup (setup, true);
+
+    status = "Calibration cancelled";
+
+    if (finishedCallback)
+        finishedCallback (status);
+}
+
+void BufferSizeTuner::tryBufferSize (int index)
+{
+    candidateIndex = index;
+
+    auto setup = deviceManager.getAudioDeviceSetup();
+    setup.bufferSize = candidates[index];
+
+    const auto error = deviceManager.setAudioDeviceSetup (setup, true);
+    auto* device     = deviceManager.getCurrentAudioDevice();
+
+    // A driver may accept a size and open with a different one
+    if (error.isNotEmpty() || device == nullptr || device->getCurrentBufferSizeSamples() != candidates[index])
+    {
+        juce::Logger::writeToLog ("Calibration: " + juce::String (candidates[index]) + " samples wouldn't open"
+                                  + (error.isNotEmpty() ? ": " + error : juce::String()));
+
+        if (device == nullptr)
+            finish (originalSize, "Calibration failed: the device closed");
+        else
+            stepFinished (false);
+
+        return;
+    }
+
+    measuring    = false;
+    phaseStartMs = juce::Time::getMillisecondCounterHiRes();
+    status       = "Calibrating: trying " + describeSize (candidates[index], device->getCurrentSampleRate()) + "...";
+}
+
+//==============================================================================
+void BufferSizeTuner::timerCallback()
+{
+    if (loadCallback)
+        loadCallback();
+
+    const auto elapsedMs = juce::Time::getMillisecondCounterHiRes() - phaseStartMs;
+
+    if (! measuring)
+    {
+        // -------------------------------------------------------------------------
+        // The first blocks after a restart are unrepresentative (caches cold,
+        // the driver refilling), so they're thrown away
+        // -------------------------------------------------------------------------
+        if (elapsedMs >= kSettleMs)
+        {
+            governor.takePeakLoad();
+            xrunsAtStart = deviceManager.getXRunCount();
+            measuring    = true;
+            phaseStartMs = juce::Time::getMillisecondCounterHiRes();
+        }
+
+        return;
+    }
+
+    if (elapsedMs < kMeasureMs)
+        return;
+
+    const float peakLoad = governor.takePeakLoad();
+    const int   xruns    = deviceManager.getXRunCount() - xrunsAtStart;
+    const bool  stable   = xruns == 0 && peakLoad <= (float) (1.0 - safetyMargin);
+
+    juce::Logger::writeToLog ("Calibration: " + juce::String (candidates[candidateIndex]) + " samples, peak load "
+                              + juce::String (juce::roundToInt (peakLoad * 100.0f)) + "%, "
+                              + juce::String (xruns) + " xruns - " + (stable ? "stable" : "NOT stable"));
+
+    stepFinished (stable);
+}
+
+void BufferSizeTuner::stepFinished (bool stable)
+{
+    const int size = candidates[candidateIndex];
+
+    if (stable)
+    {
+        stableSize = size;
+
+        // Going down: keep going while there's a smaller size to try.
+        // Going up: every smaller size failed, so this is the one.
+        if (! steppingUp && candidateIndex > 0)
+        {
+            tryBufferSize (candidateIndex - 1);
+            return;
+        }
+    }
+    else if (stableSize == 0)
+    {
+        // Even the starting size isn't stable: look for headroom above it
+        steppingUp = true;
+
+        if (candidateIndex < candidates.size() - 1)
+        {
+            tryBufferSize (candidateIndex + 1);
+            return;
+        }
+
+        finish (candidates.getLast(), "Calibration: no size was stable; using the largest, "
+                                      + juce::String (candidates.getLast()) + " samples");
+        return;
+    }
+
+    const auto rate = deviceManager.getCurrentAudioDevice() != nullptr
+                          ? deviceManager.getCurrentAudioDevice()->getCurrentSampleRate() : 0.0;
+
+    finish (stableSize, "Calibrated: " + describeSize (stableSize, rate) + " with "
+                        + juce::String (juce::roundToInt (safetyMargin * 100.0)) + "% headroom");
+}
+
+void BufferSizeTuner::finish (int bufferSize, const juce::String& summary)
+{
+    stopTimer();
+
+    auto setup = deviceManager.getAudioDeviceSetup();
+    setup.bufferSize = bufferSize;
+
+    if (deviceManager.getCurrentAudioDevice() != nullptr && deviceManager.setAudioDeviceSetup (setup, true).isEmpty())
+        saveBufferSize (bufferSize);
+
+    status = summary;
+    juce::Logger::writeToLog (summary);
+
+    if (finishedCallback)
+        finishedCallback (summary);
+}
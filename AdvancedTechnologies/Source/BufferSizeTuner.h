@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+    BufferSizeTuner.h
+    Calibration: finds the smallest buffer size this machine can run
+    without dropouts, and remembers it for each device.
+
+    CONCEPT: Latency is mostly buffer size — 64 samples at 48 kHz is 1.3 ms,
+             1024 is 21 ms. But a smaller buffer leaves less time per
+             callback, and the same work that fits easily in 512 samples
+             can miss the deadline at 64. The only reliable way to know
+             where the edge is on a given machine is to try it.
+
+    How: starting at the current size, every size the device offers is run
+         for a few seconds under a stress load (all pads retriggered, a
+         synth note held) with the output muted. A size is stable when the
+         device reports no xruns AND the peak render load stays below
+         1 - safety margin. We step down while sizes are stable and settle
+         on the last one; if the starting size isn't stable we step up.
+
+    The result is saved per device type, device and sample rate in the
+    app's settings file, along with calibrationSafetyMargin (default 0.3,
+    edit it there to trade latency for headroom).
+
+    Threads: message thread only. The audio thread is only observed,
+             through the governor's peak load and the device's xrun count.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "LoadGovernor.h"
+
+class BufferSizeTuner : private juce::Timer
+{
+public:
+    static constexpr double kDefaultSafetyMargin = 0.3;
+    static constexpr int    kSettleMs            = 500;    // after each size change
+    static constexpr int    kMeasureMs           = 4000;   // per size
+    static constexpr int    kMaxBufferSize       = 2048;
+
+    BufferSizeTuner (juce::AudioDeviceManager& deviceManager, LoadGovernor& governor);
+    ~BufferSizeTuner() override;
+
+    // Switches the open device to the size saved for it, if there is one.
+    // Returns true if the size changed.
+    bool applySavedBufferSize();
+
+    // -------------------------------------------------------------------------
+    // Calibration. generateLoad is called every 50 ms while it runs and
+    // should keep the engines busy; onFinished receives a one-line summary.
+    // -------------------------------------------------------------------------
+    void start (std::function<void()> generateLoad,
+                std::function<void (const juce::String& summary)> onFinished);
+
+    // Stops and goes back to the size in use before start()
+    void cancel();
+
+    bool isRunning() const                  { return isTimerRunning(); }
+    const juce::String& getStatus() const   { return status; }
+
+private:
+    void timerCallback() override;
+
+    // Switches to candidates[index] and starts settling. A size the device
+    // refuses counts as unstable straight away.
+    void tryBufferSize (int index);
+    void stepFinished (bool stable);
+    void finish (int bufferSize, const juce::String& summary);
+    void saveBufferSize (int bufferSize);
+
+    juce::String getDeviceKey() const;
+
+    juce::AudioDeviceManager& deviceManager;
+    LoadGovernor&             governor;
+    juce::PropertiesFile      settings;
+
+    std::function<void()>                     loadCallback;
+    std::function<void (const juce::String&)> finishedCallback;
+
+    // -------------------------------------------------------------------------
+    // The run in progress
+    // -------------------------------------------------------------------------
+    juce::Array<int> candidates;        // ascending
+    int    candidateIndex  = 0;
+    int    originalSize    = 0;
+    int    stableSize      = 0;         // 0 = none found yet
+    bool   steppingUp      = false;
+    bool   measuring       = false;     // false while settling
+    double phaseStartMs    = 0.0;
+    int    xrunsAtStart    = 0;
+    double safetyMargin    = kDefaultSafetyMargin;
+    juce::String status;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BufferSizeTuner)
+};
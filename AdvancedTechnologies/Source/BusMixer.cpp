@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+    BusMixer.cpp
+  ==============================================================================
+*/
+
+#include "BusMixer.h"
+#include "Trace.h"
+
+BusMixer::~BusMixer()
+{
+    releaseResources();
+}
+
+void BusMixer::addInputSource (BusSource* bus)
+{
+    if (bus == nullptr)
+        return;
+
+    int    samplesPerBlock;
+    double sampleRate;
+
+    {
+        const juce::ScopedLock sl (lock);
+
+        if (buses.contains (bus))
+            return;
+
+        samplesPerBlock = blockSize;
+        sampleRate      = currentSampleRate;
+    }
+
+    // Outside the lock: preparing may allocate, and the audio thread waits on it
+    if (sampleRate > 0.0)
+        bus->prepareToPlay (samplesPerBlock, sampleRate);
+
+    const juce::ScopedLock sl (lock);
+    buses.add (bus);
+}
+
+void BusMixer::removeInputSource (BusSource* bus)
+{
+    {
+        const juce::ScopedLock sl (lock);
+
+        if (! buses.contains (bus))
+            return;
+
+        buses.removeFirstMatchingValue (bus);
+    }
+
+    bus->releaseResources();
+}
+
+void BusMixer::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
+{
+    const juce::ScopedLock sl (lock);
+
+    blockSize         = samplesPerBlockExpected;
+    currentSampleRate = sampleRate;
+    scratch.setSize (2, juce::jmax (1, samplesPerBlockExpected));
+
+    for (auto* bus : buses)
+        bus->prepareToPlay (samplesPerBlockExpected, sampleRate);
+}
+
+void BusMixer::releaseResources()
+{
+    const juce::ScopedLock sl (lock);
+
+    for (auto* bus : buses)
+        bus->releaseResources();
+
+    scratch.setSize (2, 0);
+    currentSampleRate = 0.0;
+}
+
+void BusMixer::getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    AT_TRACE_SCOPE ("Bus mix");
+
+    const juce::ScopedLock sl (lock);
+
+    // -------------------------------------------------------------------------
+    // The first bus with sound writes the output directly; a silent one
+    // leaves it untouched, so the next bus can still have it
+    // -------------------------------------------------------------------------
+    bool anySound = false;
+
+    for (auto* bus : buses)
+    {
+        if (! anySound)
+        {
+            anySound = bus->renderNextBlock (bufferToFill);
+            continue;
+        }
+
+        // A host may exceed the promised block size
+        const int numChannels = bufferToFill.buffer->getNumChannels();
+
+        if (scratch.getNumChannels() < numChannels || scratch.getNumSamples() < bufferToFill.numSamples)
+            scratch.setSize (juce::jmax (numChannels, scratch.getNumChannels()),
+                             juce::jmax (bufferToFill.numSamples, scratch.getNumSamples()),
+                             false, false, true);
+
+        const juce::AudioSourceChannelInfo scratchInfo (&scratch, 0, bufferToFill.numSamples);
+
+        if (bus->renderNextBlock (scratchInfo))
+            for (int channel = 0; channel < numChannels; ++channel)
+                bufferToFill.buffer->addFrom (channel, bufferToFill.startSample, scratch, channel, 0,
+                                              bufferToFill.numSamples);
+    }
+
+    if (! anySound)
+        bufferToFill.clearActiveBufferRegion();
+}
@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+    BusMixer.h
+    BusSource: an AudioSource that can say it has nothing to play.
+    BusMixer:  sums BusSources, skipping the ones that are silent.
+
+    CONCEPT: Most of the time most of the engine is idle — no note held, no
+             pad ringing, the reverb long since decayed — yet a plain
+             AudioSource still clears its buffer, walks its voices and gets
+             added into the mix every block, whether its page is showing or
+             not. A BusSource tracks its own voices and tails instead, and
+             when all of them are done it skips the block: nothing rendered,
+             nothing written. renderNextBlock() returns false, and whoever
+             pulled it treats the block as silence without touching it.
+
+    CONCEPT: BusMixer replaces MixerAudioSource on the master bus. The first
+             bus with sound renders straight into the output, any others go
+             through the scratch buffer and are added; silent buses cost a
+             function call. With every bus idle the output is cleared once.
+
+    Threads: add / remove on the message thread; like MixerAudioSource, the
+             list is guarded by a CriticalSection that the audio thread only
+             ever holds for the length of a block. isSilent() from any thread.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+class BusSource : public juce::AudioSource
+{
+public:
+    // Renders the next block into bufferToFill and returns true, or
+    // returns false without touching it when the bus has nothing to play.
+    // Audio thread.
+    bool renderNextBlock (const juce::AudioSourceChannelInfo& bufferToFill)
+    {
+        const bool sounding = renderBus (bufferToFill);
+        silent.store (! sounding, std::memory_order_relaxed);
+        return sounding;
+    }
+
+    // AudioSource interface: a skipped block is cleared here
+    void getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill) final
+    {
+        if (! renderNextBlock (bufferToFill))
+            bufferToFill.clearActiveBufferRegion();
+    }
+
+    // True if the last block was skipped. Any thread.
+    bool isSilent() const      { return silent.load (std::memory_order_relaxed); }
+
+protected:
+    // Writes the whole of bufferToFill's region and returns true, or leaves
+    // it alone and returns false
+    virtual bool renderBus (const juce::AudioSourceChannelInfo& bufferToFill) = 0;
+
+private:
+    std::atomic<bool> silent { true };
+};
+
+//==============================================================================
+class BusMixer : public juce::AudioSource
+{
+public:
+    BusMixer() = default;
+    ~BusMixer() override;
+
+    // Prepares the bus straight away if the mixer is already playing. The
+    // bus must outlive its membership.
+    void addInputSource (BusSource* bus);
+    void removeInputSource (BusSource* bus);
+
+    // AudioSource interface
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
+    void getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill) override;
+    void releaseResources() override;
+
+private:
+    juce::Array<BusSource*>  buses;
+    juce::CriticalSection    lock;
+    juce::AudioBuffer<float> scratch;
+
+    int    blockSize         = 0;
+    double currentSampleRate = 0.0;     // 0 = not playing
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BusMixer)
+};
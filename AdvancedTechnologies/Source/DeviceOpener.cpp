@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+    DeviceOpener.cpp
+  ==============================================================================
+*/
+
+#include "DeviceOpener.h"
+#include "Trace.h"
+
+DeviceOpener::DeviceOpener (juce::AudioDeviceManager& dm, int inputs, int outputs)
+    : Thread ("Audio device opener"),
+      deviceManager (dm),
+      numInputs (inputs),
+      numOutputs (outputs)
+{
+}
+
+DeviceOpener::~DeviceOpener()
+{
+    cancel();
+}
+
+void DeviceOpener::open (std::function<void (const juce::String&)> onOpened)
+{
+    openedCallback = std::move (onOpened);
+
+    // Creating the device types is quick, and some backends want it done
+    // on the message thread. Scanning and opening happen on ours.
+    deviceManager.getAvailableDeviceTypes();
+
+    startThread();
+}
+
+void DeviceOpener::cancel()
+{
+    // Never kill it: a thread stopped inside a driver call can leave the
+    // driver locked. The fallback loop checks threadShouldExit().
+    signalThreadShouldExit();
+    waitForThreadToExit (-1);
+}
+
+void DeviceOpener::run()
+{
+    AT_TRACE_SCOPE ("Open audio device");
+
+    auto error = deviceManager.initialiseWithDefaultDevices (numInputs, numOutputs);
+
+    // -------------------------------------------------------------------------
+    // Fallback: e.g. ALSA refuses a device PulseAudio or PipeWire is holding,
+    // while JACK (or another backend) would open fine
+    // -------------------------------------------------------------------------
+    if (deviceManager.getCurrentAudioDevice() == nullptr)
+    {
+        const auto failedType = deviceManager.getCurrentAudioDeviceType();
+
+        for (auto* type : deviceManager.getAvailableDeviceTypes())
+        {
+            if (threadShouldExit())
+                return;
+
+            if (type->getTypeName() == failedType)
+                continue;
+
+            // Treated as the user's choice, this opens the type's default device
+            deviceManager.setCurrentAudioDeviceType (type->getTypeName(), true);
+
+            if (deviceManager.getCurrentAudioDevice() != nullptr)
+                break;
+        }
+    }
+
+    if (deviceManager.getCurrentAudioDevice() != nullptr)
+        error = {};
+    else if (error.isEmpty())
+        error = "no audio output device found";
+
+    juce::MessageManager::callAsync ([callback = openedCallback, error] { callback (error); });
+}
@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+    DeviceOpener.h
+    Opens the default audio device on a background thread, falling back to
+    the other audio backends if the default one won't open.
+
+    CONCEPT: Opening a device can take a second or more: the driver scans
+             its hardware, negotiates a rate and buffer size, and sometimes
+             waits for a USB interface to wake up. Done in the component's
+             constructor, the window can't appear until it finishes. Done
+             here, the window paints straight away and says what it's
+             waiting for.
+
+    Threads: open() and the callback on the message thread. The device
+             manager isn't thread safe, so nothing else may touch it — audio
+             callbacks, MIDI callbacks, status queries — until the callback
+             has run. Everything is added there, not before.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+class DeviceOpener : private juce::Thread
+{
+public:
+    DeviceOpener (juce::AudioDeviceManager& deviceManager, int numInputChannels, int numOutputChannels);
+
+    ~DeviceOpener() override;
+
+    // Starts opening. onOpened receives an empty string once a device is
+    // running, or the reason none could be opened (the app then runs silent).
+    void open (std::function<void (const juce::String& error)> onOpened);
+
+    // Skips any fallbacks not yet tried and waits for the driver call in
+    // progress. Call before closing the device manager.
+    void cancel();
+
+private:
+    void run() override;
+
+    juce::AudioDeviceManager& deviceManager;
+    const int numInputs;
+    const int numOutputs;
+
+    std::function<void (const juce::String&)> openedCallback;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DeviceOpener)
+};
@@ -0,0 +1,513 @@
+/*
+  ==============================================================================
+    DrumEngine.cpp
+  ==============================================================================
+*/
+
+#include "DrumEngine.h"
+#include "Trace.h"
+
+DrumEngine::DrumEngine()
+{
+    // -------------------------------------------------------------------------
+    // Assign MIDI notes: start from C2 (MIDI note 36) going chromatically
+    // -------------------------------------------------------------------------
+    for (int i = 0; i < kNumPads; ++i)
+    {
+        padNotes[i] = 36 + i;
+        samplePlayers[i] = std::make_unique<SamplePlayer>();
+        sendLevels[(size_t) i].store (0.0f);
+        padTunes[(size_t) i].store (0.0f);
+    }
+
+    registerKit ("Drums");
+}
+
+DrumEngine::~DrumEngine()
+{
+    // Waits for a pass that may be evicting or reloading one of our pads
+    memoryManager->removeKit (this);
+}
+
+void DrumEngine::registerKit (const juce::String& name)
+{
+    std::vector<SamplePlayer*> players;
+
+    for (auto& player : samplePlayers)
+        players.push_back (player.get());
+
+    memoryManager->addKit (this, name, std::move (players));
+}
+
+size_t DrumEngine::getPadMemoryBytes (int padIndex) const
+{
+    return (padIndex >= 0 && padIndex < kNumPads) ? samplePlayers[(size_t) padIndex]->getMemoryBytes() : 0;
+}
+
+bool DrumEngine::isPadEvicted (int padIndex) const
+{
+    return padIndex >= 0 && padIndex < kNumPads && samplePlayers[(size_t) padIndex]->isEvicted();
+}
+
+void DrumEngine::loadSamples (const juce::File& samplesDir)
+{
+    for (int i = 0; i < kNumPads; ++i)
+        loadPad (i, samplesDir);
+
+    loadReverb (samplesDir);
+}
+
+bool DrumEngine::loadPad (int padIndex, const juce::File& samplesDir)
+{
+    if (padIndex < 0 || padIndex >= kNumPads)
+        return false;
+
+    AT_TRACE_SCOPE_VALUE ("Load pad sample", padIndex);
+
+    // Every pad comes from the same folder; one of them names the kit
+    if (padIndex == 0)
+        registerKit (samplesDir.getFileName());
+
+    const auto sampleFile = findPadFile (samplesDir, padIndex);
+
+    if (! (sampleFile.existsAsFile() && samplePlayers[(size_t) padIndex]->loadSample (sampleFile, arena, &sampleCache)))
+    {
+        // No sample file — pad will produce silence but still light up
+        DBG ("SamplePlayer " << padIndex << ": no readable pad_" << padIndex << " in " << samplesDir.getFullPathName());
+        return false;
+    }
+
+    const auto& player = *samplePlayers[(size_t) padIndex];
+    const auto& info   = player.getInfo();
+
+    juce::Logger::writeToLog ("Pad " + juce::String (padIndex) + " (" + player.getName() + "): plays "
+                              + juce::String (info.getPlayedMs(), 0) + " of "
+                              + juce::String (1000.0 * info.numFrames / info.sampleRate, 0) + " ms, "
+                              + juce::String (info.getLeadMs(), 1) + " ms lead trimmed, peak "
+                              + juce::String (juce::Decibels::gainToDecibels (info.peak), 1) + " dB, RMS "
+                              + juce::String (juce::Decibels::gainToDecibels (info.rms), 1) + " dB");
+    return true;
+}
+
+juce::File DrumEngine::findPadFile (const juce::File& samplesDir, int padIndex)
+{
+    for (const auto* extension : { ".wav", ".flac", ".ogg", ".aiff", ".aif" })
+    {
+        const auto file = samplesDir.getChildFile ("pad_" + juce::String (padIndex) + extension);
+
+        if (file.existsAsFile())
+            return file;
+    }
+
+    return {};
+}
+
+void DrumEngine::loadReverb (const juce::File& samplesDir)
+{
+    // Loads in the background; the built-in room plays until it is ready
+    reverb.loadImpulseResponse (samplesDir.getChildFile ("reverb_ir.wav"));
+}
+
+void DrumEngine::reservePadCapture (int padIndex, int numChannels, int maxFrames)
+{
+    if (padIndex >= 0 && padIndex < kNumPads)
+        samplePlayers[(size_t) padIndex]->reserveCapture (numChannels, maxFrames);
+}
+
+void DrumEngine::releasePadCapture (int padIndex)
+{
+    if (padIndex >= 0 && padIndex < kNumPads)
+        samplePlayers[(size_t) padIndex]->releaseCapture();
+}
+
+bool DrumEngine::beginPadCapture (int padIndex, double sampleRate)
+{
+    return padIndex >= 0 && padIndex < kNumPads
+            && samplePlayers[(size_t) padIndex]->beginCapture (sampleRate);
+}
+
+int DrumEngine::appendPadCapture (int padIndex, const float* const* input, int numInputs, int start, int count)
+{
+    return padIndex >= 0 && padIndex < kNumPads
+            ? samplePlayers[(size_t) padIndex]->appendCapture (input, numInputs, start, count)
+            : 0;
+}
+
+bool DrumEngine::finishPadCapture (int padIndex, int numFrames, int fadeFrames)
+{
+    return padIndex >= 0 && padIndex < kNumPads
+            && samplePlayers[(size_t) padIndex]->finishCapture (numFrames, fadeFrames);
+}
+
+bool DrumEngine::abortPadCapture (int padIndex)
+{
+    return padIndex < 0 || padIndex >= kNumPads
+            || samplePlayers[(size_t) padIndex]->abortCapture();
+}
+
+void DrumEngine::setArena (LockedArena* newArena)
+{
+    arena = newArena;
+
+    if (arena == nullptr)
+        return;
+
+    // -------------------------------------------------------------------------
+    // Voice positions, filter state, the trigger queue and the sequencer all
+    // live inside these objects, and the audio thread touches them every
+    // block — so they get locked along with the sample data.
+    // -------------------------------------------------------------------------
+    arena->lockObject (this, sizeof (*this));
+
+    for (auto& player : samplePlayers)
+        arena->lockObject (player.get(), sizeof (SamplePlayer));
+}
+
+float DrumEngine::getSemitonesForNote (int note) const
+{
+    if (chromaticPad.load() < 0)
+        return 0.0f;
+
+    return juce::jlimit (-kMaxTuneSemitones, kMaxTuneSemitones, (float) (note - kChromaticRootNote));
+}
+
+void DrumEngine::setPadTune (int padIndex, float semitones)
+{
+    if (padIndex >= 0 && padIndex < kNumPads)
+        padTunes[(size_t) padIndex].store (juce::jlimit (-kMaxTuneSemitones, kMaxTuneSemitones, semitones));
+}
+
+float DrumEngine::getPadTune (int padIndex) const
+{
+    return (padIndex >= 0 && padIndex < kNumPads) ? padTunes[(size_t) padIndex].load() : 0.0f;
+}
+
+void DrumEngine::setChromaticPad (int padIndex)
+{
+    chromaticPad.store (padIndex >= 0 && padIndex < kNumPads ? padIndex : -1);
+}
+
+void DrumEngine::setSendLevel (int padIndex, float level)
+{
+    if (padIndex >= 0 && padIndex < kNumPads)
+        sendLevels[(size_t) padIndex].store (juce::jlimit (0.0f, 1.0f, level));
+}
+
+float DrumEngine::getSendLevel (int padIndex) const
+{
+    return (padIndex >= 0 && padIndex < kNumPads) ? sendLevels[(size_t) padIndex].load() : 0.0f;
+}
+
+void DrumEngine::triggerPad (int padIndex, float semitones)
+{
+    if (padIndex < 0 || padIndex >= kNumPads)
+        return;
+
+    // Writers serialise among themselves; the reader never takes the lock.
+    // If the queue is full the hit is dropped rather than blocking
+    const juce::SpinLock::ScopedLockType lock (triggerWriteLock);
+    const auto scope = triggerFifo.write (1);
+
+    if (scope.blockSize1 > 0)
+        triggerQueue[(size_t) scope.startIndex1] = { 0, padIndex, semitones, Trace::getCurrentFlowId() };
+}
+
+int DrumEngine::getPadForNote (int note) const
+{
+    if (const int pad = chromaticPad.load(); pad >= 0)
+        return pad;
+
+    for (int i = 0; i < kNumPads; ++i)
+        if (padNotes[i] == note)
+            return i;
+
+    return -1;
+}
+
+void DrumEngine::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
+{
+    for (auto& player : samplePlayers)
+        player->prepareToPlay (samplesPerBlockExpected, sampleRate);
+
+    sequencer.prepareToPlay (sampleRate);
+
+    maxBlockSize = juce::jmax (1, samplesPerBlockExpected);
+    mixMemory  = LockedArena::allocateBuffer (arena, mixBuffer,  2, maxBlockSize);
+    sendMemory = LockedArena::allocateBuffer (arena, sendBuffer, 2, maxBlockSize);
+    reverb.prepare (maxBlockSize, sampleRate);
+    reverbFade.reset (sampleRate, kReverbFadeSeconds);
+    reverbRunning = false;
+
+    for (size_t i = 0; i < padBuffers.size(); ++i)
+        padMemory[i] = LockedArena::allocateBuffer (arena, padBuffers[i], 2, maxBlockSize);
+
+    toneBank.prepare (maxBlockSize, sampleRate);
+}
+
+bool DrumEngine::renderBus (const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    if (maxBlockSize == 0)
+        return false; // not prepared yet
+
+    auto& buffer  = *bufferToFill.buffer;
+    bool sounding = false;
+
+    // Render in slices no longer than the block size we prepared for
+    for (int done = 0; done < bufferToFill.numSamples;)
+    {
+        const int sliceLength = juce::jmin (maxBlockSize, bufferToFill.numSamples - done);
+
+        if (renderBlock (sliceLength))
+        {
+            // The first slice with sound: any before it were silence
+            if (! sounding)
+                bufferToFill.clearActiveBufferRegion();
+
+            sounding = true;
+
+            // Mono outputs take the left channel; extra outputs reuse the right
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                buffer.addFrom (channel, bufferToFill.startSample + done,
+                                mixBuffer, juce::jmin (channel, 1), 0, sliceLength);
+        }
+
+        done += sliceLength;
+    }
+
+    return sounding;
+}
+
+bool DrumEngine::renderBlock (int numSamples)
+{
+    // -------------------------------------------------------------------------
+    // CONCEPT: The governor treats the reverb as optional. Under pressure we
+    // stop convolving altogether, which saves far more than any voice does.
+    // The return fades out over kReverbFadeSeconds before the convolution
+    // stops, and the convolution starts from a clean history when it comes
+    // back, so neither edge clicks or replays a stale tail.
+    // -------------------------------------------------------------------------
+    const bool wantReverb = reverbReturn.load() > 0.0f
+                             && (governor == nullptr || governor->allowsOptionalProcessing());
+
+    if (wantReverb && ! reverbRunning)
+    {
+        reverb.reset();
+        reverbFade.setCurrentAndTargetValue (0.0f);
+        reverbRunning = true;
+    }
+
+    reverbFade.setTargetValue (wantReverb ? 1.0f : 0.0f);
+    const bool useReverb = reverbRunning;
+
+    const bool separatePads = toneBank.update();
+
+    const auto quality = getInterpolation();
+
+    // Evictions and reloads from the memory manager land between blocks
+    for (auto& player : samplePlayers)
+    {
+        player->adoptPendingSample();
+        player->setInterpolation (quality);
+    }
+
+    // -------------------------------------------------------------------------
+    // Gather this block's hits. Queued UI / MIDI triggers play at offset 0;
+    // the sequencer's follow in ascending order, so the list is already sorted.
+    // -------------------------------------------------------------------------
+    int numEvents = 0;
+
+    {
+        const auto scope = triggerFifo.read (triggerFifo.getNumReady());
+
+        for (int i = 0; i < scope.blockSize1; ++i)
+            blockEvents[(size_t) numEvents++] = triggerQueue[(size_t) (scope.startIndex1 + i)];
+
+        for (int i = 0; i < scope.blockSize2; ++i)
+            blockEvents[(size_t) numEvents++] = triggerQueue[(size_t) (scope.startIndex2 + i)];
+    }
+
+    numEvents += sequencer.renderEvents (numSamples,
+                                         blockEvents.data() + numEvents,
+                                         kMaxEventsPerBlock - numEvents);
+
+    // -------------------------------------------------------------------------
+    // Idle: no hit, no voice, no filter ringing, and the reverb has been fed
+    // silence for as long as its IR — past that, convolving zeros gives
+    // zeros. The hits are drained and the sequencer has moved on, so
+    // skipping the rest loses nothing.
+    // -------------------------------------------------------------------------
+    const bool active = numEvents > 0
+                         || std::any_of (samplePlayers.begin(), samplePlayers.end(),
+                                         [] (const auto& player) { return player->isPlaying(); })
+                         || (separatePads && toneBank.isRinging());
+
+    if (active)
+    {
+        reverbTailLeft = useReverb ? reverb.getTailSamples() : 0;
+    }
+    else
+    {
+        if (! useReverb || reverbTailLeft == 0)
+        {
+            // Nothing left in the convolution to fade out
+            reverbRunning  = reverbRunning && wantReverb;
+            reverbTailLeft = 0;
+            return false;
+        }
+
+        reverbTailLeft = juce::jmax (0, reverbTailLeft - numSamples);
+    }
+
+    AT_TRACE_SCOPE_VALUE ("Drum render", numSamples);
+
+    mixBuffer.clear (0, numSamples);
+
+    if (useReverb)
+        sendBuffer.clear (0, numSamples);
+
+    if (separatePads)
+    {
+        for (auto& padBuffer : padBuffers)
+            padBuffer.clear (0, numSamples);
+
+        activePadMask = 0;
+    }
+
+    // The governor's level may have changed since the last block
+    enforceVoiceLimit();
+
+    // -------------------------------------------------------------------------
+    // Render between events, starting each voice on its exact sample
+    // -------------------------------------------------------------------------
+    int position = 0;
+
+    for (int i = 0; i < numEvents; ++i)
+    {
+        const auto& event = blockEvents[(size_t) i];
+
+        if (event.sampleOffset > position)
+        {
+            renderVoices (position, event.sampleOffset - position, useReverb, separatePads);
+            position = event.sampleOffset;
+        }
+
+        // Pad tune plus the hit's own transposition, as a playback-rate ratio
+        const float semitones = padTunes[(size_t) event.pad].load() + event.semitones;
+        samplePlayers[(size_t) event.pad]->trigger (std::exp2 ((double) semitones / 12.0));
+        enforceVoiceLimit();
+
+        AT_TRACE_FLOW_END ("Pad hit", event.traceId);
+    }
+
+    if (position < numSamples)
+        renderVoices (position, numSamples - position, useReverb, separatePads);
+
+    if (separatePads)
+        mixPadBuffers (toneBank.process (padBuffers, activePadMask, numSamples), numSamples, useReverb);
+
+    if (useReverb)
+    {
+        reverb.process (sendBuffer, numSamples);
+
+        const float returnLevel = reverbReturn.load();
+        const float startGain   = returnLevel * reverbFade.getCurrentValue();
+        const float endGain     = returnLevel * reverbFade.skip (numSamples);
+
+        for (int channel = 0; channel < 2; ++channel)
+            mixBuffer.addFromWithRamp (channel, 0, sendBuffer.getReadPointer (channel), numSamples, startGain, endGain);
+
+        // Faded out: stop convolving from the next block
+        if (! wantReverb && ! reverbFade.isSmoothing())
+            reverbRunning = false;
+    }
+
+    return true;
+}
+
+void DrumEngine::renderVoices (int offset, int numSamples, bool withSends, bool separatePads)
+{
+    for (int i = 0; i < kNumPads; ++i)
+    {
+        auto& player = *samplePlayers[(size_t) i];
+
+        if (separatePads)
+        {
+            // Sends are applied after filtering, in mixPadBuffers()
+            if (player.isPlaying())
+                activePadMask |= 1u << i;
+
+            player.renderNextBlock (padBuffers[(size_t) i], offset, numSamples);
+        }
+        else
+        {
+            player.renderNextBlock (mixBuffer, offset, numSamples,
+                                    withSends ? &sendBuffer : nullptr,
+                                    sendLevels[(size_t) i].load());
+        }
+    }
+}
+
+void DrumEngine::mixPadBuffers (std::uint32_t padsWithOutput, int numSamples, bool withSends)
+{
+    for (int i = 0; i < kNumPads; ++i)
+    {
+        if ((padsWithOutput & (1u << i)) == 0)
+            continue;
+
+        const float sendLevel = sendLevels[(size_t) i].load();
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            mixBuffer.addFrom (channel, 0, padBuffers[(size_t) i], channel, 0, numSamples);
+
+            if (withSends && sendLevel > 0.0f)
+                sendBuffer.addFrom (channel, 0, padBuffers[(size_t) i], channel, 0, numSamples, sendLevel);
+        }
+    }
+}
+
+void DrumEngine::enforceVoiceLimit()
+{
+    if (governor == nullptr)
+        return;
+
+    const int limit = governor->getVoiceLimit (kNumPads);
+
+    // Voices already fading out are on their way and don't count
+    int numActive = 0;
+
+    for (auto& player : samplePlayers)
+        if (player->isPlaying() && ! player->isReleasing())
+            ++numActive;
+
+    // -------------------------------------------------------------------------
+    // CONCEPT: Voice stealing. Over the limit, fade out whichever voice is
+    // quietest right now — usually a tail nobody can hear any more.
+    // -------------------------------------------------------------------------
+    while (numActive > limit)
+    {
+        SamplePlayer* quietest = nullptr;
+
+        for (auto& player : samplePlayers)
+            if (player->isPlaying() && ! player->isReleasing()
+                && (quietest == nullptr || player->getCurrentLevel() < quietest->getCurrentLevel()))
+                quietest = player.get();
+
+        if (quietest == nullptr)
+            break;
+
+        quietest->fastRelease();
+        --numActive;
+    }
+}
+
+void DrumEngine::releaseResources()
+{
+    for (auto& player : samplePlayers)
+        player->releaseResources();
+
+    // A restart begins from silence, not from whatever was ringing at the stop
+    reverb.reset();
+    reverbRunning  = false;
+    reverbTailLeft = 0;
+}
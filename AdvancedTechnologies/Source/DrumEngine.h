@@ -0,0 +1,212 @@
+/*
+  ==============================================================================
+    DrumEngine.h
+    The drum half of the DSP core: 16 SamplePlayers plus the step sequencer,
+    mixed into one AudioSource, with a convolution reverb on a send bus.
+
+    CONCEPT: Keeping the audio engine separate from the GUI means the same
+             class can be driven by the standalone app (via an
+             AudioSourcePlayer) or by a plugin host (via EngineProcessor),
+             without either one knowing about buttons or windows.
+
+    CONCEPT: Every hit is an event with a sample offset inside the block.
+             renderNextBlock() renders all voices up to the next event,
+             starts that voice, and carries on — so a sequencer step lands on
+             the exact sample it was scheduled for.
+
+    A BusSource: once no pad is playing, no filter is ringing and the
+    reverb's tail has played out, blocks are skipped — the trigger queue
+    and the sequencer still run, so the next hit lands where it should.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "BusMixer.h"
+#include "SamplePlayer.h"
+#include "StepSequencer.h"
+#include "LoadGovernor.h"
+#include "SendReverb.h"
+#include "PadToneBank.h"
+#include "LockedArena.h"
+#include "SampleMemoryManager.h"
+
+class DrumEngine : public BusSource
+{
+public:
+    static constexpr int kNumPads = 16;
+
+    DrumEngine();
+    ~DrumEngine() override;
+
+    // Loads pad_0 … pad_15 from the given folder, as .wav, .flac, .ogg or
+    // .aif(f). Missing files leave that pad silent. Compressed files are
+    // decoded once and then loaded from the SampleCache on later runs.
+    // Call before playback starts (message thread).
+    // A reverb_ir.wav in the same folder replaces the built-in room.
+    void loadSamples (const juce::File& samplesDir);
+
+    // The two halves of loadSamples(). Each pad's player is independent, so
+    // different pads may be loaded on different threads at the same time —
+    // still before playback starts. Returns false if the file is missing
+    // or can't be read.
+    bool loadPad (int padIndex, const juce::File& samplesDir);
+    void loadReverb (const juce::File& samplesDir);
+
+    // Queues a pad hit for the start of the next block, transposed by
+    // semitones on top of the pad's tune. Any thread may call it (UI, MIDI
+    // input, the latency harness, the plugin's processBlock): writers take a
+    // SpinLock among themselves for the few instructions of the push, and
+    // the audio thread reads the queue without it.
+    void triggerPad (int padIndex, float semitones = 0.0f);
+
+    // Returns the pad mapped to this MIDI note, or -1 if none. In chromatic
+    // mode every note maps to the chromatic pad.
+    int getPadForNote (int note) const;
+
+    // Transposition for a note: note - kChromaticRootNote in chromatic mode,
+    // otherwise 0
+    float getSemitonesForNote (int note) const;
+
+    //--------------------------------------------------------------------------
+    // Tuning (any thread)
+    //--------------------------------------------------------------------------
+    static constexpr float kMaxTuneSemitones  = 24.0f;
+    static constexpr int   kChromaticRootNote = 60;   // C3 plays the pad at its own tune
+
+    // Semitones, fractional part = cents / 100. Clamped to ±kMaxTuneSemitones.
+    void  setPadTune (int padIndex, float semitones);
+    float getPadTune (int padIndex) const;
+
+    // Plays one pad across the keyboard, -1 = off (notes map to pads)
+    void setChromaticPad (int padIndex);
+    int  getChromaticPad() const              { return chromaticPad.load(); }
+
+    void setInterpolation (SamplePlayer::Interpolation quality) { interpolation.store ((int) quality); }
+    SamplePlayer::Interpolation getInterpolation() const
+    {
+        return (SamplePlayer::Interpolation) interpolation.load();
+    }
+
+    StepSequencer& getSequencer() { return sequencer; }
+    SendReverb&    getReverb()    { return reverb; }
+    PadToneBank&   getToneBank()  { return toneBank; }
+
+    // Reverb send per pad and the bus return level, 0..1 (any thread)
+    void  setSendLevel (int padIndex, float level);
+    float getSendLevel (int padIndex) const;
+    void  setReverbReturn (float level)     { reverbReturn.store (level); }
+    float getReverbReturn() const           { return reverbReturn.load(); }
+
+    // -------------------------------------------------------------------------
+    // Sample memory. The pads are one kit of the process-wide
+    // SampleMemoryManager, named after the folder they were loaded from.
+    // -------------------------------------------------------------------------
+    SampleMemoryManager& getMemoryManager()         { return *memoryManager; }
+    size_t getPadMemoryBytes (int padIndex) const;
+    bool   isPadEvicted (int padIndex) const;
+
+    // Live sampling (see LiveSampler and SamplePlayer::reserveCapture()). The
+    // reservation and its release on the message thread, when a pad is armed
+    // and disarmed; the take itself on the audio thread, streamed into the
+    // reservation as it comes in. The pad picks a finished take up at the
+    // start of its next block.
+    void reservePadCapture (int padIndex, int numChannels, int maxFrames);
+    void releasePadCapture (int padIndex);
+    bool beginPadCapture (int padIndex, double sampleRate);
+    int  appendPadCapture (int padIndex, const float* const* input, int numInputs, int start, int count);
+    bool finishPadCapture (int padIndex, int numFrames, int fadeFrames);
+    bool abortPadCapture (int padIndex);
+
+    // Performance mode: samples and mix buffers are allocated from the arena,
+    // and the engine's own state is locked into RAM. Call before loadSamples()
+    // (message thread); the arena must outlive the engine.
+    void setArena (LockedArena* newArena);
+
+    // When set, the number of sounding pads is capped by the governor's
+    // current level; the quietest voices are faded out first.
+    void setGovernor (LoadGovernor* newGovernor) { governor = newGovernor; }
+
+    // AudioSource interface
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+
+protected:
+    bool renderBus (const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+private:
+    // Renders one slice into mixBuffer; false if the engine was idle and
+    // skipped it
+    bool renderBlock (int numSamples);
+    void renderVoices (int offset, int numSamples, bool withSends, bool separatePads);
+    void mixPadBuffers (std::uint32_t padsWithOutput, int numSamples, bool withSends);
+    void enforceVoiceLimit();
+
+    // pad_<index> with the first extension that exists, or File() if none
+    static juce::File findPadFile (const juce::File& samplesDir, int padIndex);
+
+    void registerKit (const juce::String& name);
+
+    std::array<std::unique_ptr<SamplePlayer>, kNumPads> samplePlayers;
+
+    // MIDI note numbers assigned to each pad (C2 … D#3 by default)
+    std::array<int, kNumPads> padNotes;
+
+    std::array<std::atomic<float>, kNumPads> padTunes;
+    std::atomic<int>                         chromaticPad  { -1 };
+    std::atomic<int>                         interpolation { (int) SamplePlayer::Interpolation::cubic };
+
+    StepSequencer sequencer;
+    LoadGovernor* governor = nullptr;
+    LockedArena*  arena    = nullptr;
+    SampleCache   sampleCache;
+
+    juce::SharedResourcePointer<SampleMemoryManager> memoryManager;
+
+    // -------------------------------------------------------------------------
+    // Voices mix into mixBuffer (dry) and sendBuffer (reverb bus), both stereo
+    // and sized in prepareToPlay. Blocks longer than that are rendered in
+    // slices so the audio thread never allocates.
+    // -------------------------------------------------------------------------
+    SendReverb                                    reverb;
+    juce::AudioBuffer<float>                      mixBuffer;
+    juce::AudioBuffer<float>                      sendBuffer;
+    int                                           maxBlockSize = 0;
+    std::array<std::atomic<float>, kNumPads>      sendLevels;
+    std::atomic<float>                            reverbReturn { 0.3f };
+    int                                           reverbTailLeft = 0;   // samples still ringing out
+
+    // Return fade when the governor switches the reverb off (audio thread)
+    static constexpr double                       kReverbFadeSeconds = 0.005;
+    juce::LinearSmoothedValue<float>              reverbFade { 0.0f };
+    bool                                          reverbRunning = false;
+
+    // -------------------------------------------------------------------------
+    // Per-pad filter / EQ. Only when some pad is not flat do voices render
+    // into their own padBuffers, get filtered together, and then get mixed.
+    // -------------------------------------------------------------------------
+    PadToneBank                                          toneBank;
+    std::array<juce::AudioBuffer<float>, kNumPads>       padBuffers;
+    std::uint32_t                                        activePadMask = 0;
+
+    // Storage behind the buffers above when they come from the arena
+    std::unique_ptr<LockedArena::Block>                           mixMemory, sendMemory;
+    std::array<std::unique_ptr<LockedArena::Block>, kNumPads>     padMemory;
+
+    // -------------------------------------------------------------------------
+    // CONCEPT: AbstractFifo manages the read/write positions of a ring buffer
+    // that we allocate up front. Nothing allocates. It is single-producer,
+    // single-consumer, so the several producers share triggerWriteLock;
+    // popping (audio thread only) never locks.
+    // -------------------------------------------------------------------------
+    static constexpr int kTriggerQueueSize = 64;
+    juce::SpinLock                                        triggerWriteLock;
+    juce::AbstractFifo                                    triggerFifo { kTriggerQueueSize };
+    std::array<StepSequencer::Event, kTriggerQueueSize>   triggerQueue {};
+
+    // Scratch list of this block's hits, sized for the worst case up front
+    static constexpr int kMaxEventsPerBlock = 512;
+    std::array<StepSequencer::Event, kMaxEventsPerBlock> blockEvents {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DrumEngine)
+};
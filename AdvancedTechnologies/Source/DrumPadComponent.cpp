@@ -5,6 +5,7 @@
 */
 
 #include "DrumPadComponent.h"
+#include "Trace.h"
 
 //==============================================================================
 // PadButton
@@ -66,71 +67,390 @@ void PadButton::highlight (bool shouldHighlight)
 // DrumPadComponent
 //==============================================================================
 
-DrumPadComponent::DrumPadComponent (juce::AudioDeviceManager& dm)
-    : deviceManager (dm)
+DrumPadComponent::DrumPadComponent (juce::AudioDeviceManager& dm, BusMixer& mix,
+                                    LoadGovernor& governor, const juce::File& samplesDir, LockedArena* arena)
+    : deviceManager (dm),
+      masterMix (mix),
+      meteredEngine (governor, engine)
 {
-    // -------------------------------------------------------------------------
-    // Assign MIDI notes: start from C2 (MIDI note 36) going chromatically
-    // -------------------------------------------------------------------------
-    for (int i = 0; i < kNumPads; ++i)
-        padNotes[i] = 36 + i;
+    // Under CPU pressure the governor caps how many pads can ring at once
+    engine.setGovernor (&governor);
+    engine.setArena (arena);
 
     // -------------------------------------------------------------------------
-    // Create pads and sample players
+    // Create pads
     // -------------------------------------------------------------------------
-    juce::File samplesDir = juce::File::getSpecialLocation (
-                                juce::File::currentExecutableFile)
-                            .getParentDirectory()
-                            .getChildFile ("Samples");
-
     for (int i = 0; i < kNumPads; ++i)
     {
-        // Create the pad button
         pads[i] = std::make_unique<PadButton> (i);
         const int padIndex = i; // capture by value
-        pads[i]->onTriggered = [this, padIndex] { triggerPad (padIndex); };
+        pads[i]->onTriggered = [this, padIndex]
+        {
+            triggerPad (padIndex);
+            selectPad (padIndex);
+        };
         addAndMakeVisible (*pads[i]);
+    }
 
-        // Create and load the sample player
-        samplePlayers[i] = std::make_unique<SamplePlayer>();
+    addAndMakeVisible (sequencerPanel);
 
-        auto sampleFile = samplesDir.getChildFile ("pad_" + juce::String (i) + ".wav");
-        if (sampleFile.existsAsFile())
-        {
-            samplePlayers[i]->loadSample (sampleFile);
-            // Add its AudioSource to the mixer
-            mixer.addInputSource (samplePlayers[i]->getAudioSource(), false);
-        }
-        else
-        {
-            // No sample file — pad will produce silence but still light up
-            DBG ("SamplePlayer " << i << ": file not found: " << sampleFile.getFullPathName());
-        }
+    // -------------------------------------------------------------------------
+    // Reverb send / return sliders
+    // -------------------------------------------------------------------------
+    for (auto* slider : { &sendSlider, &returnSlider })
+    {
+        slider->setSliderStyle (juce::Slider::LinearHorizontal);
+        slider->setTextBoxStyle (juce::Slider::TextBoxRight, false, 50, 20);
+        slider->setRange (0.0, 1.0, 0.01);
+        addAndMakeVisible (*slider);
+    }
+
+    sendSlider.onValueChange   = [this] { engine.setSendLevel (selectedPad, (float) sendSlider.getValue()); };
+    returnSlider.setValue (engine.getReverbReturn(), juce::dontSendNotification);
+    returnSlider.onValueChange = [this] { engine.setReverbReturn ((float) returnSlider.getValue()); };
+
+    for (auto* label : { &sendLabel, &returnLabel })
+    {
+        label->setFont (juce::Font (13.0f));
+        label->setColour (juce::Label::textColourId, juce::Colours::white.withAlpha (0.7f));
+        addAndMakeVisible (*label);
     }
 
     // -------------------------------------------------------------------------
-    // CONCEPT: AudioSourcePlayer wraps our mixer as an AudioIODeviceCallback
-    // and handles the prepareToPlay/releaseResources lifecycle automatically.
+    // Tone row: LinearBar sliders show their value inside the bar, which
+    // keeps five controls readable in one line
     // -------------------------------------------------------------------------
-    audioSourcePlayer.setSource (&mixer);
-    deviceManager.addAudioCallback (&audioSourcePlayer);
+    filterTypeBox.addItem ("Filter off", 1);
+    filterTypeBox.addItem ("Low-pass",   2);
+    filterTypeBox.addItem ("High-pass",  3);
+    filterTypeBox.onChange = [this] { toneChanged(); };
+    addAndMakeVisible (filterTypeBox);
+
+    cutoffSlider.setRange (20.0, 20000.0, 1.0);
+    cutoffSlider.setSkewFactorFromMidPoint (1000.0);
+    cutoffSlider.setTextValueSuffix (" Hz");
+    resonanceSlider.setRange (0.3, 8.0, 0.01);
+    resonanceSlider.setTextValueSuffix (" Q");
+    eqFreqSlider.setRange (40.0, 16000.0, 1.0);
+    eqFreqSlider.setSkewFactorFromMidPoint (1000.0);
+    eqFreqSlider.setTextValueSuffix (" Hz EQ");
+    eqGainSlider.setRange (-18.0, 18.0, 0.1);
+    eqGainSlider.setTextValueSuffix (" dB");
+
+    for (auto* slider : { &cutoffSlider, &resonanceSlider, &eqFreqSlider, &eqGainSlider })
+    {
+        slider->setSliderStyle (juce::Slider::LinearBar);
+        slider->onValueChange = [this] { toneChanged(); };
+        addAndMakeVisible (*slider);
+    }
 
+    // -------------------------------------------------------------------------
+    // Tune row
+    // -------------------------------------------------------------------------
+    semitoneSlider.setRange (-DrumEngine::kMaxTuneSemitones, DrumEngine::kMaxTuneSemitones, 1.0);
+    semitoneSlider.setTextValueSuffix (" st");
+    centsSlider.setRange (-99.0, 99.0, 1.0);
+    centsSlider.setTextValueSuffix (" ct");
+
+    for (auto* slider : { &semitoneSlider, &centsSlider })
+    {
+        slider->setSliderStyle (juce::Slider::LinearBar);
+        slider->onValueChange = [this] { tuneChanged(); };
+        addAndMakeVisible (*slider);
+    }
+
+    chromaticButton.onClick = [this]
+    {
+        engine.setChromaticPad (chromaticButton.getToggleState() ? selectedPad : -1);
+    };
+    addAndMakeVisible (chromaticButton);
+
+    qualityBox.addItem ("Linear interpolation", 1 + (int) SamplePlayer::Interpolation::linear);
+    qualityBox.addItem ("Cubic interpolation",  1 + (int) SamplePlayer::Interpolation::cubic);
+    qualityBox.addItem ("Sinc interpolation",   1 + (int) SamplePlayer::Interpolation::sinc);
+    qualityBox.setSelectedId (1 + (int) engine.getInterpolation(), juce::dontSendNotification);
+    qualityBox.onChange = [this]
+    {
+        engine.setInterpolation ((SamplePlayer::Interpolation) (qualityBox.getSelectedId() - 1));
+    };
+    addAndMakeVisible (qualityBox);
+
+    // -------------------------------------------------------------------------
+    // Memory row. The budget belongs to the process-wide manager, so the box
+    // starts from whatever it is set to now.
+    // -------------------------------------------------------------------------
+    const std::pair<const char*, size_t> budgets[] =
+    {
+        { "Memory: no limit", 0 },
+        { "Memory: 256 MB",   (size_t) 256 << 20 },
+        { "Memory: 512 MB",   (size_t) 512 << 20 },
+        { "Memory: 1 GB",     (size_t) 1 << 30 },
+        { "Memory: 2 GB",     (size_t) 2 << 30 },
+        { "Memory: 4 GB",     (size_t) 4 << 30 }
+    };
+
+    auto& memoryManager = engine.getMemoryManager();
+    const auto defaultBudget = SampleMemoryManager::getDefaultBudget();
+
+    memoryBudgetBox.addItem ("Memory: 1/4 of RAM (" + juce::File::descriptionOfSizeInBytes ((juce::int64) defaultBudget) + ")", 1);
+
+    for (int i = 0; i < (int) std::size (budgets); ++i)
+        memoryBudgetBox.addItem (budgets[i].first, i + 2);
+
+    memoryBudgetBox.setSelectedId (1, juce::dontSendNotification);
+
+    if (const auto budget = memoryManager.getBudget(); budget != defaultBudget)
+        for (int i = 0; i < (int) std::size (budgets); ++i)
+            if (budget == budgets[i].second)
+                memoryBudgetBox.setSelectedId (i + 2, juce::dontSendNotification);
+
+    memoryBudgetBox.onChange = [this, budgets, defaultBudget]
+    {
+        const int index = memoryBudgetBox.getSelectedId() - 2;
+        engine.getMemoryManager().setBudget (index >= 0 ? budgets[index].second : defaultBudget);
+    };
+    addAndMakeVisible (memoryBudgetBox);
+
+    // -------------------------------------------------------------------------
+    // Sampling row
+    // -------------------------------------------------------------------------
+    armButton.setClickingTogglesState (true);
+    armButton.setColour (juce::TextButton::buttonOnColourId, juce::Colours::darkred);
+    armButton.onClick = [this] { toggleArm(); };
+    addAndMakeVisible (armButton);
+
+    thresholdSlider.setSliderStyle (juce::Slider::LinearBar);
+    thresholdSlider.setRange (-60.0, 0.0, 1.0);
+    thresholdSlider.setTextValueSuffix (" dB threshold");
+    thresholdSlider.setValue (liveSampler.getThresholdDb(), juce::dontSendNotification);
+    thresholdSlider.onValueChange = [this] { liveSampler.setThresholdDb ((float) thresholdSlider.getValue()); };
+    addAndMakeVisible (thresholdSlider);
+
+    for (auto* label : { &memoryLabel, &samplerLabel })
+    {
+        label->setFont (juce::Font (13.0f));
+        label->setColour (juce::Label::textColourId, juce::Colours::white.withAlpha (0.7f));
+        addAndMakeVisible (*label);
+    }
+
+    selectPad (0);
+
+    // -------------------------------------------------------------------------
+    // One job per pad. The last one to finish hands over to the message
+    // thread; SafePointer makes that a no-op if the page has gone by then.
+    // -------------------------------------------------------------------------
+    engine.loadReverb (samplesDir);
+
+    for (int i = 0; i < kNumPads; ++i)
+    {
+        loaderPool.addJob ([this, i, samplesDir, safeThis = juce::Component::SafePointer<DrumPadComponent> (this)]
+        {
+            engine.loadPad (i, samplesDir);
+
+            if (--padsLeftToLoad == 0)
+                juce::MessageManager::callAsync ([safeThis]
+                {
+                    if (safeThis != nullptr)
+                        safeThis->samplesReady();
+                });
+        });
+    }
+
+    startTimerHz (10);
+    setSize (700, 592);
+}
+
+void DrumPadComponent::connectMidiInputs()
+{
     // -------------------------------------------------------------------------
     // CONCEPT: addMidiInputDeviceCallback registers us for MIDI events on ALL
     // available MIDI inputs. The empty string "" means "all devices".
     // handleIncomingMidiMessage() will be called on a background MIDI thread.
     // -------------------------------------------------------------------------
     deviceManager.addMidiInputDeviceCallback ({}, this);
+    deviceManagerFree = true;
+}
 
-    setSize (700, 450);
+void DrumPadComponent::timerCallback()
+{
+    updateSamplerStatus();
+    updateMemoryStatus();
+}
+
+void DrumPadComponent::toggleArm()
+{
+    if (! armButton.getToggleState())
+    {
+        liveSampler.disarm();
+        return;
+    }
+
+    if (! liveSampler.hasInput())
+    {
+        armButton.setToggleState (false, juce::dontSendNotification);
+        requestInputAndArm();
+        return;
+    }
+
+    if (! liveSampler.arm (selectedPad))
+        armButton.setToggleState (false, juce::dontSendNotification);
+
+    updateSamplerStatus();
+}
+
+void DrumPadComponent::requestInputAndArm()
+{
+    if (! deviceManagerFree || inputRequested)
+        return;
+
+    inputRequested = true;
+
+    juce::RuntimePermissions::request (juce::RuntimePermissions::recordAudio,
+                                       [safeThis = juce::Component::SafePointer<DrumPadComponent> (this)] (bool granted)
+    {
+        if (safeThis == nullptr)
+            return;
+
+        auto& page = *safeThis;
+        page.inputRequested = false;
+        page.inputError     = granted ? page.openAudioInput() : "Microphone access was denied";
+
+        if (page.inputError.isEmpty() && page.liveSampler.arm (page.selectedPad))
+            page.armButton.setToggleState (true, juce::dontSendNotification);
+
+        page.updateSamplerStatus();
+    });
+}
+
+juce::String DrumPadComponent::openAudioInput()
+{
+    const auto previous = deviceManager.getAudioDeviceSetup();
+    auto setup = previous;
+
+    if (deviceManager.getCurrentAudioDevice() == nullptr)
+        return "No audio device";
+
+    // Output-only so far: pick the backend's default input
+    if (setup.inputDeviceName.isEmpty())
+    {
+        auto* type = deviceManager.getCurrentDeviceTypeObject();
+        const auto names = type != nullptr ? type->getDeviceNames (true) : juce::StringArray();
+
+        if (names.isEmpty())
+            return "No audio input";
+
+        setup.inputDeviceName = names[juce::jmax (0, type->getDefaultDeviceIndex (true))];
+    }
+
+    setup.useDefaultInputChannels = false;
+    setup.inputChannels.clear();
+    setup.inputChannels.setRange (0, LiveSampler::kMaxChannels, true);
+
+    // The device restarts with the input, and the sampler sizes itself for it
+    const auto error = deviceManager.setAudioDeviceSetup (setup, true);
+
+    if (error.isNotEmpty() || ! liveSampler.hasInput())
+    {
+        // A failed open closes the device; put the output back as it was
+        deviceManager.setAudioDeviceSetup (previous, true);
+        return error.isNotEmpty() ? "Can't open the input: " + error : "No audio input";
+    }
+
+    return {};
+}
+
+void DrumPadComponent::updateSamplerStatus()
+{
+    const auto padName = [] (int padIndex) { return "pad " + juce::String (padIndex + 1); };
+    const auto state   = liveSampler.getState();
+
+    // A take has landed (or the sampler gave up): the button pops back out
+    if (state == LiveSampler::State::idle && armButton.getToggleState())
+        armButton.setToggleState (false, juce::dontSendNotification);
+
+    juce::String text;
+
+    if (! liveSampler.hasInput() && inputError.isNotEmpty())
+        text = inputError;
+    else if (state == LiveSampler::State::armed)
+        text = "Armed " + padName (liveSampler.getArmedPad()) + ", waiting for a hit";
+    else if (state == LiveSampler::State::recording)
+        text = "Recording " + padName (liveSampler.getArmedPad()) + "...";
+    else if (liveSampler.getNumTakes() > 0)
+        text = liveSampler.didLastTakeLand()
+                 ? juce::String (liveSampler.getLastTakeSeconds(), 2) + " s take on " + padName (liveSampler.getLastTakePad())
+                 : "The last take was dropped; arm again";
+    else
+        text = "Arm a pad to record its next hit from the input";
+
+    if (liveSampler.hasInput())
+        text << "   Input " << juce::String (juce::Decibels::gainToDecibels (liveSampler.getInputPeak()), 0) << " dB";
+
+    samplerLabel.setText (text, juce::dontSendNotification);
+}
+
+void DrumPadComponent::updateMemoryStatus()
+{
+    const auto describe = [] (size_t numBytes) { return juce::File::descriptionOfSizeInBytes ((juce::int64) numBytes); };
+
+    auto& memoryManager = engine.getMemoryManager();
+    const auto kits     = memoryManager.getKitStats();
+
+    size_t total = 0;
+
+    for (const auto& kit : kits)
+        total += kit.bytes;
+
+    juce::String text;
+    text << "Pad " << (selectedPad + 1) << ": " << describe (engine.getPadMemoryBytes (selectedPad))
+         << (engine.isPadEvicted (selectedPad) ? " (head only)" : "");
+
+    for (const auto& kit : kits)
+        if (kit.kit == &engine)
+            text << "   Kit: " << describe (kit.bytes) << ", " << kit.numEvicted << " of " << kit.numLoaded << " evicted";
+
+    text << "   All " << (int) kits.size() << (kits.size() == 1 ? " kit: " : " kits: ") << describe (total);
+
+    if (const auto budget = memoryManager.getBudget(); budget > 0)
+        text << " of " << describe (budget);
+
+    memoryLabel.setText (text, juce::dontSendNotification);
+}
+
+void DrumPadComponent::samplesReady()
+{
+    samplesLoaded = true;
+
+    // -------------------------------------------------------------------------
+    // CONCEPT: BusMixer sums every page into the master bus (skipping the
+    // idle ones) and handles the prepareToPlay/releaseResources lifecycle.
+    // Nothing reads the players until this point, so the loader threads
+    // never race the audio thread.
+    // -------------------------------------------------------------------------
+    masterMix.addInputSource (&meteredEngine);
+
+    if (onSamplesLoaded)
+        onSamplesLoaded();
+}
+
+juce::File DrumPadComponent::getDefaultSamplesDirectory()
+{
+    return juce::File::getSpecialLocation (juce::File::currentExecutableFile)
+               .getParentDirectory()
+               .getChildFile ("Samples");
 }
 
 DrumPadComponent::~DrumPadComponent()
 {
+    stopTimer();
+
     // Always deregister callbacks before the object is destroyed
     deviceManager.removeMidiInputDeviceCallback ({}, this);
-    deviceManager.removeAudioCallback (&audioSourcePlayer);
-    audioSourcePlayer.setSource (nullptr);
+    masterMix.removeInputSource (&meteredEngine);
+
+    // Closed straight after opening: let any pad still decoding finish
+    // (the pool's own destructor would give up after a few seconds)
+    loaderPool.removeAllJobs (true, -1);
 }
 
 void DrumPadComponent::paint (juce::Graphics& g)
@@ -145,6 +465,46 @@ void DrumPadComponent::resized()
 {
     auto area = getLocalBounds().reduced (12);
 
+    sequencerPanel.setBounds (area.removeFromBottom (90));
+    area.removeFromBottom (8);
+
+    auto toneRow = area.removeFromBottom (24);
+    const int toneW = toneRow.getWidth() / 5;
+    filterTypeBox.setBounds   (toneRow.removeFromLeft (toneW).reduced (2, 0));
+    cutoffSlider.setBounds    (toneRow.removeFromLeft (toneW).reduced (2, 0));
+    resonanceSlider.setBounds (toneRow.removeFromLeft (toneW).reduced (2, 0));
+    eqFreqSlider.setBounds    (toneRow.removeFromLeft (toneW).reduced (2, 0));
+    eqGainSlider.setBounds    (toneRow.reduced (2, 0));
+    area.removeFromBottom (8);
+
+    auto tuneRow = area.removeFromBottom (24);
+    const int tuneW = tuneRow.getWidth() / 4;
+    semitoneSlider.setBounds  (tuneRow.removeFromLeft (tuneW).reduced (2, 0));
+    centsSlider.setBounds     (tuneRow.removeFromLeft (tuneW).reduced (2, 0));
+    chromaticButton.setBounds (tuneRow.removeFromLeft (tuneW).reduced (2, 0));
+    qualityBox.setBounds      (tuneRow.reduced (2, 0));
+    area.removeFromBottom (8);
+
+    auto samplerRow = area.removeFromBottom (24);
+    armButton.setBounds (samplerRow.removeFromLeft (80).reduced (2, 0));
+    thresholdSlider.setBounds (samplerRow.removeFromLeft (200).reduced (2, 0));
+    samplerLabel.setBounds (samplerRow.reduced (4, 0));
+    area.removeFromBottom (8);
+
+    auto memoryRow = area.removeFromBottom (24);
+    memoryBudgetBox.setBounds (memoryRow.removeFromLeft (200).reduced (2, 0));
+    memoryLabel.setBounds (memoryRow.reduced (4, 0));
+    area.removeFromBottom (8);
+
+    auto reverbRow = area.removeFromBottom (24);
+    const int halfW = reverbRow.getWidth() / 2;
+    auto sendArea = reverbRow.removeFromLeft (halfW);
+    sendLabel.setBounds (sendArea.removeFromLeft (130));
+    sendSlider.setBounds (sendArea.reduced (4, 0));
+    returnLabel.setBounds (reverbRow.removeFromLeft (100));
+    returnSlider.setBounds (reverbRow.reduced (4, 0));
+    area.removeFromBottom (8);
+
     const int cols   = 4;
     const int rows   = 4;
     const int padW   = area.getWidth()  / cols;
@@ -168,42 +528,92 @@ void DrumPadComponent::handleIncomingMidiMessage (juce::MidiInput* /*source*/,
 {
     // -------------------------------------------------------------------------
     // CONCEPT: isNoteOn() checks the status byte (0x9n) and velocity > 0.
-    // We look up which pad this note belongs to using our padNotes map.
+    // The engine looks up which pad this note belongs to, and how far to
+    // transpose it in chromatic mode.
     // -------------------------------------------------------------------------
     if (! message.isNoteOn())
         return;
 
-    const int note = message.getNoteNumber();
+    AT_TRACE_SCOPE_VALUE ("Drum MIDI note-on", message.getNoteNumber());
 
-    for (int i = 0; i < kNumPads; ++i)
+    const int   padIndex  = engine.getPadForNote (message.getNoteNumber());
+    const float semitones = engine.getSemitonesForNote (message.getNoteNumber());
+
+    if (padIndex < 0)
+        return;
+
+    // Follows this hit through callAsync to the block that renders it
+    const auto traceId = Trace::newFlowId();
+    AT_TRACE_FLOW_BEGIN ("Pad hit", traceId);
+
+    // -------------------------------------------------------------------------
+    // CONCEPT: We MUST NOT update UI from the MIDI thread.
+    // callAsync() posts a lambda to the message thread safely.
+    // -------------------------------------------------------------------------
+    juce::MessageManager::callAsync ([this, padIndex, semitones, traceId]
     {
-        if (padNotes[i] == note)
+        AT_TRACE_SCOPE_VALUE ("Drum pad trigger", padIndex);
+        AT_TRACE_FLOW_STEP ("Pad hit", traceId);
+        juce::ignoreUnused (traceId);
+
+        triggerPad (padIndex, semitones);
+
+        // Visual flash: highlight briefly then restore
+        pads[padIndex]->highlight (true);
+        juce::Timer::callAfterDelay (80, [this, padIndex]
         {
-            // ---------------------------------------------------------------
-            // CONCEPT: We MUST NOT update UI from the MIDI thread.
-            // callAsync() posts a lambda to the message thread safely.
-            // ---------------------------------------------------------------
-            const int padIndex = i;
-            juce::MessageManager::callAsync ([this, padIndex]
-            {
-                triggerPad (padIndex);
-
-                // Visual flash: highlight briefly then restore
-                pads[padIndex]->highlight (true);
-                juce::Timer::callAfterDelay (80, [this, padIndex]
-                {
-                    if (padIndex < kNumPads && pads[padIndex] != nullptr)
-                        pads[padIndex]->highlight (false);
-                });
-            });
+            if (padIndex < kNumPads && pads[padIndex] != nullptr)
+                pads[padIndex]->highlight (false);
+        });
+    });
+}
 
-            break;
-        }
-    }
+void DrumPadComponent::triggerPad (int padIndex, float semitones)
+{
+    // Hits queued now would all play at once when the engine starts
+    if (! samplesLoaded)
+        return;
+
+    engine.triggerPad (padIndex, semitones);
+}
+
+void DrumPadComponent::selectPad (int padIndex)
+{
+    selectedPad = padIndex;
+    sequencerPanel.setSelectedPad (padIndex);
+
+    sendLabel.setText ("Reverb send (pad " + juce::String (padIndex + 1) + ")", juce::dontSendNotification);
+    sendSlider.setValue (engine.getSendLevel (padIndex), juce::dontSendNotification);
+
+    const auto tone = engine.getToneBank().getTone (padIndex);
+    filterTypeBox.setSelectedId ((int) tone.filterType + 1, juce::dontSendNotification);
+    cutoffSlider.setValue    (tone.cutoffHz,  juce::dontSendNotification);
+    resonanceSlider.setValue (tone.resonance, juce::dontSendNotification);
+    eqFreqSlider.setValue    (tone.eqFreqHz,  juce::dontSendNotification);
+    eqGainSlider.setValue    (tone.eqGainDb,  juce::dontSendNotification);
+
+    // Whole semitones and the cents left over, both with the tune's sign
+    const float tune      = engine.getPadTune (padIndex);
+    const float semitones = std::trunc (tune);
+    semitoneSlider.setValue (semitones, juce::dontSendNotification);
+    centsSlider.setValue    (std::round ((tune - semitones) * 100.0f), juce::dontSendNotification);
+
+    chromaticButton.setToggleState (engine.getChromaticPad() == padIndex, juce::dontSendNotification);
+}
+
+void DrumPadComponent::toneChanged()
+{
+    PadToneBank::PadTone tone;
+    tone.filterType = (PadToneBank::FilterType) juce::jmax (0, filterTypeBox.getSelectedId() - 1);
+    tone.cutoffHz   = (float) cutoffSlider.getValue();
+    tone.resonance  = (float) resonanceSlider.getValue();
+    tone.eqFreqHz   = (float) eqFreqSlider.getValue();
+    tone.eqGainDb   = (float) eqGainSlider.getValue();
+
+    engine.getToneBank().setTone (selectedPad, tone);
 }
 
-void DrumPadComponent::triggerPad (int padIndex)
+void DrumPadComponent::tuneChanged()
 {
-    if (padIndex >= 0 && padIndex < kNumPads && samplePlayers[padIndex] != nullptr)
-        samplePlayers[padIndex]->trigger();
+    engine.setPadTune (selectedPad, (float) (semitoneSlider.getValue() + centsSlider.getValue() / 100.0));
 }
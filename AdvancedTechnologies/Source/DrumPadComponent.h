@@ -5,16 +5,30 @@
       - Highlights on mouse click and triggers its sample
       - Lights up and plays when a MIDI note-on is received on that pad's note
       - Loads pad_0.wav … pad_15.wav from the Samples/ folder next to the app
+    Below the grid, a step sequencer strip edits the pattern for the last
+    clicked pad, the tone row sets that pad's filter and EQ, the tune row
+    its pitch (and whether MIDI plays it chromatically), and the reverb
+    sliders set its send and the shared return level. The memory row sets
+    the sample memory budget and shows what the pads, this kit and every
+    loaded kit use. The sampling row arms the selected pad to record its
+    next hit from the audio input.
 
     CONCEPT: MidiInputCallback::handleIncomingMidiMessage() is called on a
              background MIDI thread — we must NOT do audio work or UI updates
              directly. We post to the message thread via MessageManager.
+
+    CONCEPT: The samples are decoded on a small thread pool, several pads at
+             once, so the page appears before its audio is ready. The engine
+             joins the master bus only when every pad has loaded; until then
+             the pads light up but stay silent.
   ==============================================================================
 */
 
 #pragma once
 #include <JuceHeader.h>
-#include "SamplePlayer.h"
+#include "DrumEngine.h"
+#include "StepSequencerComponent.h"
+#include "LiveSampler.h"
 
 //==============================================================================
 // A single pad button — a coloured square that highlights when active
@@ -42,12 +56,40 @@ private:
 
 //==============================================================================
 class DrumPadComponent : public juce::Component,
-                         public juce::MidiInputCallback  // ← MIDI thread callback
+                         public juce::MidiInputCallback,  // ← MIDI thread callback
+                         private juce::Timer
 {
 public:
-    explicit DrumPadComponent (juce::AudioDeviceManager& deviceManager);
+    // The drums are added to masterMix, which must outlive this page. With an
+    // arena (performance mode) samples are loaded into locked memory.
+    DrumPadComponent (juce::AudioDeviceManager& deviceManager, BusMixer& masterMix,
+                      LoadGovernor& governor,
+                      const juce::File& samplesDir = getDefaultSamplesDirectory(),
+                      LockedArena* arena = nullptr);
     ~DrumPadComponent() override;
 
+    // Samples/ next to the app
+    static juce::File getDefaultSamplesDirectory();
+
+    // True once the samples have loaded and the drums are on the master bus
+    bool areSamplesLoaded() const { return samplesLoaded; }
+
+    // Called on the message thread when the samples have loaded
+    std::function<void()> onSamplesLoaded;
+
+    // Starts taking MIDI from every input. The device manager isn't thread
+    // safe, so the owner calls this once nothing else is using it (after
+    // DeviceOpener has finished), not from the constructor. From then on
+    // the page may also open the audio input, on the first arm.
+    void connectMidiInputs();
+
+    // Records input into the pads. The owner adds it to the device manager
+    // once the device is open, before the callback that plays the drums.
+    LiveSampler& getLiveSampler()   { return liveSampler; }
+
+    // The sequencer's tempo, which the synth's synced LFOs follow
+    double getTempo()               { return engine.getSequencer().getTempo(); }
+
     void paint  (juce::Graphics& g) override;
     void resized() override;
 
@@ -59,25 +101,87 @@ private:
                                     const juce::MidiMessage& message) override;
 
     // Called when a pad should fire (from either mouse or MIDI)
-    void triggerPad (int padIndex);
+    void triggerPad (int padIndex, float semitones = 0.0f);
 
-    juce::AudioDeviceManager& deviceManager;
+    // Makes this pad the one the sequencer strip and send slider edit
+    void selectPad (int padIndex);
+
+    // Sends the tone controls' values to the selected pad
+    void toneChanged();
+
+    // Sends the tune sliders' value to the selected pad
+    void tuneChanged();
+
+    // Every pad has loaded: start playing (message thread)
+    void samplesReady();
+
+    // Refreshes the memory statistics and the sampler's status
+    void timerCallback() override;
+    void updateMemoryStatus();
+    void updateSamplerStatus();
+
+    // Arms or disarms the selected pad for live sampling
+    void toggleArm();
 
     // -------------------------------------------------------------------------
-    // CONCEPT: MixerAudioSource lets us play multiple samples simultaneously
-    // by mixing their outputs before sending to the device.
+    // The device opens output-only, so launching never needs the microphone.
+    // The first arm asks for permission (macOS shows its prompt), then adds
+    // the default input to the running device; the pad is armed once that
+    // has worked. Denied or missing, the output carries on as it was.
     // -------------------------------------------------------------------------
-    juce::MixerAudioSource            mixer;
-    juce::AudioSourcePlayer           audioSourcePlayer;
+    void requestInputAndArm();
+    juce::String openAudioInput();      // an error message, or empty
 
-    static constexpr int kNumPads = 16;
+    bool         deviceManagerFree = false;   // set by connectMidiInputs()
+    bool         inputRequested    = false;   // a permission request is out
+    juce::String inputError;
 
-    // 16 pads and 16 sample players
-    std::array<std::unique_ptr<PadButton>,    kNumPads> pads;
-    std::array<std::unique_ptr<SamplePlayer>, kNumPads> samplePlayers;
+    juce::AudioDeviceManager& deviceManager;
+    BusMixer&                 masterMix;
+
+    // The sample players and mixer live in the shared DSP core
+    DrumEngine                        engine;
+    LoadGovernor::MeteredSource       meteredEngine;
+    LiveSampler                       liveSampler { engine };
+
+    static constexpr int kNumPads = DrumEngine::kNumPads;
+
+    std::array<std::unique_ptr<PadButton>, kNumPads> pads;
+
+    StepSequencerComponent sequencerPanel { engine.getSequencer() };
+
+    // Reverb send for the selected pad, and the bus return
+    int          selectedPad = 0;
+    juce::Slider sendSlider;
+    juce::Slider returnSlider;
+    juce::Label  sendLabel;
+    juce::Label  returnLabel { {}, "Reverb return" };
 
-    // MIDI note numbers assigned to each pad (C2 … D#3 by default)
-    std::array<int, kNumPads> padNotes;
+    // Filter / EQ for the selected pad
+    juce::ComboBox filterTypeBox;
+    juce::Slider   cutoffSlider, resonanceSlider, eqFreqSlider, eqGainSlider;
+
+    // Tune for the selected pad; interpolation quality for all pads
+    juce::Slider       semitoneSlider, centsSlider;
+    juce::ToggleButton chromaticButton { "Play chromatically" };
+    juce::ComboBox     qualityBox;
+
+    // Sample memory budget (shared by every kit) and usage
+    juce::ComboBox memoryBudgetBox;
+    juce::Label    memoryLabel;
+
+    // Live sampling into the selected pad
+    juce::TextButton armButton { "Arm" };
+    juce::Slider     thresholdSlider;
+    juce::Label      samplerLabel;
+
+    // -------------------------------------------------------------------------
+    // Background loading. Declared last so the pool is destroyed — and its
+    // jobs finished — before the engine they write into.
+    // -------------------------------------------------------------------------
+    bool             samplesLoaded = false;
+    std::atomic<int> padsLeftToLoad { kNumPads };
+    juce::ThreadPool loaderPool { juce::jlimit (1, 4, juce::SystemStats::getNumCpus() - 1) };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DrumPadComponent)
 };
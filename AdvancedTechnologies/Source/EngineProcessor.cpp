@@ -0,0 +1,228 @@
+/*
+  ==============================================================================
+    EngineProcessor.cpp
+  ==============================================================================
+*/
+
+#include "EngineProcessor.h"
+#include "Trace.h"
+
+EngineProcessor::EngineProcessor()
+    : AudioProcessor (BusesProperties()
+                          .withOutput ("Output", juce::AudioChannelSet::stereo(), true)),
+      apvts (*this, nullptr, "SynthState", SynthAudioSource::createParameterLayout()),
+      synth (apvts)
+{
+    drums.setGovernor (&governor);
+    synth.setGovernor (&governor);
+    synth.setConstantLatency (true);
+
+    apvts.addParameterListener ("oversampling", this);
+
+    // -------------------------------------------------------------------------
+    // CONCEPT: In a plugin, currentExecutableFile is the plugin binary itself,
+    // not the host, so Samples/ is looked up next to the .so.
+    // -------------------------------------------------------------------------
+    loadSamples (juce::File::getSpecialLocation (juce::File::currentExecutableFile)
+                     .getParentDirectory()
+                     .getChildFile ("Samples"));
+}
+
+EngineProcessor::~EngineProcessor()
+{
+    apvts.removeParameterListener ("oversampling", this);
+    cancelPendingUpdate();
+}
+
+void EngineProcessor::loadSamples (const juce::File& samplesDir)
+{
+    // Loading rewrites the sample buffers, so keep the audio thread out meanwhile
+    const juce::ScopedLock sl (getCallbackLock());
+    drums.loadSamples (samplesDir);
+}
+
+//==============================================================================
+void EngineProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+{
+    currentSampleRate = sampleRate;
+
+    synth.prepareToPlay (samplesPerBlock, sampleRate);
+    drums.prepareToPlay (samplesPerBlock, sampleRate);
+    updateLatency();
+
+    // Allocate here, never in processBlock
+    drumBuffer.setSize (getTotalNumOutputChannels(), samplesPerBlock);
+
+    drumDelay.setMaximumDelayInSamples (juce::roundToInt (synth.getMaximumLatencySamples()) + 1);
+    drumDelay.prepare ({ sampleRate, (juce::uint32) juce::jmax (1, samplesPerBlock), 2 });
+    drumsWereSounding = false;
+}
+
+void EngineProcessor::parameterChanged (const juce::String&, float)
+{
+    triggerAsyncUpdate();
+}
+
+void EngineProcessor::handleAsyncUpdate()
+{
+    updateLatency();
+}
+
+void EngineProcessor::updateLatency()
+{
+    // Hosts take whole samples; the stage is built with integer latency.
+    // The worst case for the factor, whether or not the drive is on.
+    const int latency = juce::roundToInt (synth.getLatencySamples());
+
+    if (latency != getLatencySamples())
+        setLatencySamples (latency);
+}
+
+void EngineProcessor::releaseResources()
+{
+    synth.releaseResources();
+    drums.releaseResources();
+}
+
+bool EngineProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+    const auto& out = layouts.getMainOutputChannelSet();
+    return out == juce::AudioChannelSet::mono() || out == juce::AudioChannelSet::stereo();
+}
+
+void EngineProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi)
+{
+    juce::ScopedNoDenormals noDenormals;
+    AT_TRACE_SCOPE_VALUE ("processBlock", buffer.getNumSamples());
+
+    const int numSamples = buffer.getNumSamples();
+    const LoadGovernor::ScopedMeasurement measurement (governor, governorMeter, numSamples, currentSampleRate);
+
+    // Hosts may exceed the block size promised in prepareToPlay
+    if (drumBuffer.getNumSamples() < numSamples
+        || drumBuffer.getNumChannels() < buffer.getNumChannels())
+        drumBuffer.setSize (buffer.getNumChannels(), numSamples, false, false, true);
+
+    // Follow the host's tempo when it has one: the sequencer and the synced LFOs
+    if (auto* playHead = getPlayHead())
+    {
+        if (auto hostPosition = playHead->getPosition())
+        {
+            if (auto bpm = hostPosition->getBpm())
+            {
+                drums.getSequencer().setTempo (*bpm);
+                synth.setTempo (*bpm);
+            }
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // CONCEPT: Split the block at each event's sample position. Everything
+    // before the event is rendered with the old state, everything after with
+    // the new one. Events sharing a position are applied together.
+    // -------------------------------------------------------------------------
+    int position = 0;
+
+    for (const auto metadata : midi)
+    {
+        const int eventPos = juce::jlimit (0, numSamples, metadata.samplePosition);
+
+        if (eventPos > position)
+        {
+            renderSegment (buffer, position, eventPos - position);
+            position = eventPos;
+        }
+
+        handleMidiEvent (metadata.getMessage());
+    }
+
+    if (position < numSamples)
+        renderSegment (buffer, position, numSamples - position);
+}
+
+void EngineProcessor::renderSegment (juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    // -------------------------------------------------------------------------
+    // An idle engine skips its block and leaves the buffer alone: the synth
+    // renders straight into the host's buffer, and the drums are added to
+    // it (or copied, or nothing written but a clear) to match
+    // -------------------------------------------------------------------------
+    const bool synthSounding = synth.renderNextBlock (juce::AudioSourceChannelInfo (&buffer, startSample, numSamples));
+    const bool drumsSounding = drums.renderNextBlock (juce::AudioSourceChannelInfo (&drumBuffer, startSample, numSamples));
+
+    // -------------------------------------------------------------------------
+    // The drums are late by the synth's latency as well. An idle drum bus
+    // has played out its tail, so the delay restarts from silence after it.
+    // -------------------------------------------------------------------------
+    if (drumsSounding)
+    {
+        if (! drumsWereSounding)
+            drumDelay.reset();
+
+        const float latency = synth.getLatencySamples();
+
+        for (int channel = 0; channel < juce::jmin (2, drumBuffer.getNumChannels()); ++channel)
+        {
+            auto* samples = drumBuffer.getWritePointer (channel, startSample);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                drumDelay.pushSample (channel, samples[i]);
+                samples[i] = drumDelay.popSample (channel, latency);
+            }
+        }
+    }
+
+    drumsWereSounding = drumsSounding;
+
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        if (drumsSounding && synthSounding)
+            buffer.addFrom (channel, startSample, drumBuffer, channel, startSample, numSamples);
+        else if (drumsSounding)
+            buffer.copyFrom (channel, startSample, drumBuffer, channel, startSample, numSamples);
+        else if (! synthSounding)
+            buffer.clear (channel, startSample, numSamples);
+    }
+}
+
+void EngineProcessor::handleMidiEvent (const juce::MidiMessage& message)
+{
+    if (message.isNoteOn())
+    {
+        const int padIndex = drums.getPadForNote (message.getNoteNumber());
+
+        if (padIndex >= 0)
+        {
+            // Queued for the start of the next segment, i.e. this event's sample
+            drums.triggerPad (padIndex, drums.getSemitonesForNote (message.getNoteNumber()));
+            return;
+        }
+    }
+    else if (message.isNoteOff() && drums.getPadForNote (message.getNoteNumber()) >= 0)
+    {
+        return; // one-shot pads ignore note-off
+    }
+
+    synth.applyMidiMessage (message);
+}
+
+//==============================================================================
+juce::AudioProcessorEditor* EngineProcessor::createEditor()
+{
+    // No custom UI: hosts get a generic slider per parameter
+    return new juce::GenericAudioProcessorEditor (*this);
+}
+
+void EngineProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    if (auto xml = apvts.copyState().createXml())
+        copyXmlToBinary (*xml, destData);
+}
+
+void EngineProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    if (auto xml = getXmlFromBinary (data, sizeInBytes))
+        if (xml->hasTagName (apvts.state.getType()))
+            apvts.replaceState (juce::ValueTree::fromXml (*xml));
+}
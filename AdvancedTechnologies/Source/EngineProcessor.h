@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+    EngineProcessor.h
+    The synth and drum engines packaged as a real AudioProcessor, so the DSP
+    core can run inside a host's audio graph (LV2 / VST3 plugin, or linked
+    directly as a headless library) instead of opening its own audio device.
+
+    CONCEPT: A host owns the buffers and the audio thread. It calls
+             processBlock() with an AudioBuffer to fill and a MidiBuffer of
+             timestamped events for that block. Each event carries a sample
+             position, so we render up to the event, apply it, and carry on —
+             notes start on the exact sample the host asked for.
+
+    MIDI behaviour:
+      - Notes mapped to a drum pad (C2 … D#3) trigger that pad
+      - All other notes play the synth, exactly like the app's Synth tab
+      - In chromatic mode (DrumEngine::setChromaticPad) every note plays
+        that pad, transposed around C3
+
+    Latency: the synth's drive stage delays it by its oversampling filters'
+    latency. The synth keeps that delay with the drive off too, and the
+    drums are delayed to match, so the whole output is late by one fixed
+    amount per Oversampling setting. That is reported to the host from
+    prepareToPlay() and, when Oversampling changes, from the message
+    thread — never from the audio thread, and never as Drive moves.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "SynthAudioSource.h"
+#include "DrumEngine.h"
+#include "LoadGovernor.h"
+
+class EngineProcessor : public juce::AudioProcessor,
+                        private juce::AudioProcessorValueTreeState::Listener,
+                        private juce::AsyncUpdater
+{
+public:
+    EngineProcessor();
+    ~EngineProcessor() override;
+
+    // Folder holding pad_0.wav … pad_15.wav. Defaults to Samples/ next to the
+    // plugin binary.
+    void loadSamples (const juce::File& samplesDir);
+
+    //--------------------------------------------------------------------------
+    // AudioProcessor interface
+    //--------------------------------------------------------------------------
+    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
+    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override                        { return true; }
+
+    const juce::String getName() const override            { return "Advanced Technologies"; }
+    bool acceptsMidi() const override                      { return true; }
+    bool producesMidi() const override                     { return false; }
+    bool isMidiEffect() const override                     { return false; }
+    double getTailLengthSeconds() const override           { return 0.0; }
+
+    int getNumPrograms() override                          { return 1; }
+    int getCurrentProgram() override                       { return 0; }
+    void setCurrentProgram (int) override                  {}
+    const juce::String getProgramName (int) override       { return {}; }
+    void changeProgramName (int, const juce::String&) override {}
+
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+
+    juce::AudioProcessorValueTreeState& getState() { return apvts; }
+    LoadGovernor& getGovernor()                     { return governor; }
+
+private:
+    // Sends one MIDI event to whichever engine owns that note
+    void handleMidiEvent (const juce::MidiMessage& message);
+
+    // Oversampling changed; hosts may call this on the audio thread, so the
+    // report is posted to the message thread
+    void parameterChanged (const juce::String& parameterID, float newValue) override;
+    void handleAsyncUpdate() override;
+
+    // Reports the latency for the current Oversampling setting to the host
+    void updateLatency();
+
+    // Renders both engines for [startSample, startSample + numSamples)
+    void renderSegment (juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+    // -------------------------------------------------------------------------
+    // Member order matters! apvts must exist before synth, which keeps a
+    // reference to it.
+    // -------------------------------------------------------------------------
+    juce::AudioProcessorValueTreeState apvts;
+    SynthAudioSource                   synth;
+    DrumEngine                         drums;
+
+    // Times each processBlock against the host's buffer period
+    LoadGovernor                       governor;
+    int                                governorMeter = governor.addMeter();
+    double                             currentSampleRate = 44100.0;
+
+    // Drums render here and are summed onto the synth output, because each
+    // AudioSource overwrites the region it is asked to fill.
+    juce::AudioBuffer<float>           drumBuffer;
+
+    // Delays the drums by the synth's latency, so they line up after PDC.
+    // Outputs are mono or stereo, so two channels always suffice.
+    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None> drumDelay;
+    bool                               drumsWereSounding = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EngineProcessor)
+};
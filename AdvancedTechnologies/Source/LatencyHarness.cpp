@@ -0,0 +1,431 @@
+/*
+  ==============================================================================
+    LatencyHarness.cpp
+  ==============================================================================
+*/
+
+#include "LatencyHarness.h"
+#include "SynthComponent.h"
+#include "DrumPadComponent.h"
+
+#include <iostream>
+
+namespace
+{
+    const juce::String kTypeName   { "Latency Harness" };
+    const juce::String kDeviceName { "Timer-driven output" };
+
+    constexpr float  kOnsetThreshold = 0.01f;
+    constexpr double kDetectTimeoutMs = 500.0;
+
+    // Sleeps most of the way, then yields, so the wake-up is accurate to
+    // well under a millisecond without burning a core
+    void waitUntilMs (double targetMs)
+    {
+        for (;;)
+        {
+            const double remaining = targetMs - juce::Time::getMillisecondCounterHiRes();
+
+            if (remaining <= 0.0)
+                return;
+
+            if (remaining > 2.0)
+                juce::Thread::sleep ((int) remaining - 1);
+            else
+                juce::Thread::yield();
+        }
+    }
+
+    int getOption (const juce::StringArray& args, const juce::String& name, int defaultValue)
+    {
+        for (const auto& arg : args)
+            if (arg.startsWith ("--" + name + "="))
+                return juce::jmax (1, arg.fromFirstOccurrenceOf ("=", false, false).getIntValue());
+
+        return defaultValue;
+    }
+}
+
+//==============================================================================
+// CONCEPT: An AudioIODevice is just something that calls
+// audioDeviceIOCallbackWithContext() once per buffer. Real devices do it when
+// the hardware needs data; this one does it from a thread paced by the
+// high-resolution clock, so it behaves like a sound card that isn't there.
+//==============================================================================
+class LatencyHarness::TimerDrivenDevice : public juce::AudioIODevice,
+                                          private juce::Thread
+{
+public:
+    TimerDrivenDevice (LatencyHarness& h, double rate, int size)
+        : AudioIODevice (kDeviceName, kTypeName),
+          Thread ("Harness audio"),
+          harness (h), sampleRate (rate), bufferSize (size)
+    {}
+
+    ~TimerDrivenDevice() override { close(); }
+
+    juce::StringArray getOutputChannelNames() override      { return { "Left", "Right" }; }
+    juce::StringArray getInputChannelNames() override       { return {}; }
+    juce::Array<double> getAvailableSampleRates() override  { return { sampleRate }; }
+    juce::Array<int> getAvailableBufferSizes() override     { return { bufferSize }; }
+    int getDefaultBufferSize() override                     { return bufferSize; }
+
+    juce::String open (const juce::BigInteger&, const juce::BigInteger&, double, int) override
+    {
+        // Rate and size were fixed by the harness; there is only one choice
+        opened = true;
+        return {};
+    }
+
+    void close() override
+    {
+        stop();
+        opened = false;
+    }
+
+    bool isOpen() override                                  { return opened; }
+
+    void start (juce::AudioIODeviceCallback* newCallback) override
+    {
+        if (newCallback == nullptr || isThreadRunning())
+            return;
+
+        newCallback->audioDeviceAboutToStart (this);
+
+        {
+            const juce::ScopedLock sl (callbackLock);
+            callback = newCallback;
+        }
+
+        startThread (juce::Thread::Priority::highest);
+    }
+
+    void stop() override
+    {
+        stopThread (1000);
+
+        juce::AudioIODeviceCallback* oldCallback = nullptr;
+
+        {
+            const juce::ScopedLock sl (callbackLock);
+            std::swap (oldCallback, callback);
+        }
+
+        if (oldCallback != nullptr)
+            oldCallback->audioDeviceStopped();
+    }
+
+    bool isPlaying() override                               { return isThreadRunning(); }
+    juce::String getLastError() override                    { return {}; }
+    int getCurrentBufferSizeSamples() override              { return bufferSize; }
+    double getCurrentSampleRate() override                  { return sampleRate; }
+    int getCurrentBitDepth() override                       { return 32; }
+    int getOutputLatencyInSamples() override                { return 0; }
+    int getInputLatencyInSamples() override                 { return 0; }
+    juce::BigInteger getActiveInputChannels() const override { return {}; }
+
+    juce::BigInteger getActiveOutputChannels() const override
+    {
+        juce::BigInteger channels;
+        channels.setRange (0, 2, true);
+        return channels;
+    }
+
+private:
+    void run() override
+    {
+        juce::AudioBuffer<float> buffer (2, bufferSize);
+        const double periodMs = 1000.0 * bufferSize / sampleRate;
+        double blockStartMs   = juce::Time::getMillisecondCounterHiRes();
+
+        while (! threadShouldExit())
+        {
+            waitUntilMs (blockStartMs);
+            buffer.clear();
+
+            {
+                const juce::ScopedLock sl (callbackLock);
+
+                if (callback != nullptr)
+                    callback->audioDeviceIOCallbackWithContext (nullptr, 0,
+                                                                buffer.getArrayOfWritePointers(), 2,
+                                                                bufferSize, {});
+            }
+
+            harness.blockRendered (buffer.getArrayOfReadPointers(), 2, bufferSize, blockStartMs);
+
+            // Advance on the ideal timeline, so a late wake-up doesn't shift
+            // every later block (just like a hardware clock)
+            blockStartMs += periodMs;
+        }
+    }
+
+    LatencyHarness& harness;
+    const double    sampleRate;
+    const int       bufferSize;
+    bool            opened = false;
+
+    juce::CriticalSection        callbackLock;
+    juce::AudioIODeviceCallback* callback = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TimerDrivenDevice)
+};
+
+//==============================================================================
+class LatencyHarness::TimerDrivenDeviceType : public juce::AudioIODeviceType
+{
+public:
+    TimerDrivenDeviceType (LatencyHarness& h, double rate, int size)
+        : AudioIODeviceType (kTypeName), harness (h), sampleRate (rate), bufferSize (size)
+    {}
+
+    void scanForDevices() override {}
+
+    juce::StringArray getDeviceNames (bool wantInputNames) const override
+    {
+        return wantInputNames ? juce::StringArray() : juce::StringArray (kDeviceName);
+    }
+
+    int getDefaultDeviceIndex (bool forInput) const override             { return forInput ? -1 : 0; }
+    int getIndexOfDevice (juce::AudioIODevice* d, bool asInput) const override { return (d != nullptr && ! asInput) ? 0 : -1; }
+    bool hasSeparateInputsAndOutputs() const override                    { return false; }
+
+    juce::AudioIODevice* createDevice (const juce::String& outputDeviceName, const juce::String&) override
+    {
+        if (outputDeviceName.isNotEmpty() && outputDeviceName != kDeviceName)
+            return nullptr;
+
+        return new TimerDrivenDevice (harness, sampleRate, bufferSize);
+    }
+
+private:
+    LatencyHarness& harness;
+    const double    sampleRate;
+    const int       bufferSize;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TimerDrivenDeviceType)
+};
+
+//==============================================================================
+LatencyHarness::LatencyHarness (const juce::String& commandLine)
+    : Thread ("Latency harness")
+{
+    const auto args = juce::StringArray::fromTokens (commandLine, true);
+
+    bufferSize = getOption (args, "buffer", bufferSize);
+    sampleRate = (double) getOption (args, "rate", (int) sampleRate);
+    numHits    = getOption (args, "hits", numHits);
+}
+
+LatencyHarness::~LatencyHarness()
+{
+    stopThread (4000);
+
+    // Pages deregister themselves in their destructors, so they must go
+    // before the master bus and the device
+    drumPadPage.reset();
+    synthPage.reset();
+    deviceManager.removeAudioCallback (&masterPlayer);
+    masterPlayer.setSource (nullptr);
+    deviceManager.closeAudioDevice();
+
+    clickSamplesDir.deleteRecursively();
+}
+
+void LatencyHarness::start (std::function<void()> onFinished)
+{
+    finishedCallback = std::move (onFinished);
+
+    // -------------------------------------------------------------------------
+    // Make our device type the only one, and open it
+    // -------------------------------------------------------------------------
+    deviceManager.addAudioDeviceType (std::make_unique<TimerDrivenDeviceType> (*this, sampleRate, bufferSize));
+    deviceManager.setCurrentAudioDeviceType (kTypeName, true);
+
+    juce::AudioDeviceManager::AudioDeviceSetup setup;
+    setup.outputDeviceName = kDeviceName;
+    setup.sampleRate       = sampleRate;
+    setup.bufferSize       = bufferSize;
+
+    const auto error = deviceManager.initialise (0, 2, nullptr, false, {}, &setup);
+
+    if (error.isNotEmpty())
+    {
+        std::cout << "Latency harness: could not open the timer-driven device: " << error << std::endl;
+        juce::MessageManager::callAsync (finishedCallback);
+        return;
+    }
+
+    // -------------------------------------------------------------------------
+    // The real pages on a master bus, exactly as the app builds them — only
+    // the drum samples are swapped for short clicks with a sharp onset
+    // -------------------------------------------------------------------------
+    masterPlayer.setSource (&masterMix);
+    deviceManager.addAudioCallback (&masterPlayer);
+
+    clickSamplesDir = createClickSamples();
+    synthPage   = std::make_unique<SynthComponent>   (deviceManager, masterMix, governor);
+    drumPadPage = std::make_unique<DrumPadComponent> (deviceManager, masterMix, governor, clickSamplesDir);
+    synthPage->connectMidiInputs();
+    drumPadPage->connectMidiInputs();
+
+    std::cout << "Latency harness: " << bufferSize << " samples @ " << sampleRate << " Hz ("
+              << juce::String (1000.0 * bufferSize / sampleRate, 2) << " ms per block), "
+              << numHits << " hits per path" << std::endl;
+
+    // The drum page loads its samples in the background; hits before then
+    // would be ignored and counted as failures
+    drumPadPage->onSamplesLoaded = [this] { startThread(); };
+}
+
+juce::File LatencyHarness::createClickSamples()
+{
+    auto dir = juce::File::getSpecialLocation (juce::File::tempDirectory)
+                   .getChildFile ("AdvancedTechnologiesLatency");
+    dir.createDirectory();
+
+    // 20 ms, 1 kHz cosine burst: starts at full level, so the onset is sample 0
+    constexpr double rate = 48000.0;
+    juce::AudioBuffer<float> click (1, (int) (rate * 0.02));
+
+    for (int i = 0; i < click.getNumSamples(); ++i)
+        click.setSample (0, i, 0.8f * (float) std::cos (juce::MathConstants<double>::twoPi * 1000.0 * i / rate));
+
+    juce::WavAudioFormat wav;
+
+    for (int pad = 0; pad < DrumEngine::kNumPads; ++pad)
+    {
+        auto file = dir.getChildFile ("pad_" + juce::String (pad) + ".wav");
+        file.deleteFile();
+
+        auto stream = file.createOutputStream();
+
+        if (stream == nullptr)
+            continue;
+
+        std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (stream.get(), rate, 1, 24, {}, 0));
+
+        if (writer != nullptr)
+        {
+            stream.release(); // the writer owns it now
+            writer->writeFromAudioSampleBuffer (click, 0, click.getNumSamples());
+        }
+    }
+
+    return dir;
+}
+
+//==============================================================================
+void LatencyHarness::run()
+{
+    juce::Thread::sleep (300); // let the device settle
+
+    const auto drumLatencies  = measurePath (static_cast<juce::MidiInputCallback&> (*drumPadPage), 36);
+    const int drumFailures    = numHits - (int) drumLatencies.size();
+
+    const auto synthLatencies = measurePath (synthPage->getMidiInputCallback(), 72);
+    const int synthFailures   = numHits - (int) synthLatencies.size();
+
+    if (threadShouldExit())
+        return;
+
+    printReport ("Drum Pad (MIDI thread -> callAsync -> DrumEngine)", drumLatencies, drumFailures);
+    printReport ("Synth (MIDI thread -> timestamped queue -> SynthAudioSource)", synthLatencies, synthFailures);
+
+    juce::MessageManager::callAsync (finishedCallback);
+}
+
+std::vector<double> LatencyHarness::measurePath (juce::MidiInputCallback& callback, int noteNumber)
+{
+    std::vector<double> latencies;
+    latencies.reserve ((size_t) numHits);
+
+    juce::Random random (noteNumber);
+
+    for (int hit = 0; hit < numHits && ! threadShouldExit(); ++hit)
+    {
+        // Wait for a few silent blocks so the previous hit can't be mistaken
+        // for this one
+        const double silenceDeadline = juce::Time::getMillisecondCounterHiRes() + 1000.0;
+
+        while (quietBlocks.load() < 4 && juce::Time::getMillisecondCounterHiRes() < silenceDeadline)
+            juce::Thread::sleep (1);
+
+        // A random gap puts each note at a different point in the block cycle
+        juce::Thread::sleep (random.nextInt ({ 10, 40 }));
+
+        detectedMs.store (-1.0);
+
+        const double injectedMs = juce::Time::getMillisecondCounterHiRes();
+        auto noteOn = juce::MidiMessage::noteOn (1, noteNumber, (juce::uint8) 100);
+        noteOn.setTimeStamp (injectedMs * 0.001);
+
+        armedAtMs.store (injectedMs);
+        callback.handleIncomingMidiMessage (nullptr, noteOn);
+
+        while (detectedMs.load() < 0.0
+               && juce::Time::getMillisecondCounterHiRes() - injectedMs < kDetectTimeoutMs
+               && ! threadShouldExit())
+            juce::Thread::sleep (1);
+
+        armedAtMs.store (-1.0);
+
+        if (const double onsetMs = detectedMs.load(); onsetMs >= 0.0)
+            latencies.push_back (onsetMs - injectedMs);
+
+        callback.handleIncomingMidiMessage (nullptr, juce::MidiMessage::noteOff (1, noteNumber));
+    }
+
+    return latencies;
+}
+
+void LatencyHarness::blockRendered (const float* const* outputs, int numChannels, int numSamples, double blockStartMs)
+{
+    int onsetIndex = -1;
+
+    for (int channel = 0; channel < numChannels && onsetIndex < 0; ++channel)
+        for (int i = 0; i < numSamples; ++i)
+            if (std::abs (outputs[channel][i]) > kOnsetThreshold)
+            {
+                onsetIndex = i;
+                break;
+            }
+
+    if (onsetIndex < 0)
+    {
+        quietBlocks.fetch_add (1);
+        return;
+    }
+
+    quietBlocks.store (0);
+
+    if (armedAtMs.load() >= 0.0 && detectedMs.load() < 0.0)
+        detectedMs.store (blockStartMs + 1000.0 * onsetIndex / sampleRate);
+}
+
+void LatencyHarness::printReport (const juce::String& name, std::vector<double> latencies, int failures)
+{
+    std::cout << std::endl << name << std::endl;
+
+    if (latencies.empty())
+    {
+        std::cout << "  no onsets detected" << std::endl;
+        return;
+    }
+
+    std::sort (latencies.begin(), latencies.end());
+
+    const auto percentile = [&latencies] (double p)
+    {
+        const auto index = (size_t) std::ceil (p * (double) latencies.size()) - 1;
+        return latencies[juce::jmin (index, latencies.size() - 1)];
+    };
+
+    const auto format = [] (double ms) { return juce::String (ms, 2).paddedLeft (' ', 8) + " ms"; };
+
+    std::cout << "  min    " << format (latencies.front()) << std::endl
+              << "  median " << format (percentile (0.5))  << std::endl
+              << "  p99    " << format (percentile (0.99)) << std::endl
+              << "  max    " << format (latencies.back())  << std::endl
+              << "  missed " << failures << " of " << (int) latencies.size() + failures << std::endl;
+}
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+    LatencyHarness.h
+    Measures MIDI-in to audio-out latency of the Drum Pad and Synth pages,
+    run with:
+
+        AdvancedTechnologies --latency-test [--buffer=256] [--rate=48000] [--hits=200]
+
+    No sound card is needed. The harness installs a "Latency Harness" audio
+    device type whose device is driven by a timer thread instead of
+    hardware, builds the real pages against it, and injects timestamped
+    note-ons straight into their MIDI callbacks. Every block the device
+    renders is scanned for the first sample above a threshold; the time of
+    that sample on the device's clock minus the injection time is one
+    latency measurement.
+
+    CONCEPT: Both paths include the wait for the next audio block, so the
+             buffer size sets a floor. The Drum Pad path also includes the
+             hop to the message thread (callAsync), so it shows how GUI load
+             adds jitter. The report does NOT include the device's own output
+             buffering, which on real hardware adds about one more buffer.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "BusMixer.h"
+#include "LoadGovernor.h"
+
+class SynthComponent;
+class DrumPadComponent;
+
+class LatencyHarness : private juce::Thread
+{
+public:
+    // Parses --buffer=, --rate= and --hits= from the command line
+    explicit LatencyHarness (const juce::String& commandLine);
+    ~LatencyHarness() override;
+
+    // Sets up the device and pages (message thread), then runs the test on
+    // a background thread. onFinished is called on the message thread.
+    void start (std::function<void()> onFinished);
+
+private:
+    class TimerDrivenDevice;
+    class TimerDrivenDeviceType;
+
+    void run() override;
+
+    // Injects one note per hit into callback and collects the latencies (ms)
+    std::vector<double> measurePath (juce::MidiInputCallback& callback, int noteNumber);
+
+    // Called from the device thread after every rendered block
+    void blockRendered (const float* const* outputs, int numChannels, int numSamples, double blockStartMs);
+
+    static void printReport (const juce::String& name, std::vector<double> latencies, int failures);
+    static juce::File createClickSamples();
+
+    double sampleRate = 48000.0;
+    int    bufferSize = 256;
+    int    numHits    = 200;
+
+    juce::AudioDeviceManager          deviceManager;
+    BusMixer                          masterMix;
+    juce::AudioSourcePlayer           masterPlayer;
+    LoadGovernor                      governor;
+    juce::File                        clickSamplesDir;
+    std::unique_ptr<SynthComponent>   synthPage;
+    std::unique_ptr<DrumPadComponent> drumPadPage;
+
+    // -------------------------------------------------------------------------
+    // Shared between the injector thread and the device thread. armedAtMs is
+    // the injection time of the note we're waiting to hear (< 0 = not armed).
+    // -------------------------------------------------------------------------
+    std::atomic<double> armedAtMs   { -1.0 };
+    std::atomic<double> detectedMs  { -1.0 };
+    std::atomic<int>    quietBlocks { 0 };
+
+    std::function<void()> finishedCallback;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LatencyHarness)
+};
@@ -0,0 +1,261 @@
+/*
+  ==============================================================================
+    LiveSampler.cpp
+  ==============================================================================
+*/
+
+#include "LiveSampler.h"
+#include "Trace.h"
+
+LiveSampler::LiveSampler (DrumEngine& e)
+    : engine (e)
+{
+}
+
+bool LiveSampler::arm (int padIndex)
+{
+    if (padIndex < 0 || padIndex >= DrumEngine::kNumPads || numChannels.load() == 0)
+        return false;
+
+    // -------------------------------------------------------------------------
+    // Back to idle first, so the audio thread can't start a take on the old
+    // pad while the reservation moves. A take already running is left to
+    // finish; the audio thread only ever leaves idle through us.
+    // -------------------------------------------------------------------------
+    int expected = (int) State::armed;
+
+    if (! state.compare_exchange_strong (expected, (int) State::idle) && expected != (int) State::idle)
+        return false;
+
+    const int previous = armedPad.exchange (padIndex);
+
+    if (previous >= 0 && previous != padIndex)
+        engine.releasePadCapture (previous);
+
+    // Allocated here, so the audio thread writes the take straight into it
+    engine.reservePadCapture (padIndex, numChannels.load(), capacity.load());
+
+    state.store ((int) State::armed);
+    return true;
+}
+
+void LiveSampler::disarm()
+{
+    // A take in progress is dropped; the pad keeps what it had
+    state.store ((int) State::idle);
+
+    // The room arm() reserved goes back, unless a take already used it
+    const int pad = armedPad.exchange (-1);
+
+    if (pad >= 0)
+        engine.releasePadCapture (pad);
+}
+
+void LiveSampler::setThresholdDb (float decibels)
+{
+    startThreshold.store (juce::Decibels::decibelsToGain (decibels));
+}
+
+//==============================================================================
+void LiveSampler::audioDeviceAboutToStart (juce::AudioIODevice* device)
+{
+    const double rate = device->getCurrentSampleRate();
+    const int    numInputs = juce::jmin (kMaxChannels, device->getActiveInputChannels().countNumberOfSetBits());
+
+    preRoll.setSize (juce::jmax (1, numInputs), juce::jmax (1, (int) (rate * kPreRollMs / 1000.0)));
+    preRoll.clear();
+
+    preRollPosition = 0;
+    preRollFilled   = 0;
+    holdFrames      = (int) (rate * kHoldMs / 1000.0);
+    fadeFrames      = juce::jmax (1, (int) (rate * kFadeOutMs / 1000.0));
+
+    sampleRate.store (rate);
+    capacity.store (juce::jmax (1, (int) (rate * kMaxSeconds)));
+    numChannels.store (numInputs);
+}
+
+void LiveSampler::audioDeviceStopped()
+{
+    numChannels.store (0);
+
+    // The callback has stopped, so a take it was writing can be dropped here
+    if (recordingPad >= 0 && engine.abortPadCapture (recordingPad))
+        recordingPad = -1;
+
+    // A pad armed before a restart reserved room for the old rate and channels
+    disarm();
+}
+
+void LiveSampler::audioDeviceIOCallbackWithContext (const float* const* inputChannelData, int numInputChannels,
+                                                    float* const* outputChannelData, int numOutputChannels,
+                                                    int numSamples,
+                                                    const juce::AudioIODeviceCallbackContext&)
+{
+    // The device manager sums every callback's output, so ours must be silence
+    for (int channel = 0; channel < numOutputChannels; ++channel)
+        if (outputChannelData[channel] != nullptr)
+            juce::FloatVectorOperations::clear (outputChannelData[channel], numSamples);
+
+    // -------------------------------------------------------------------------
+    // A take cut short by disarm() goes back to the pad to be freed. Until
+    // the pad can take it, no new take starts.
+    // -------------------------------------------------------------------------
+    if (recordingPad >= 0 && getState() != State::recording && engine.abortPadCapture (recordingPad))
+        recordingPad = -1;
+
+    const int numCaptured = juce::jmin (numInputChannels, preRoll.getNumChannels(), numChannels.load());
+
+    if (numCaptured == 0 || inputChannelData == nullptr)
+        return;
+
+    // Input peak for the meter, per block
+    float peak = 0.0f;
+
+    for (int channel = 0; channel < numCaptured; ++channel)
+        peak = juce::jmax (peak, juce::FloatVectorOperations::findMaximum (inputChannelData[channel], numSamples),
+                           -juce::FloatVectorOperations::findMinimum (inputChannelData[channel], numSamples));
+
+    inputPeak.store (peak);
+
+    const auto frameLevel = [&] (int i)
+    {
+        float level = 0.0f;
+
+        for (int channel = 0; channel < numCaptured; ++channel)
+            level = juce::jmax (level, std::abs (inputChannelData[channel][i]));
+
+        return level;
+    };
+
+    int start = 0;
+
+    if (getState() == State::armed)
+    {
+        // -------------------------------------------------------------------------
+        // Waiting: the take starts on the first frame over the threshold,
+        // with the pre-roll in front of it
+        // -------------------------------------------------------------------------
+        const float threshold = startThreshold.load();
+
+        if (peak <= threshold || recordingPad >= 0)
+        {
+            pushPreRoll (inputChannelData, numCaptured, 0, numSamples);
+            return;
+        }
+
+        while (frameLevel (start) <= threshold)
+            ++start;
+
+        pushPreRoll (inputChannelData, numCaptured, 0, start);
+
+        int expected = (int) State::armed;
+
+        if (! state.compare_exchange_strong (expected, (int) State::recording))
+            return;   // disarmed meanwhile
+
+        if (! startTake())
+            return;
+    }
+    else if (getState() != State::recording)
+    {
+        pushPreRoll (inputChannelData, numCaptured, 0, numSamples);
+        return;
+    }
+
+    AT_TRACE_SCOPE ("Live sampling");
+
+    appendToTake (inputChannelData, numCaptured, start, numSamples - start);
+
+    // -------------------------------------------------------------------------
+    // Stop once the input has stayed under the stop threshold for the hold
+    // time, or when the take is full
+    // -------------------------------------------------------------------------
+    const float stopThreshold = startThreshold.load() * juce::Decibels::decibelsToGain (-kStopBelowStartDb);
+
+    for (int i = start; i < numSamples; ++i)
+        quietFrames = frameLevel (i) > stopThreshold ? 0 : quietFrames + 1;
+
+    if (quietFrames >= holdFrames || takeLength >= capacity.load())
+        finishTake();
+}
+
+//==============================================================================
+void LiveSampler::pushPreRoll (const float* const* input, int numInputs, int start, int count)
+{
+    const int size = preRoll.getNumSamples();
+
+    // Only the last `size` frames can matter
+    if (count > size)
+    {
+        start += count - size;
+        count  = size;
+    }
+
+    const int firstPart = juce::jmin (count, size - preRollPosition);
+
+    for (int channel = 0; channel < preRoll.getNumChannels(); ++channel)
+    {
+        // Fewer inputs than expected: the last one fills the rest
+        const float* src = input[juce::jmin (channel, numInputs - 1)] + start;
+        preRoll.copyFrom (channel, preRollPosition, src, firstPart);
+        preRoll.copyFrom (channel, 0, src + firstPart, count - firstPart);
+    }
+
+    preRollPosition = (preRollPosition + count) % size;
+    preRollFilled   = juce::jmin (size, preRollFilled + count);
+}
+
+bool LiveSampler::startTake()
+{
+    recordingPad = armedPad.load();
+    quietFrames  = 0;
+    takeLength   = 0;
+
+    // Nothing reserved, or the pad hasn't picked up the last take yet
+    if (! engine.beginPadCapture (recordingPad, sampleRate.load()))
+    {
+        endTake (0, false);
+        return false;
+    }
+
+    // The ring's oldest frame is at preRollPosition once it has wrapped
+    const int size   = preRoll.getNumSamples();
+    const int oldest = (preRollPosition - preRollFilled + size) % size;
+    const int firstPart = juce::jmin (preRollFilled, size - oldest);
+
+    appendToTake (preRoll.getArrayOfReadPointers(), preRoll.getNumChannels(), oldest, firstPart);
+    appendToTake (preRoll.getArrayOfReadPointers(), preRoll.getNumChannels(), 0, preRollFilled - firstPart);
+
+    preRollFilled = 0;
+    return true;
+}
+
+void LiveSampler::appendToTake (const float* const* input, int numInputs, int start, int count)
+{
+    takeLength += engine.appendPadCapture (recordingPad, input, numInputs, start, count);
+}
+
+void LiveSampler::finishTake()
+{
+    // -------------------------------------------------------------------------
+    // Most of the hold is silence: keep a few ms of it as a fade, so the
+    // take doesn't end on a click. The pad cuts and fades it in place.
+    // -------------------------------------------------------------------------
+    const int length = juce::jmin (takeLength, takeLength - quietFrames + fadeFrames);
+
+    endTake (length, engine.finishPadCapture (recordingPad, length, fadeFrames));
+}
+
+void LiveSampler::endTake (int length, bool landed)
+{
+    lastTakePad.store (recordingPad);
+    lastTakeSeconds.store (length / sampleRate.load());
+    lastTakeLanded.store (landed);
+    numTakes.fetch_add (1);
+    recordingPad = -1;
+
+    // One take per arming
+    int expected = (int) State::recording;
+    state.compare_exchange_strong (expected, (int) State::idle);
+}
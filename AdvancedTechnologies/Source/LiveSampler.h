@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+    LiveSampler.h
+    Records a hit from the audio input straight into a drum pad.
+
+    CONCEPT: Arm a pad, play into the input, and the take starts by itself
+             when the level crosses the threshold and stops after it has
+             stayed kStopBelowStartDb under it for kHoldMs. A short ring of
+             pre-roll (kPreRollMs) is kept the whole time, so the attack
+             that crossed the threshold isn't clipped off.
+
+    CONCEPT: Everything on the audio thread is preallocated. The device's
+             start sizes the ring; arming reserves the pad's room for a take
+             of up to kMaxSeconds (SamplePlayer::reserveCapture()). Each
+             block of the take goes straight into that room, so ending it
+             only fades out the tail and hands it over, and the pad swaps it
+             in at its next block — this callback runs before the master
+             bus, so the hit is playable in the same buffer it ended in.
+             Nothing touches the disk.
+
+    Threads: arm() / disarm() / setThresholdDb() on the message thread; the
+             readings from any thread. The device callbacks as usual; add
+             this callback before the one that renders the drums.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "DrumEngine.h"
+
+class LiveSampler : public juce::AudioIODeviceCallback
+{
+public:
+    enum class State { idle = 0, armed, recording };
+
+    static constexpr double kMaxSeconds         = 10.0;
+    static constexpr double kPreRollMs          = 10.0;
+    static constexpr double kHoldMs             = 200.0;
+    static constexpr double kFadeOutMs          = 5.0;
+    static constexpr float  kDefaultThresholdDb = -30.0f;
+    static constexpr float  kStopBelowStartDb   = 12.0f;
+    static constexpr int    kMaxChannels        = 2;
+
+    explicit LiveSampler (DrumEngine& engine);
+
+    //--------------------------------------------------------------------------
+    // Message thread
+    //--------------------------------------------------------------------------
+
+    // Waits for the next hit on the input and puts it on padIndex; arming
+    // another pad moves the reservation over. Returns false if there is no
+    // input or a take is already being recorded.
+    bool arm (int padIndex);
+    void disarm();
+
+    void  setThresholdDb (float decibels);
+    float getThresholdDb() const                    { return juce::Decibels::gainToDecibels (startThreshold.load()); }
+
+    //--------------------------------------------------------------------------
+    // Any thread
+    //--------------------------------------------------------------------------
+    State  getState() const                         { return (State) state.load(); }
+    int    getArmedPad() const                      { return armedPad.load(); }
+    bool   hasInput() const                         { return numChannels.load() > 0; }
+    float  getInputPeak() const                     { return inputPeak.load(); }
+
+    // The last take: counts up with every one, so a poller can spot a new one
+    int    getNumTakes() const                      { return numTakes.load(); }
+    int    getLastTakePad() const                   { return lastTakePad.load(); }
+    double getLastTakeSeconds() const               { return lastTakeSeconds.load(); }
+    bool   didLastTakeLand() const                  { return lastTakeLanded.load(); }
+
+    //--------------------------------------------------------------------------
+    // AudioIODeviceCallback interface
+    //--------------------------------------------------------------------------
+    void audioDeviceIOCallbackWithContext (const float* const* inputChannelData, int numInputChannels,
+                                           float* const* outputChannelData, int numOutputChannels,
+                                           int numSamples,
+                                           const juce::AudioIODeviceCallbackContext& context) override;
+    void audioDeviceAboutToStart (juce::AudioIODevice* device) override;
+    void audioDeviceStopped() override;
+
+private:
+    // Audio thread
+    void pushPreRoll (const float* const* input, int numInputs, int start, int count);
+    bool startTake();
+    void appendToTake (const float* const* input, int numInputs, int start, int count);
+    void finishTake();
+    void endTake (int length, bool landed);
+
+    DrumEngine& engine;
+
+    // -------------------------------------------------------------------------
+    // Sized in audioDeviceAboutToStart(); the audio thread's alone after that
+    // -------------------------------------------------------------------------
+    juce::AudioBuffer<float> preRoll;
+    int                      preRollPosition = 0;
+    int                      preRollFilled   = 0;
+    int                      takeLength      = 0;
+    int                      quietFrames     = 0;
+    int                      holdFrames      = 0;
+    int                      fadeFrames      = 0;
+    int                      recordingPad    = -1;   // while the pad holds our take
+
+    // -------------------------------------------------------------------------
+    // Shared
+    // -------------------------------------------------------------------------
+    std::atomic<int>    state          { (int) State::idle };
+    std::atomic<int>    armedPad       { -1 };
+    std::atomic<int>    numChannels    { 0 };     // captured; 0 = no input
+    std::atomic<int>    capacity       { 0 };     // frames in a take
+    std::atomic<double> sampleRate     { 0.0 };
+    std::atomic<float>  startThreshold { juce::Decibels::decibelsToGain (kDefaultThresholdDb) };
+    std::atomic<float>  inputPeak      { 0.0f };
+
+    std::atomic<int>    numTakes        { 0 };
+    std::atomic<int>    lastTakePad     { -1 };
+    std::atomic<double> lastTakeSeconds { 0.0 };
+    std::atomic<bool>   lastTakeLanded  { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LiveSampler)
+};
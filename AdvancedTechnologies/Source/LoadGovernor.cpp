@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+    LoadGovernor.cpp
+  ==============================================================================
+*/
+
+#include "LoadGovernor.h"
+
+LoadGovernor::LoadGovernor()
+{
+    for (auto& load : meterLoads)
+        load.store (0.0f);
+
+    setSettings ({});
+}
+
+void LoadGovernor::setSettings (const Settings& s)
+{
+    reduceThreshold.store       (s.reduceThreshold);
+    criticalThreshold.store     (juce::jmax (s.reduceThreshold, s.criticalThreshold));
+    restoreThreshold.store      (juce::jmin (s.reduceThreshold, s.restoreThreshold));
+    restoreHoldSeconds.store    (s.restoreHoldSeconds);
+    reducedVoiceFraction.store  (s.reducedVoiceFraction);
+    criticalVoiceFraction.store (s.criticalVoiceFraction);
+}
+
+int LoadGovernor::addMeter()
+{
+    const int index = numMeters.load();
+    jassert (index < kMaxMeters);
+
+    numMeters.store (juce::jmin (index + 1, kMaxMeters));
+    return juce::jmin (index, kMaxMeters - 1);
+}
+
+float LoadGovernor::getLoad() const
+{
+    float total = 0.0f;
+
+    for (int i = 0; i < numMeters.load(); ++i)
+        total += meterLoads[(size_t) i].load();
+
+    return total;
+}
+
+int LoadGovernor::getVoiceLimit (int fullPolyphony) const
+{
+    switch (getLevel())
+    {
+        case Level::reduced:  return juce::jmax (1, juce::roundToInt ((float) fullPolyphony * reducedVoiceFraction.load()));
+        case Level::critical: return juce::jmax (1, juce::roundToInt ((float) fullPolyphony * criticalVoiceFraction.load()));
+        case Level::normal:
+        default:              return fullPolyphony;
+    }
+}
+
+//==============================================================================
+void LoadGovernor::addMeasurement (int meterIndex, double seconds, int numSamples, double sampleRate)
+{
+    if (numSamples <= 0 || sampleRate <= 0.0 || meterIndex < 0 || meterIndex >= kMaxMeters)
+        return;
+
+    const auto period  = (double) numSamples / sampleRate;
+    const auto instant = (float) (seconds / period);
+
+    // -------------------------------------------------------------------------
+    // CONCEPT: Asymmetric smoothing. A spike should register straight away
+    // (we may be one block from an xrun) but a single quiet block should not
+    // convince us the danger has passed.
+    // -------------------------------------------------------------------------
+    auto& slot = meterLoads[(size_t) meterIndex];
+    const float previous = slot.load();
+    const float coeff    = instant > previous ? 0.5f : 0.05f;
+    slot.store (previous + coeff * (instant - previous));
+
+    updateLevel (numSamples, sampleRate);
+}
+
+void LoadGovernor::updateLevel (int numSamples, double sampleRate)
+{
+    const float load = getLoad();
+    auto current     = getLevel();
+
+    // A compare-exchange, so a concurrent takePeakLoad() can't be undone
+    for (auto peak = peakLoad.load(); load > peak && ! peakLoad.compare_exchange_weak (peak, load);) {}
+
+    if (load >= criticalThreshold.load())
+    {
+        current = Level::critical;
+        secondsBelowRestore = 0.0;
+    }
+    else if (load >= reduceThreshold.load() && current == Level::normal)
+    {
+        current = Level::reduced;
+        secondsBelowRestore = 0.0;
+    }
+    else if (current != Level::normal && load < restoreThreshold.load())
+    {
+        // Every meter reports once per device callback, so share the time out
+        secondsBelowRestore += (double) numSamples / sampleRate / (double) juce::jmax (1, numMeters.load());
+
+        if (secondsBelowRestore >= restoreHoldSeconds.load())
+        {
+            // Step down one level at a time
+            current = current == Level::critical ? Level::reduced : Level::normal;
+            secondsBelowRestore = 0.0;
+        }
+    }
+    else
+    {
+        secondsBelowRestore = 0.0;
+    }
+
+    level.store ((int) current);
+}
+
+//==============================================================================
+LoadGovernor::MeteredSource::MeteredSource (LoadGovernor& g, BusSource& s)
+    : governor (g), source (s), meterIndex (g.addMeter())
+{
+}
+
+void LoadGovernor::MeteredSource::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
+{
+    currentSampleRate = sampleRate;
+    source.prepareToPlay (samplesPerBlockExpected, sampleRate);
+}
+
+bool LoadGovernor::MeteredSource::renderBus (const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    const ScopedMeasurement measurement (governor, meterIndex, bufferToFill.numSamples, currentSampleRate);
+    return source.renderNextBlock (bufferToFill);
+}
+
+void LoadGovernor::MeteredSource::releaseResources()
+{
+    source.releaseResources();
+}
@@ -0,0 +1,144 @@
+/*
+  ==============================================================================
+    LoadGovernor.h
+    Watches how long each audio callback takes compared with the time the
+    buffer represents, and tells the engines to shed work when the machine
+    is overloaded — and to take it back once there is headroom again.
+
+    CONCEPT: A 512-sample buffer at 48 kHz lasts 10.7 ms. If rendering it
+             takes 9 ms we are at 84% load; past 100% the device runs dry and
+             we get an audible dropout (xrun). Cutting the quietest drum tail
+             or an optional effect BEFORE that happens is far less noticeable.
+
+    Levels:
+      - normal   : everything on
+      - reduced  : load crossed reduceThreshold — polyphony scaled down,
+                   optional processing dropped
+      - critical : load crossed criticalThreshold — polyphony scaled further
+    Levels rise immediately but only fall after the load has stayed below
+    restoreThreshold for restoreHoldSeconds, so we don't flap on and off.
+
+    Threads: measurements and level changes happen on the audio thread.
+             All meters must report from the same audio thread (true for the
+             app, where the device manager runs every callback in turn, and
+             for a plugin's processBlock). Settings and readings are atomics.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "BusMixer.h"
+
+class LoadGovernor
+{
+public:
+    enum class Level { normal = 0, reduced, critical };
+
+    struct Settings
+    {
+        float reduceThreshold    = 0.70f;   // proportion of the buffer period
+        float criticalThreshold  = 0.85f;
+        float restoreThreshold   = 0.50f;
+        float restoreHoldSeconds = 2.0f;
+
+        float reducedVoiceFraction  = 0.5f; // of full polyphony
+        float criticalVoiceFraction = 0.25f;
+    };
+
+    LoadGovernor();
+
+    //--------------------------------------------------------------------------
+    // Setup (message thread)
+    //--------------------------------------------------------------------------
+    void setSettings (const Settings& newSettings);
+
+    // Each separately-timed render path (e.g. one per AudioSourcePlayer)
+    // gets its own meter. Their loads are summed.
+    int addMeter();
+
+    //--------------------------------------------------------------------------
+    // Audio thread
+    //--------------------------------------------------------------------------
+    void addMeasurement (int meterIndex, double seconds, int numSamples, double sampleRate);
+
+    // RAII timer for one render call
+    struct ScopedMeasurement
+    {
+        ScopedMeasurement (LoadGovernor& g, int meter, int samples, double rate)
+            : governor (g), meterIndex (meter), numSamples (samples), sampleRate (rate),
+              startTicks (juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedMeasurement()
+        {
+            const auto elapsed = juce::Time::highResolutionTicksToSeconds (
+                                     juce::Time::getHighResolutionTicks() - startTicks);
+            governor.addMeasurement (meterIndex, elapsed, numSamples, sampleRate);
+        }
+
+        LoadGovernor& governor;
+        const int     meterIndex, numSamples;
+        const double  sampleRate;
+        const juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedMeasurement)
+    };
+
+    //--------------------------------------------------------------------------
+    // Queries (any thread)
+    //--------------------------------------------------------------------------
+    Level getLevel() const              { return (Level) level.load(); }
+    float getLoad() const;              // smoothed total, 1.0 = 100%
+
+    // The highest total load since the previous call, then starts again.
+    // Lets a slow poller (the buffer-size tuner) see spikes between polls.
+    float takePeakLoad()                { return peakLoad.exchange (0.0f); }
+
+    // How many of fullPolyphony voices may sound at the current level
+    int getVoiceLimit (int fullPolyphony) const;
+
+    // Optional stages (effects, extra quality) should bypass when false
+    bool allowsOptionalProcessing() const { return getLevel() == Level::normal; }
+
+    //--------------------------------------------------------------------------
+    // Wraps a bus so every block it renders is timed against a meter. Use
+    // it between the master BusMixer and the engine; a skipped block stays
+    // skipped.
+    //--------------------------------------------------------------------------
+    class MeteredSource : public BusSource
+    {
+    public:
+        MeteredSource (LoadGovernor& governor, BusSource& source);
+
+        void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
+        void releaseResources() override;
+
+    protected:
+        bool renderBus (const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+    private:
+        LoadGovernor&      governor;
+        BusSource&         source;
+        const int          meterIndex;
+        double             currentSampleRate = 44100.0;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MeteredSource)
+    };
+
+private:
+    void updateLevel (int numSamples, double sampleRate);
+
+    static constexpr int kMaxMeters = 4;
+    std::array<std::atomic<float>, kMaxMeters> meterLoads;
+    std::atomic<int> numMeters { 0 };
+
+    std::atomic<float> reduceThreshold, criticalThreshold, restoreThreshold, restoreHoldSeconds;
+    std::atomic<float> reducedVoiceFraction, criticalVoiceFraction;
+
+    std::atomic<int>   level    { (int) Level::normal };
+    std::atomic<float> peakLoad { 0.0f };
+
+    // Audio thread only
+    double secondsBelowRestore = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoadGovernor)
+};
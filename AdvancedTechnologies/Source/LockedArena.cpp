@@ -0,0 +1,211 @@
+/*
+  ==============================================================================
+    LockedArena.cpp
+  ==============================================================================
+*/
+
+#include "LockedArena.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if JUCE_LINUX
+ #include <sys/mman.h>
+ #include <sys/resource.h>
+ #include <unistd.h>
+#endif
+
+LockedArena::Block::Block (LockedArena& owner, void* d, size_t s, bool m, bool l)
+    : arena (owner), data (d), size (s), mapped (m), locked (l)
+{
+}
+
+LockedArena::Block::~Block()
+{
+    arena.blockReleased (*this);
+
+   #if JUCE_LINUX
+    if (mapped)
+    {
+        // munmap drops the lock along with the mapping
+        munmap (data, size);
+        return;
+    }
+   #endif
+
+    std::free (data);
+}
+
+LockedArena::~LockedArena()
+{
+   #if JUCE_LINUX
+    for (const auto& object : lockedObjects)
+        munlock (object.first, object.second);
+   #endif
+}
+
+//==============================================================================
+std::unique_ptr<LockedArena::Block> LockedArena::allocate (size_t numBytes)
+{
+    const auto pageSize = getPageSize();
+    const auto size     = ((juce::jmax ((size_t) 1, numBytes) + pageSize - 1) / pageSize) * pageSize;
+
+   #if JUCE_LINUX
+    // -------------------------------------------------------------------------
+    // CONCEPT: An anonymous mapping is page-aligned and zeroed, and belongs to
+    // nobody else — so locking it can't drag neighbouring heap objects in
+    // with it, and unmapping it gives the pages straight back to the kernel.
+    // mlock() faults every page in before it returns.
+    // -------------------------------------------------------------------------
+    void* data = mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (data != MAP_FAILED)
+    {
+        const bool locked    = mlock (data, size) == 0;
+        const int  lockError = errno; // before anything else can overwrite it
+
+        if (! locked)
+        {
+            recordFailure ("mlock of " + juce::File::descriptionOfSizeInBytes ((juce::int64) size), lockError);
+            prefault (data, size);
+        }
+
+        {
+            const juce::ScopedLock sl (statsLock);
+            (locked ? lockedBytes : unlockedBytes) += size;
+        }
+
+        return std::unique_ptr<Block> (new Block (*this, data, size, true, locked));
+    }
+
+    const int mapError = errno;
+    recordFailure ("mmap of " + juce::File::descriptionOfSizeInBytes ((juce::int64) size), mapError);
+   #else
+    recordFailure ("memory locking is only implemented on Linux", 0);
+   #endif
+
+    void* heapData = std::calloc (size, 1);
+
+    if (heapData == nullptr)
+        return nullptr;
+
+    prefault (heapData, size);
+
+    {
+        const juce::ScopedLock sl (statsLock);
+        unlockedBytes += size;
+    }
+
+    return std::unique_ptr<Block> (new Block (*this, heapData, size, false, false));
+}
+
+std::unique_ptr<LockedArena::Block> LockedArena::allocateBuffer (LockedArena* arena, juce::AudioBuffer<float>& buffer,
+                                                                 int numChannels, int numSamples)
+{
+    if (arena == nullptr || numChannels <= 0 || numSamples <= 0)
+    {
+        // A fresh buffer, so it can't still be referring to an old block
+        buffer = juce::AudioBuffer<float> (juce::jmax (0, numChannels), juce::jmax (0, numSamples));
+        buffer.clear();
+        return nullptr;
+    }
+
+    auto block = arena->allocate (sizeof (float) * (size_t) numChannels * (size_t) numSamples);
+
+    if (block == nullptr)
+    {
+        buffer = juce::AudioBuffer<float> (numChannels, numSamples);
+        buffer.clear();
+        return nullptr;
+    }
+
+    // Channels are laid out one after another; the block is already zeroed
+    std::vector<float*> channels ((size_t) numChannels);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        channels[(size_t) channel] = static_cast<float*> (block->getData()) + (size_t) channel * (size_t) numSamples;
+
+    buffer.setDataToReferTo (channels.data(), numChannels, numSamples);
+    return block;
+}
+
+void LockedArena::lockObject (const void* start, size_t numBytes)
+{
+   #if JUCE_LINUX
+    if (mlock (start, numBytes) != 0)
+    {
+        const int lockError = errno;
+        recordFailure ("mlock of engine state", lockError);
+        return;
+    }
+
+    const juce::ScopedLock sl (statsLock);
+    lockedObjects.emplace_back (start, numBytes);
+    lockedBytes += numBytes;
+   #else
+    juce::ignoreUnused (start, numBytes);
+   #endif
+}
+
+//==============================================================================
+size_t LockedArena::getLockedBytes() const
+{
+    const juce::ScopedLock sl (statsLock);
+    return lockedBytes;
+}
+
+size_t LockedArena::getUnlockedBytes() const
+{
+    const juce::ScopedLock sl (statsLock);
+    return unlockedBytes;
+}
+
+juce::String LockedArena::getLastError() const
+{
+    const juce::ScopedLock sl (statsLock);
+    return lastError;
+}
+
+size_t LockedArena::getLockLimitBytes()
+{
+   #if JUCE_LINUX
+    rlimit limit {};
+
+    if (getrlimit (RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+        return (size_t) limit.rlim_cur;
+   #endif
+
+    return 0;
+}
+
+//==============================================================================
+void LockedArena::recordFailure (const juce::String& what, int errorNumber)
+{
+    const juce::ScopedLock sl (statsLock);
+    lastError = errorNumber != 0 ? what + " failed: " + juce::String (std::strerror (errorNumber))
+                                 : what;
+}
+
+void LockedArena::blockReleased (const Block& block)
+{
+    const juce::ScopedLock sl (statsLock);
+    (block.locked ? lockedBytes : unlockedBytes) -= block.size;
+}
+
+size_t LockedArena::getPageSize()
+{
+   #if JUCE_LINUX
+    return (size_t) juce::jmax (4096L, sysconf (_SC_PAGESIZE));
+   #else
+    return 4096;
+   #endif
+}
+
+void LockedArena::prefault (void* data, size_t numBytes)
+{
+    // One write per page is enough to make the kernel map it
+    auto* bytes = static_cast<volatile char*> (data);
+
+    for (size_t i = 0; i < numBytes; i += getPageSize())
+        bytes[i] = 0;
+}
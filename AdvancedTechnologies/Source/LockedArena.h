@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+    LockedArena.h
+    Hands out memory that is already in RAM and stays there: every block is
+    mapped, touched page by page and mlock()ed before anyone uses it.
+
+    CONCEPT: A fresh allocation is only a promise. The kernel maps the page
+             the first time it is touched (a page fault), and may swap it out
+             again on a busy machine. Either way the thread that touches it
+             waits — and if that thread is the audio callback, the block is
+             late. Decoding a sample into locked memory moves every fault to
+             load time, on the message thread, where nobody hears it.
+
+    Locking can be refused (RLIMIT_MEMLOCK, "ulimit -l", is only 8 MB on
+    many systems). A refused block is still handed out pre-faulted, and the
+    shortfall is counted so it can be reported instead of failing quietly.
+    Only Linux locks; other platforms get pre-faulted heap memory.
+
+    Threads: allocation, release and the statistics are message-thread (or
+             loader-thread) operations, guarded by a lock. Blocks are then
+             read and written by the audio thread like any other memory.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+class LockedArena
+{
+public:
+    //--------------------------------------------------------------------------
+    // One page-aligned, pre-faulted allocation, returned to the arena when
+    // destroyed. The arena must outlive its blocks.
+    //--------------------------------------------------------------------------
+    class Block
+    {
+    public:
+        ~Block();
+
+        void*  getData() const noexcept   { return data; }
+        size_t getSize() const noexcept   { return size; }
+        bool   isLocked() const noexcept  { return locked; }
+
+    private:
+        friend class LockedArena;
+        Block (LockedArena& owner, void* data, size_t size, bool mapped, bool locked);
+
+        LockedArena& arena;
+        void*        data;
+        size_t       size;
+        bool         mapped;
+        bool         locked;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Block)
+    };
+
+    LockedArena() = default;
+    ~LockedArena();
+
+    // Rounds up to whole pages. Never returns nullptr unless the machine is
+    // out of memory altogether.
+    std::unique_ptr<Block> allocate (size_t numBytes);
+
+    // Points buffer at a new zeroed block of numChannels x numSamples floats
+    // and returns the block, which must be kept alive for as long as the
+    // buffer refers to it. With no arena the buffer allocates as usual and
+    // nullptr is returned, so callers need only one code path.
+    static std::unique_ptr<Block> allocateBuffer (LockedArena* arena, juce::AudioBuffer<float>& buffer,
+                                                  int numChannels, int numSamples);
+
+    // Locks memory that already exists, e.g. an engine object holding voice
+    // and filter state. It stays locked until the arena is destroyed.
+    void lockObject (const void* start, size_t numBytes);
+
+    //--------------------------------------------------------------------------
+    // Statistics (any thread)
+    //--------------------------------------------------------------------------
+    size_t getLockedBytes() const;
+    size_t getUnlockedBytes() const;  // handed out pre-faulted but not locked
+    juce::String getLastError() const;
+
+    // The per-process lock limit, or 0 if unlimited / unknown
+    static size_t getLockLimitBytes();
+
+private:
+    void recordFailure (const juce::String& what, int errorNumber);
+    void blockReleased (const Block& block);
+
+    static size_t getPageSize();
+    static void prefault (void* data, size_t numBytes);
+
+    juce::CriticalSection                        statsLock;
+    size_t                                       lockedBytes   = 0;
+    size_t                                       unlockedBytes = 0;
+    juce::String                                 lastError;
+    std::vector<std::pair<const void*, size_t>>  lockedObjects;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LockedArena)
+};
@@ -10,6 +10,9 @@
 
 #include <JuceHeader.h>
 #include "MainComponent.h"
+#include "Benchmarks.h"
+#include "LatencyHarness.h"
+#include "Trace.h"
 
 //==============================================================================
 class AdvancedTechnologiesApplication : public juce::JUCEApplication
@@ -22,15 +25,55 @@ public:
     bool moreThanOneInstanceAllowed() override          { return true; }
 
     //--------------------------------------------------------------------------
-    void initialise (const juce::String& /*commandLine*/) override
+    void initialise (const juce::String& commandLine) override
     {
+        // Startup timings are measured from here
+        const auto launchTimeMs = juce::Time::getMillisecondCounterHiRes();
+
+        // "--trace" records a timeline of audio, MIDI and UI events;
+        // "--trace=file.json" also writes it there on exit
+        for (const auto& arg : juce::StringArray::fromTokens (commandLine, true))
+        {
+            if (arg == "--trace" || arg.startsWith ("--trace="))
+            {
+                Trace::start();
+                traceFile = arg.fromFirstOccurrenceOf ("=", false, false).unquoted();
+            }
+        }
+
+        // "--benchmark" times the DSP kernels and exits without a window
+        if (commandLine.contains ("--benchmark"))
+        {
+            Benchmarks::runAll();
+            quit();
+            return;
+        }
+
+        // "--latency-test" measures MIDI-to-audio latency on a dummy device
+        if (commandLine.contains ("--latency-test"))
+        {
+            latencyHarness = std::make_unique<LatencyHarness> (commandLine);
+            latencyHarness->start ([this] { quit(); });
+            return;
+        }
+
         // Create the main window — it owns the audio device manager and all UI
-        mainWindow.reset (new MainWindow (getApplicationName()));
+        mainWindow.reset (new MainWindow (getApplicationName(),
+                                          PerformanceMode::Options::fromCommandLine (commandLine),
+                                          launchTimeMs));
     }
 
     void shutdown() override
     {
+        latencyHarness = nullptr;
         mainWindow = nullptr; // destructor will clean up audio device
+
+        if (traceFile.isNotEmpty())
+        {
+            const auto file  = juce::File::getCurrentWorkingDirectory().getChildFile (traceFile);
+            const auto error = Trace::writeChromeJson (file);
+            juce::Logger::writeToLog (error.isEmpty() ? "Trace written to " + file.getFullPathName() : error);
+        }
     }
 
     void systemRequestedQuit() override { quit(); }
@@ -40,14 +83,14 @@ public:
     class MainWindow : public juce::DocumentWindow
     {
     public:
-        MainWindow (const juce::String& name)
+        MainWindow (const juce::String& name, const PerformanceMode::Options& performanceOptions, double launchTimeMs)
             : DocumentWindow (name,
                               juce::Desktop::getInstance().getDefaultLookAndFeel()
                                                           .findColour (juce::ResizableWindow::backgroundColourId),
                               DocumentWindow::allButtons)
         {
             setUsingNativeTitleBar (true);
-            setContentOwned (new MainComponent(), true); // MainComponent is our root UI
+            setContentOwned (new MainComponent (performanceOptions, launchTimeMs), true); // MainComponent is our root UI
             setResizable (true, true);
             centreWithSize (getWidth(), getHeight());
             setVisible (true);
@@ -64,6 +107,8 @@ public:
 
 private:
     std::unique_ptr<MainWindow> mainWindow;
+    std::unique_ptr<LatencyHarness> latencyHarness;
+    juce::String traceFile;
 };
 
 //==============================================================================
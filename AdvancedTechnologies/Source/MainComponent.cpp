@@ -5,22 +5,51 @@
 */
 
 #include "MainComponent.h"
+#include "Trace.h"
 
-MainComponent::MainComponent()
+MainComponent::MainComponent (const PerformanceMode::Options& performanceOptions, double launchTime)
+    : launchTimeMs (launchTime)
 {
+    if (performanceOptions.enabled)
+        performanceMode = std::make_unique<PerformanceMode> (performanceOptions);
+
     // -------------------------------------------------------------------------
-    // STEP 1: Initialise the audio device.
-    // initialiseWithDefaultDevices() picks the system default input + output.
-    // The arguments are: numInputChannels, numOutputChannels.
+    // STEP 1: Start opening the audio device.
+    // DeviceOpener runs initialiseWithDefaultDevices() (system default
+    // output only) on its own thread and calls deviceOpened() back
+    // here. SafePointer: the window may be closed before it finishes.
     // -------------------------------------------------------------------------
-    deviceManager.initialiseWithDefaultDevices (0, 2); // stereo out, no input
+    // Set before the recorder can be prepared, which may stop a recording
+    recorder.onStoppedByDevice = [safeThis = juce::Component::SafePointer<MainComponent> (this)]
+    {
+        if (safeThis != nullptr)
+            safeThis->recordingStoppedByDevice();
+    };
+
+    masterPlayer.setSource (&recorder);
+
+    deviceOpener.open ([safeThis = juce::Component::SafePointer<MainComponent> (this)] (const juce::String& error)
+    {
+        if (safeThis != nullptr)
+            safeThis->deviceOpened (error);
+    });
 
     // -------------------------------------------------------------------------
     // STEP 2: Create our two pages.
-    // We pass a reference to the deviceManager so each page can hook in.
+    // We pass a reference to the deviceManager so each page can hook in
+    // its MIDI, the master bus for its audio, and the governor so both
+    // pages' load is judged together.
+    //
+    // Both pages play MIDI whichever tab is showing, so neither can be built
+    // lazily. The slow part, decoding the drum samples, runs in the
+    // background instead.
     // -------------------------------------------------------------------------
-    synthPage   = new SynthComponent   (deviceManager);
-    drumPadPage = new DrumPadComponent (deviceManager);
+    synthPage   = new SynthComponent   (deviceManager, masterMix, governor);
+    drumPadPage = new DrumPadComponent (deviceManager, masterMix, governor,
+                                        DrumPadComponent::getDefaultSamplesDirectory(),
+                                        performanceMode != nullptr ? &performanceMode->getArena() : nullptr);
+
+    drumPadPage->onSamplesLoaded = [this] { logStartupMilestone ("drum samples loaded"); };
 
     // -------------------------------------------------------------------------
     // STEP 3: Add them to the tab strip.
@@ -30,23 +59,292 @@ MainComponent::MainComponent()
     tabs.addTab ("Drum Pad", juce::Colours::darkslategrey, drumPadPage, true);
 
     addAndMakeVisible (tabs);
-    setSize (700, 500);
+
+    // -------------------------------------------------------------------------
+    // STEP 4: The record bar
+    // -------------------------------------------------------------------------
+    recordButton.setClickingTogglesState (true);
+    recordButton.setColour (juce::TextButton::buttonOnColourId, juce::Colours::darkred);
+    recordButton.onClick = [this] { toggleRecording(); };
+    addAndMakeVisible (recordButton);
+
+    recordFormatBox.addItem ("WAV",  1);
+    recordFormatBox.addItem ("FLAC", 2);
+    recordFormatBox.setSelectedId (1, juce::dontSendNotification);
+    addAndMakeVisible (recordFormatBox);
+
+    calibrateButton.setTooltip ("Find the smallest stable buffer size for this device (plays muted for up to a minute)");
+    calibrateButton.onClick = [this] { toggleCalibration(); };
+    calibrateButton.setEnabled (false); // until the device is open
+    addAndMakeVisible (calibrateButton);
+
+    deviceStatus.setText ("Opening audio device...", juce::dontSendNotification);
+    deviceStatus.setJustificationType (juce::Justification::centredRight);
+    addAndMakeVisible (deviceStatus);
+
+    for (auto* label : { &recordStatus, &performanceStatus, &deviceStatus })
+    {
+        label->setFont (juce::Font (12.0f));
+        label->setColour (juce::Label::textColourId, juce::Colours::white.withAlpha (0.7f));
+    }
+
+    addAndMakeVisible (recordStatus);
+
+    saveTraceButton.onClick = [this] { saveTrace(); };
+    addChildComponent (saveTraceButton);
+    saveTraceButton.setVisible (Trace::isRecording());
+
+    // STEP 5 (performance mode only): a status strip showing what the
+    // system granted. Its audio callback is added in deviceOpened().
+    if (performanceMode != nullptr)
+        addAndMakeVisible (performanceStatus);
+
+    startTimerHz (4);
+    timerCallback();
+
+    setSize (760, 684);
 }
 
 MainComponent::~MainComponent()
 {
     // TabbedComponent owns its pages, so they are deleted automatically.
     // We just need to make sure audio is stopped before anything is destroyed.
+
+    // If the device is still opening, wait for it before touching the manager
+    deviceOpener.cancel();
     deviceManager.removeAllChangeListeners();
+
+    // Finish the file before the audio stops
+    recorder.stopRecording();
+
+    if (performanceMode != nullptr)
+        deviceManager.removeAudioCallback (performanceMode.get());
+
+    deviceManager.removeAudioCallback (&drumPadPage->getLiveSampler());
+    deviceManager.removeAudioCallback (&masterPlayer);
+    masterPlayer.setSource (nullptr);
     deviceManager.closeAudioDevice();
 }
 
 void MainComponent::paint (juce::Graphics& g)
 {
     g.fillAll (juce::Colour (0xff1e1e2e));
+
+    if (! firstFramePainted)
+    {
+        firstFramePainted = true;
+        logStartupMilestone ("first frame");
+    }
 }
 
 void MainComponent::resized()
 {
-    tabs.setBounds (getLocalBounds());
+    auto area = getLocalBounds();
+
+    if (performanceMode != nullptr)
+        performanceStatus.setBounds (area.removeFromBottom (22).reduced (8, 0));
+
+    auto recordBar = area.removeFromBottom (32).reduced (8, 4);
+    recordButton.setBounds (recordBar.removeFromLeft (80));
+    recordBar.removeFromLeft (6);
+    recordFormatBox.setBounds (recordBar.removeFromLeft (80));
+    recordBar.removeFromLeft (6);
+
+    if (saveTraceButton.isVisible())
+        saveTraceButton.setBounds (recordBar.removeFromRight (90));
+
+    calibrateButton.setBounds (recordBar.removeFromRight (90));
+    recordBar.removeFromRight (6);
+
+    deviceStatus.setBounds (recordBar.removeFromRight (recordBar.getWidth() / 2));
+
+    recordStatus.setBounds (recordBar);
+
+    tabs.setBounds (area);
+}
+
+//==============================================================================
+void MainComponent::deviceOpened (const juce::String& error)
+{
+    // A size found by an earlier calibration on this device
+    if (bufferTuner.applySavedBufferSize())
+        juce::Logger::writeToLog ("Using the calibrated buffer size for this device");
+
+    updateDeviceStatus (error);
+    calibrateButton.setEnabled (error.isEmpty());
+
+    // -------------------------------------------------------------------------
+    // Only now is it safe to start the audio. Callbacks run in the order
+    // they were added: the sampler first, so a take that ends in a buffer
+    // is on its pad by the time the drums render that same buffer.
+    // -------------------------------------------------------------------------
+    deviceManager.addAudioCallback (&drumPadPage->getLiveSampler());
+    deviceManager.addAudioCallback (&masterPlayer);
+
+    // Performance mode: a silent extra callback that sets up the audio thread
+    if (performanceMode != nullptr)
+        deviceManager.addAudioCallback (performanceMode.get());
+
+    // MIDI too waits for the opener: the device manager isn't thread safe,
+    // so nothing touches it while run() may still be inside it
+    synthPage->connectMidiInputs();
+    drumPadPage->connectMidiInputs();
+
+    logStartupMilestone (error.isEmpty() ? "audio device open" : "audio device failed: " + error);
+}
+
+void MainComponent::updateDeviceStatus (const juce::String& error)
+{
+    if (auto* device = deviceManager.getCurrentAudioDevice())
+    {
+        deviceStatus.setText (device->getName() + "  " + juce::String (device->getCurrentSampleRate() / 1000.0, 1)
+                                  + " kHz / " + juce::String (device->getCurrentBufferSizeSamples()) + " samples",
+                              juce::dontSendNotification);
+        deviceStatus.setTooltip (device->getTypeName());
+    }
+    else
+    {
+        deviceStatus.setText ("No audio (" + error + ") - running silent", juce::dontSendNotification);
+        deviceStatus.setColour (juce::Label::textColourId, juce::Colours::orange);
+    }
+}
+
+void MainComponent::toggleCalibration()
+{
+    if (bufferTuner.isRunning())
+    {
+        bufferTuner.cancel();
+        return;
+    }
+
+    // -------------------------------------------------------------------------
+    // The stress load goes in through the same MIDI callbacks a keyboard
+    // uses: every drum pad retriggered each tick, one synth note held.
+    // Muted, so a minute of machine-gun drums doesn't reach the speakers.
+    // -------------------------------------------------------------------------
+    auto& drumInput  = static_cast<juce::MidiInputCallback&> (*drumPadPage);
+    auto& synthInput = synthPage->getMidiInputCallback();
+
+    synthInput.handleIncomingMidiMessage (nullptr, juce::MidiMessage::noteOn (1, 60, 0.8f));
+    masterPlayer.setGain (0.0f);
+    recordButton.setEnabled (false);
+    calibrateButton.setButtonText ("Cancel");
+
+    bufferTuner.start ([&drumInput]
+                       {
+                           for (int pad = 0; pad < DrumEngine::kNumPads; ++pad)
+                               drumInput.handleIncomingMidiMessage (nullptr, juce::MidiMessage::noteOn (10, 36 + pad, 1.0f));
+                       },
+                       [this, &synthInput] (const juce::String& summary)
+                       {
+                           synthInput.handleIncomingMidiMessage (nullptr, juce::MidiMessage::noteOff (1, 60));
+                           masterPlayer.setGain (1.0f);
+                           recordButton.setEnabled (true);
+                           calibrateButton.setButtonText ("Calibrate");
+
+                           updateDeviceStatus();
+                           recordStatus.setText (summary, juce::dontSendNotification);
+                       });
+}
+
+void MainComponent::logStartupMilestone (const juce::String& milestone) const
+{
+    const auto elapsedMs = juce::Time::getMillisecondCounterHiRes() - launchTimeMs;
+    juce::Logger::writeToLog ("Startup: " + milestone + " after " + juce::String (elapsedMs, 1) + " ms");
+}
+
+void MainComponent::toggleRecording()
+{
+    if (! recordButton.getToggleState())
+    {
+        recorder.stopRecording();
+        recordButton.setButtonText ("Record");
+        calibrateButton.setEnabled (deviceManager.getCurrentAudioDevice() != nullptr);
+        recordStatus.setText ("Saved " + recorder.getFile().getFullPathName(), juce::dontSendNotification);
+        return;
+    }
+
+    const auto extension = recordFormatBox.getSelectedId() == 2 ? ".flac" : ".wav";
+    const auto file = MasterRecorder::getDefaultFolder()
+                          .getChildFile ("Bounce " + juce::Time::getCurrentTime().formatted ("%Y-%m-%d %H-%M-%S") + extension)
+                          .getNonexistentSibling();
+
+    const auto error = recorder.startRecording (file);
+
+    if (error.isNotEmpty())
+    {
+        recordButton.setToggleState (false, juce::dontSendNotification);
+        recordStatus.setText ("Can't record: " + error, juce::dontSendNotification);
+        return;
+    }
+
+    recordButton.setButtonText ("Stop");
+    calibrateButton.setEnabled (false);
+    updateRecordStatus();
+}
+
+void MainComponent::recordingStoppedByDevice()
+{
+    recordButton.setToggleState (false, juce::dontSendNotification);
+    recordButton.setButtonText ("Record");
+    calibrateButton.setEnabled (deviceManager.getCurrentAudioDevice() != nullptr);
+    recordStatus.setText ("Sample rate changed - saved " + recorder.getFile().getFullPathName(),
+                          juce::dontSendNotification);
+}
+
+void MainComponent::saveTrace()
+{
+    const auto file = juce::File::getSpecialLocation (juce::File::userDocumentsDirectory)
+                          .getChildFile ("Trace " + juce::Time::getCurrentTime().formatted ("%Y-%m-%d %H-%M-%S") + ".json")
+                          .getNonexistentSibling();
+
+    // Takes a moment for full rings, but recording carries on meanwhile
+    const auto error = Trace::writeChromeJson (file);
+    auto saved = "Trace saved to " + file.getFullPathName() + " - open it in ui.perfetto.dev";
+
+    if (const auto dropped = Trace::getNumDroppedEvents(); dropped > 0)
+        saved << " (" << (juce::int64) dropped << " events dropped: too many threads)";
+
+    recordStatus.setText (error.isEmpty() ? saved : error,
+                          juce::dontSendNotification);
+}
+
+void MainComponent::updateRecordStatus()
+{
+    if (! recorder.isRecording())
+        return;
+
+    const auto seconds = (int) recorder.getRecordedSeconds();
+    auto text = juce::String::formatted ("Recording %d:%02d  ", seconds / 60, seconds % 60)
+                + recorder.getFile().getFileName();
+
+    // The disk fell behind for longer than the FIFO holds
+    if (const auto dropped = recorder.getDroppedSamples(); dropped > 0)
+        text << "  -  " << juce::String (dropped) << " samples DROPPED";
+
+    recordStatus.setText (text, juce::dontSendNotification);
+}
+
+void MainComponent::timerCallback()
+{
+    updateRecordStatus();
+
+    // The synth's synced LFOs follow the drum sequencer's tempo
+    synthPage->setTempo (drumPadPage->getTempo());
+
+    if (bufferTuner.isRunning())
+        deviceStatus.setText (bufferTuner.getStatus(), juce::dontSendNotification);
+
+    if (performanceMode == nullptr)
+        return;
+
+    const auto report = performanceMode->getReport();
+
+    for (const auto& line : report)
+        if (! lastReport.contains (line))
+            juce::Logger::writeToLog ("Performance mode: " + line);
+
+    lastReport = report;
+    performanceStatus.setText (report.joinIntoString ("  |  "), juce::dontSendNotification);
+    performanceStatus.setTooltip (report.joinIntoString ("\n"));
 }
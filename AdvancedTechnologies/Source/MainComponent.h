@@ -1,11 +1,19 @@
 /*
   ==============================================================================
     MainComponent.h
-    Root component. Owns the AudioDeviceManager and hosts a TabbedComponent
-    with the Synth and Drum Pad pages.
+    Root component. Owns the AudioDeviceManager and the master bus, and
+    hosts a TabbedComponent with the Synth and Drum Pad pages. The bar along
+    the bottom records the master output; in performance mode a status strip
+    below it reports what the system granted.
 
     CONCEPT: AudioDeviceManager is the bridge between your app and the OS audio
              hardware. One instance is shared across the whole app.
+
+    CONCEPT: Startup is split so the window shows first. The device opens on
+             a background thread (DeviceOpener) and the drum samples decode
+             on a pool, while the message thread builds and paints the UI.
+             The time from launch to each milestone — first frame, audio
+             running, samples loaded — is written to the log.
   ==============================================================================
 */
 
@@ -13,11 +21,21 @@
 #include <JuceHeader.h>
 #include "SynthComponent.h"
 #include "DrumPadComponent.h"
+#include "LoadGovernor.h"
+#include "PerformanceMode.h"
+#include "BusMixer.h"
+#include "MasterRecorder.h"
+#include "DeviceOpener.h"
+#include "BufferSizeTuner.h"
 
-class MainComponent : public juce::Component
+class MainComponent : public juce::Component,
+                      private juce::Timer
 {
 public:
-    MainComponent();
+    // launchTimeMs: Time::getMillisecondCounterHiRes() when the app started,
+    // the zero for the startup timings
+    explicit MainComponent (const PerformanceMode::Options& performanceOptions = {},
+                            double launchTimeMs = juce::Time::getMillisecondCounterHiRes());
     ~MainComponent() override;
 
     void paint (juce::Graphics&) override;
@@ -29,6 +47,63 @@ private:
     // We create it here and pass references into child components.
     juce::AudioDeviceManager deviceManager;
 
+    // Shared by both pages: sums their render time and tells the engines
+    // to shed voices when the CPU can't keep up
+    LoadGovernor governor;
+
+    // Only created with --performance-mode. Declared before the tabs so the
+    // arena outlives the pages whose samples live in it.
+    std::unique_ptr<PerformanceMode> performanceMode;
+    juce::Label                      performanceStatus;
+    juce::StringArray                lastReport;
+
+    // -------------------------------------------------------------------------
+    // Master bus: every page adds its source to masterMix; one player drives
+    // it, through the recorder, so what's recorded is exactly what's heard.
+    // Declared before the tabs so it outlives the pages.
+    // -------------------------------------------------------------------------
+    BusMixer                 masterMix;
+    MasterRecorder           recorder { masterMix };
+    juce::AudioSourcePlayer  masterPlayer;
+
+    // -------------------------------------------------------------------------
+    // Startup
+    // -------------------------------------------------------------------------
+    DeviceOpener deviceOpener { deviceManager, 0, 2 };   // stereo out; the drum page adds the input on first arm
+    juce::Label  deviceStatus;
+    const double launchTimeMs;
+    bool         firstFramePainted = false;
+
+    // Adds the audio callbacks once the device is open (message thread)
+    void deviceOpened (const juce::String& error);
+    void logStartupMilestone (const juce::String& milestone) const;
+    void updateDeviceStatus (const juce::String& error = {});
+
+    // -------------------------------------------------------------------------
+    // Buffer-size calibration: applies the saved size when the device opens,
+    // and finds a new one when asked
+    // -------------------------------------------------------------------------
+    BufferSizeTuner  bufferTuner { deviceManager, governor };
+    juce::TextButton calibrateButton { "Calibrate" };
+
+    void toggleCalibration();
+
+    juce::TextButton recordButton { "Record" };
+    juce::ComboBox   recordFormatBox;
+    juce::Label      recordStatus;
+
+    // Only shown when running with --trace
+    juce::TextButton saveTraceButton { "Save trace" };
+
+    void toggleRecording();
+    void recordingStoppedByDevice();   // the recorder stopped on a sample-rate change
+    void updateRecordStatus();
+    void saveTrace();
+
+    // Refreshes the record status and performance strip, and logs any
+    // performance line that changed
+    void timerCallback() override;
+
     // TabbedComponent provides the tab strip at the top
     juce::TabbedComponent tabs { juce::TabbedButtonBar::TabsAtTop };
 
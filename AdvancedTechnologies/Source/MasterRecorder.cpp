@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+    MasterRecorder.cpp
+  ==============================================================================
+*/
+
+#include "MasterRecorder.h"
+#include "Trace.h"
+
+MasterRecorder::MasterRecorder (juce::AudioSource& s)
+    : source (s)
+{
+}
+
+MasterRecorder::~MasterRecorder()
+{
+    stopRecording();
+    writerThread.stopThread (1000);
+}
+
+juce::File MasterRecorder::getDefaultFolder()
+{
+    return juce::File::getSpecialLocation (juce::File::userMusicDirectory)
+               .getChildFile ("Advanced Technologies");
+}
+
+//==============================================================================
+juce::String MasterRecorder::startRecording (const juce::File& file)
+{
+    stopRecording();
+
+    const double rate = sampleRate.load();
+
+    if (rate <= 0.0)
+        return "The audio device isn't running";
+
+    // -------------------------------------------------------------------------
+    // Everything that can block or allocate happens here, before the audio
+    // thread ever sees the writer: creating the file, the encoder, and the
+    // FIFO (kBufferSeconds of audio, allocated by ThreadedWriter).
+    // -------------------------------------------------------------------------
+    file.getParentDirectory().createDirectory();
+    file.deleteFile();
+
+    auto stream = file.createOutputStream();
+
+    if (stream == nullptr)
+        return "Couldn't create " + file.getFullPathName();
+
+    auto& format = file.hasFileExtension ("flac") ? static_cast<juce::AudioFormat&> (flacFormat)
+                                                  : static_cast<juce::AudioFormat&> (wavFormat);
+
+    std::unique_ptr<juce::AudioFormatWriter> writer (format.createWriterFor (stream.get(), rate, kNumChannels,
+                                                                             kBitDepth, {}, 0));
+
+    if (writer == nullptr)
+        return format.getFormatName() + " can't record at " + juce::String (rate) + " Hz";
+
+    stream.release(); // the writer owns it now
+
+    writerThread.startThread();
+
+    threadedWriter = std::make_unique<juce::AudioFormatWriter::ThreadedWriter> (writer.release(), writerThread,
+                                                                                (int) (rate * kBufferSeconds));
+    currentFile = file;
+    samplesRecorded.store (0);
+    droppedSamples.store (0);
+
+    // From the next callback on, blocks go to the writer
+    activeWriter.store (threadedWriter.get());
+    return {};
+}
+
+void MasterRecorder::stopRecording()
+{
+    if (threadedWriter == nullptr)
+        return;
+
+    // -------------------------------------------------------------------------
+    // CONCEPT: Once activeWriter is null no NEW callback can pick the writer
+    // up; writerInUse tells us whether one that already did is still inside
+    // write(). Both are sequentially consistent atomics, so after this loop
+    // the audio thread can't be holding the old pointer.
+    // -------------------------------------------------------------------------
+    activeWriter.store (nullptr);
+
+    while (writerInUse.load())
+        juce::Thread::yield();
+
+    // Flushes whatever is still in the FIFO and closes the file
+    threadedWriter.reset();
+}
+
+double MasterRecorder::getRecordedSeconds() const
+{
+    const double rate = sampleRate.load();
+    return rate > 0.0 ? (double) samplesRecorded.load() / rate : 0.0;
+}
+
+//==============================================================================
+void MasterRecorder::prepareToPlay (int samplesPerBlockExpected, double newSampleRate)
+{
+    // A file can't change rate half way through
+    if (isRecording() && newSampleRate != sampleRate.load())
+    {
+        stopRecording();
+
+        if (onStoppedByDevice != nullptr)
+            juce::MessageManager::callAsync (onStoppedByDevice);
+    }
+
+    sampleRate.store (newSampleRate);
+    source.prepareToPlay (samplesPerBlockExpected, newSampleRate);
+}
+
+void MasterRecorder::getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    // The whole master bus: every page's render nests inside this
+    AT_TRACE_SCOPE_VALUE ("Audio callback", bufferToFill.numSamples);
+
+    source.getNextAudioBlock (bufferToFill);
+
+    writerInUse.store (true);
+
+    if (auto* writer = activeWriter.load())
+    {
+        const auto& buffer = *bufferToFill.buffer;
+
+        if (buffer.getNumChannels() > 0)
+        {
+            // Mono devices are recorded on both channels
+            const float* channels[kNumChannels];
+
+            for (int channel = 0; channel < kNumChannels; ++channel)
+                channels[channel] = buffer.getReadPointer (juce::jmin (channel, buffer.getNumChannels() - 1),
+                                                          bufferToFill.startSample);
+
+            // Copies into the FIFO and signals the writer thread; never
+            // waits for the disk
+            if (writer->write (channels, bufferToFill.numSamples))
+                samplesRecorded.fetch_add (bufferToFill.numSamples);
+            else
+                droppedSamples.fetch_add (bufferToFill.numSamples);
+        }
+    }
+
+    writerInUse.store (false);
+}
+
+void MasterRecorder::releaseResources()
+{
+    source.releaseResources();
+}
@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+    MasterRecorder.h
+    Records the master output to a WAV or FLAC file while passing it
+    through untouched.
+
+    CONCEPT: The audio thread must never wait for a disk. Writing a file can
+             block for tens of milliseconds (a flush, a busy drive, a network
+             home folder). So the callback only COPIES each block into a
+             FIFO preallocated when recording starts; a background
+             TimeSliceThread drains the FIFO into the file.
+             AudioFormatWriter::ThreadedWriter provides exactly that pair.
+
+    CONCEPT: If the disk falls behind for longer than the FIFO holds
+             (kBufferSeconds), write() refuses the block rather than waiting.
+             The block is missing from the file, and getDroppedSamples()
+             says how much was lost, so it is reported instead of silent.
+
+    Threads: start / stop on the message thread. The audio thread reaches
+             the writer through an atomic pointer. stopRecording() clears the
+             pointer, then waits for any callback still using the old writer
+             to finish, so the writer is never deleted mid-write.
+
+             The audio thread does take two short locks, neither of which is
+             ever held across disk I/O: the master BusMixer's CriticalSection
+             (contended only while a page adds or removes its bus), and the
+             mutex inside WaitableEvent::signal(), which ThreadedWriter's
+             write() uses to wake the writer thread.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+class MasterRecorder : public juce::AudioSource
+{
+public:
+    static constexpr int    kNumChannels   = 2;
+    static constexpr int    kBitDepth      = 24;
+    static constexpr double kBufferSeconds = 2.0;
+
+    explicit MasterRecorder (juce::AudioSource& source);
+    ~MasterRecorder() override;
+
+    //--------------------------------------------------------------------------
+    // Message thread
+    //--------------------------------------------------------------------------
+
+    // Starts writing to file (.flac for FLAC, anything else WAV), replacing
+    // it if it exists. Returns an error message, or an empty string.
+    juce::String startRecording (const juce::File& file);
+
+    // Stops and finishes the file. Blocks while the writer thread catches up.
+    void stopRecording();
+
+    bool isRecording() const                  { return activeWriter.load() != nullptr; }
+
+    // Posted to the message thread when the recorder stops on its own,
+    // because the device changed sample rate mid-recording
+    std::function<void()> onStoppedByDevice;
+    const juce::File& getFile() const         { return currentFile; }
+
+    // Any thread
+    double      getRecordedSeconds() const;
+    juce::int64 getDroppedSamples() const     { return droppedSamples.load(); }
+
+    // ~/Music/Advanced Technologies
+    static juce::File getDefaultFolder();
+
+    //--------------------------------------------------------------------------
+    // AudioSource interface
+    //--------------------------------------------------------------------------
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
+    void getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill) override;
+    void releaseResources() override;
+
+private:
+    juce::AudioSource& source;
+
+    juce::WavAudioFormat  wavFormat;
+    juce::FlacAudioFormat flacFormat;
+
+    juce::TimeSliceThread                                     writerThread { "Master recorder" };
+    std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter>  threadedWriter;
+    juce::File                                                currentFile;
+
+    // -------------------------------------------------------------------------
+    // Shared with the audio thread
+    // -------------------------------------------------------------------------
+    std::atomic<juce::AudioFormatWriter::ThreadedWriter*> activeWriter { nullptr };
+    std::atomic<bool>        writerInUse     { false };
+    std::atomic<double>      sampleRate      { 0.0 };
+    std::atomic<juce::int64> samplesRecorded { 0 };
+    std::atomic<juce::int64> droppedSamples  { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MasterRecorder)
+};
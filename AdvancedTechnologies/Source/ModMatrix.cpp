@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+    ModMatrix.cpp
+  ==============================================================================
+*/
+
+#include "ModMatrix.h"
+
+void ModMatrix::prepare (double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    reset();
+}
+
+void ModMatrix::reset()
+{
+    for (auto& lfo : lfos)
+        lfo.phase = 0.0;
+
+    startValues.fill (0.0f);
+    endValues.fill (0.0f);
+}
+
+//==============================================================================
+void ModMatrix::setLfo (int index, float rateHz, LfoShape shape, double syncBeats)
+{
+    auto& lfo = lfos[(size_t) index];
+    lfo.rateHz    = rateHz;
+    lfo.shape     = shape;
+    lfo.syncBeats = syncBeats;
+}
+
+void ModMatrix::setRouting (int slot, const Routing& routing)
+{
+    routings[(size_t) slot] = routing;
+    updateActive();
+}
+
+void ModMatrix::updateActive()
+{
+    active = false;
+
+    for (auto& lfo : lfos)
+        lfo.used = false;
+
+    for (const auto& routing : routings)
+    {
+        if (routing.source == Source::off || routing.depth == 0.0f)
+            continue;
+
+        active = true;
+
+        if (routing.source == Source::lfo1 || routing.source == Source::lfo2)
+            lfos[(size_t) routing.source - (size_t) Source::lfo1].used = true;
+    }
+}
+
+void ModMatrix::setSourceValue (Source source, float value)
+{
+    sourceValues[(size_t) source] = value;
+}
+
+double ModMatrix::getCyclesPerSample (const Lfo& lfo) const
+{
+    // A synced cycle lasts syncBeats beats: bpm / 60 beats per second
+    const double hz = lfo.syncBeats > 0.0 ? tempo / 60.0 / lfo.syncBeats : (double) lfo.rateHz;
+    return hz / sampleRate;
+}
+
+float ModMatrix::evaluateShape (LfoShape shape, double phase)
+{
+    switch (shape)
+    {
+        case LfoShape::triangle:  return (float) (1.0 - 4.0 * std::abs (phase - 0.5));
+        case LfoShape::saw:       return (float) (2.0 * phase - 1.0);
+        case LfoShape::square:    return phase < 0.5 ? 1.0f : -1.0f;
+        case LfoShape::sine:
+        default:                  return (float) std::sin (juce::MathConstants<double>::twoPi * phase);
+    }
+}
+
+//==============================================================================
+void ModMatrix::advance (int numSamples)
+{
+    startValues = endValues;
+
+    // -------------------------------------------------------------------------
+    // Phases always move, so an LFO routed later picks up where it would
+    // have been. Only the routed ones are evaluated.
+    // -------------------------------------------------------------------------
+    for (int i = 0; i < kNumLfos; ++i)
+    {
+        auto& lfo = lfos[(size_t) i];
+        lfo.phase += getCyclesPerSample (lfo) * numSamples;
+        lfo.phase -= std::floor (lfo.phase);
+
+        if (lfo.used)
+            sourceValues[(size_t) Source::lfo1 + (size_t) i] = evaluateShape (lfo.shape, lfo.phase);
+    }
+
+    endValues.fill (0.0f);
+
+    if (! active)
+        return;
+
+    for (const auto& routing : routings)
+        endValues[(size_t) routing.target] += sourceValues[(size_t) routing.source] * routing.depth;
+
+    for (int target = 0; target < kNumTargets; ++target)
+        endValues[(size_t) target] *= targetRanges[(size_t) target];
+}
@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+    ModMatrix.h
+    Two LFOs plus velocity, aftertouch and the mod wheel, routed through a
+    few slots of (source, target, depth) to the synth's pitch and volume.
+
+    CONCEPT: Control rate. Modulation moves slowly compared with audio, so
+             the matrix is evaluated once every kDefaultControlInterval
+             samples (configurable), not every sample: each LFO's sine, each
+             routing's multiply-add and the dB-to-gain conversion happen
+             once per control point. The synth then interpolates linearly
+             between consecutive points inside its kernels — volume as a
+             gain ramp, pitch as a glide of the voices' rotation — so there
+             are no steps to hear and no transcendental maths per sample.
+
+    CONCEPT: Sources are bipolar (-1..1, the LFOs) or unipolar (0..1, the
+             MIDI controls). A routing adds source * depth to its target,
+             with depth 1 meaning the target's full range: kPitchRange
+             semitones or kVolumeRangeDb decibels. A filter cutoff, once the
+             synth has a filter, is one more entry in Target.
+
+    Threads: audio thread only. SynthAudioSource passes its parameters in
+             once per block and its MIDI between render segments.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+class ModMatrix
+{
+public:
+    enum class Source   { off = 0, lfo1, lfo2, velocity, aftertouch, modWheel, numSources };
+    enum class Target   { pitch = 0, volume, numTargets };
+    enum class LfoShape { sine = 0, triangle, saw, square };
+
+    static constexpr int   kNumLfos                = 2;
+    static constexpr int   kMaxRoutings            = 4;
+    static constexpr int   kDefaultControlInterval = 32;
+    static constexpr int   kMaxControlInterval     = 64;
+    static constexpr float kPitchRange             = 12.0f;    // semitones at depth 1
+    static constexpr float kVolumeRangeDb          = 12.0f;    // dB at depth 1
+
+    struct Routing
+    {
+        Source source = Source::off;
+        Target target = Target::pitch;
+        float  depth  = 0.0f;      // -1..1
+    };
+
+    ModMatrix() = default;
+
+    void prepare (double sampleRate);
+    void reset();                  // LFOs back to the start of their cycle
+
+    //--------------------------------------------------------------------------
+    // Settings, once per block
+    //--------------------------------------------------------------------------
+
+    // syncBeats > 0 locks the cycle to that many beats at the current tempo;
+    // otherwise the LFO runs free at rateHz
+    void setLfo (int index, float rateHz, LfoShape shape, double syncBeats);
+    void setTempo (double bpm)                  { tempo = juce::jlimit (20.0, 300.0, bpm); }
+
+    void setRouting (int slot, const Routing& routing);
+    const Routing& getRouting (int slot) const  { return routings[(size_t) slot]; }
+
+    // Samples between evaluations, 1 .. kMaxControlInterval
+    void setControlInterval (int samples)       { controlInterval = juce::jlimit (1, kMaxControlInterval, samples); }
+    int  getControlInterval() const             { return controlInterval; }
+
+    // True if some routing has a source and a depth, i.e. there is anything
+    // to evaluate at all
+    bool isActive() const                       { return active; }
+
+    // The MIDI-driven sources, 0..1
+    void setSourceValue (Source source, float value);
+
+    //--------------------------------------------------------------------------
+    // Evaluation
+    //--------------------------------------------------------------------------
+
+    // Moves the LFOs on by numSamples and evaluates every routing at the end
+    // of that span. The span's start is the previous end; a caller
+    // interpolates between the two across the samples it renders.
+    void advance (int numSamples);
+
+    // In the target's units: semitones for pitch, dB for volume
+    float getStartValue (Target target) const   { return startValues[(size_t) target]; }
+    float getEndValue (Target target) const     { return endValues[(size_t) target]; }
+
+private:
+    static constexpr int kNumSources = (int) Source::numSources;
+    static constexpr int kNumTargets = (int) Target::numTargets;
+
+    struct Lfo
+    {
+        double   phase     = 0.0;    // 0..1
+        float    rateHz    = 1.0f;
+        double   syncBeats = 0.0;
+        LfoShape shape     = LfoShape::sine;
+        bool     used      = false;  // by some routing
+    };
+
+    static float evaluateShape (LfoShape shape, double phase);
+    double getCyclesPerSample (const Lfo& lfo) const;
+    void   updateActive();
+
+    std::array<Lfo, kNumLfos>           lfos;
+    std::array<Routing, kMaxRoutings>   routings;
+    std::array<float, kNumSources>      sourceValues {};
+    std::array<float, kNumTargets>      startValues {}, endValues {};
+    std::array<float, kNumTargets>      targetRanges { kPitchRange, kVolumeRangeDb };
+
+    double sampleRate      = 44100.0;
+    double tempo           = 120.0;
+    int    controlInterval = kDefaultControlInterval;
+    bool   active          = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ModMatrix)
+};
@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+    ModMatrixComponent.cpp
+  ==============================================================================
+*/
+
+#include "ModMatrixComponent.h"
+#include "SynthAudioSource.h"
+
+ModMatrixComponent::ModMatrixComponent (juce::AudioProcessorValueTreeState& state)
+    : apvts (state)
+{
+    for (int i = 0; i < ModMatrix::kNumLfos; ++i)
+    {
+        auto& row = lfoRows[(size_t) i];
+
+        setupLabel (row.label, "LFO " + juce::String (i + 1));
+        setupSlider (row.rate);
+        row.rate.setTextValueSuffix (" Hz");
+        row.rate.setTooltip ("Used while Sync is Free");
+
+        row.rateAttachment  = std::make_unique<SliderAttachment> (apvts, SynthAudioSource::getLfoParameterId (i, "Rate"), row.rate);
+        row.syncAttachment  = attachBox (row.sync,  SynthAudioSource::getLfoParameterId (i, "Sync"));
+        row.shapeAttachment = attachBox (row.shape, SynthAudioSource::getLfoParameterId (i, "Shape"));
+    }
+
+    for (int slot = 0; slot < ModMatrix::kMaxRoutings; ++slot)
+    {
+        auto& row = routingRows[(size_t) slot];
+
+        setupLabel (row.label, "Mod " + juce::String (slot + 1));
+        setupSlider (row.depth);
+
+        row.sourceAttachment = attachBox (row.source, SynthAudioSource::getRoutingParameterId (slot, "Source"));
+        row.targetAttachment = attachBox (row.target, SynthAudioSource::getRoutingParameterId (slot, "Target"));
+        row.depthAttachment  = std::make_unique<SliderAttachment> (apvts, SynthAudioSource::getRoutingParameterId (slot, "Depth"), row.depth);
+    }
+
+    setupLabel (intervalLabel, "Update every");
+    intervalLabel.setTooltip ("How often modulation is evaluated; it is interpolated in between");
+    intervalAttachment = attachBox (intervalBox, "modInterval");
+}
+
+void ModMatrixComponent::setupLabel (juce::Label& label, const juce::String& text)
+{
+    label.setText (text, juce::dontSendNotification);
+    label.setFont (juce::Font (13.0f));
+    label.setColour (juce::Label::textColourId, juce::Colours::white.withAlpha (0.7f));
+    addAndMakeVisible (label);
+}
+
+void ModMatrixComponent::setupSlider (juce::Slider& slider)
+{
+    slider.setSliderStyle (juce::Slider::LinearHorizontal);
+    slider.setTextBoxStyle (juce::Slider::TextBoxRight, false, 60, 20);
+    addAndMakeVisible (slider);
+}
+
+std::unique_ptr<ModMatrixComponent::ComboBoxAttachment> ModMatrixComponent::attachBox (juce::ComboBox& box,
+                                                                                       const juce::String& parameterId)
+{
+    // ComboBoxAttachment maps item i to choice i, so the items go in first
+    if (auto* choice = dynamic_cast<juce::AudioParameterChoice*> (apvts.getParameter (parameterId)))
+        box.addItemList (choice->choices, 1);
+
+    addAndMakeVisible (box);
+    return std::make_unique<ComboBoxAttachment> (apvts, parameterId, box);
+}
+
+void ModMatrixComponent::resized()
+{
+    auto area = getLocalBounds();
+
+    const auto nextRow = [&area]
+    {
+        auto row = area.removeFromTop (24);
+        area.removeFromTop (8);
+        return row;
+    };
+
+    for (auto& lfo : lfoRows)
+    {
+        auto row = nextRow();
+        lfo.label.setBounds (row.removeFromLeft (60));
+        lfo.shape.setBounds (row.removeFromRight (100));
+        row.removeFromRight (8);
+        lfo.sync.setBounds (row.removeFromRight (100));
+        row.removeFromRight (8);
+        lfo.rate.setBounds (row);
+    }
+
+    for (auto& routing : routingRows)
+    {
+        auto row = nextRow();
+        routing.label.setBounds (row.removeFromLeft (60));
+        routing.source.setBounds (row.removeFromLeft (120));
+        row.removeFromLeft (8);
+        routing.target.setBounds (row.removeFromLeft (100));
+        row.removeFromLeft (8);
+        routing.depth.setBounds (row);
+    }
+
+    auto row = nextRow();
+    intervalLabel.setBounds (row.removeFromLeft (100));
+    intervalBox.setBounds (row.removeFromLeft (120));
+}
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+    ModMatrixComponent.h
+    Editor strip for the synth's modulation: the two LFOs (rate, sync,
+    shape), the routing slots (source, target, depth) and how often the
+    matrix is evaluated.
+
+    CONCEPT: Every control is attached to its APVTS parameter, so the strip
+             holds no state of its own; the audio thread reads the same
+             parameters once per block (SynthAudioSource::updateModulation()).
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "ModMatrix.h"
+
+class ModMatrixComponent : public juce::Component
+{
+public:
+    // LFO rows, routing rows and the interval row, 24 px each with 8 px gaps
+    static constexpr int kNumRows         = ModMatrix::kNumLfos + ModMatrix::kMaxRoutings + 1;
+    static constexpr int kPreferredHeight = kNumRows * 24 + (kNumRows - 1) * 8;
+
+    explicit ModMatrixComponent (juce::AudioProcessorValueTreeState& apvts);
+
+    void resized() override;
+
+private:
+    using SliderAttachment   = juce::AudioProcessorValueTreeState::SliderAttachment;
+    using ComboBoxAttachment = juce::AudioProcessorValueTreeState::ComboBoxAttachment;
+
+    struct LfoRow
+    {
+        juce::Label    label;
+        juce::Slider   rate;
+        juce::ComboBox sync, shape;
+        std::unique_ptr<SliderAttachment>   rateAttachment;
+        std::unique_ptr<ComboBoxAttachment> syncAttachment, shapeAttachment;
+    };
+
+    struct RoutingRow
+    {
+        juce::Label    label;
+        juce::ComboBox source, target;
+        juce::Slider   depth;
+        std::unique_ptr<ComboBoxAttachment> sourceAttachment, targetAttachment;
+        std::unique_ptr<SliderAttachment>   depthAttachment;
+    };
+
+    void setupLabel (juce::Label& label, const juce::String& text);
+    void setupSlider (juce::Slider& slider);
+    std::unique_ptr<ComboBoxAttachment> attachBox (juce::ComboBox& box, const juce::String& parameterId);
+
+    juce::AudioProcessorValueTreeState& apvts;
+
+    std::array<LfoRow, ModMatrix::kNumLfos>         lfoRows;
+    std::array<RoutingRow, ModMatrix::kMaxRoutings> routingRows;
+
+    juce::Label                         intervalLabel;
+    juce::ComboBox                      intervalBox;
+    std::unique_ptr<ComboBoxAttachment> intervalAttachment;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ModMatrixComponent)
+};
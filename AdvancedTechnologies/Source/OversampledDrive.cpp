@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+    OversampledDrive.cpp
+  ==============================================================================
+*/
+
+#include "OversampledDrive.h"
+
+OversampledDrive::OversampledDrive()
+{
+    for (int i = 0; i < kMaxFactorLog2; ++i)
+    {
+        // IIR half-bands: far less latency than the linear-phase FIR ones.
+        // Integer latency adds a fractional delay so the total is whole samples.
+        oversamplers[(size_t) i] = std::make_unique<juce::dsp::Oversampling<float>> (
+                                       1, (size_t) (i + 1), juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR,
+                                       true, true);
+    }
+}
+
+void OversampledDrive::prepare (int maximumBlockSize)
+{
+    maxBlockSize = juce::jmax (1, maximumBlockSize);
+
+    for (auto& oversampler : oversamplers)
+        oversampler->initProcessing ((size_t) maxBlockSize);
+
+    lastFactorLog2 = -1;
+}
+
+void OversampledDrive::reset()
+{
+    for (auto& oversampler : oversamplers)
+        oversampler->reset();
+}
+
+float OversampledDrive::getLatencySamples (int factorLog2) const
+{
+    if (factorLog2 <= 0 || factorLog2 > kMaxFactorLog2)
+        return 0.0f;
+
+    return (float) oversamplers[(size_t) factorLog2 - 1]->getLatencyInSamples();
+}
+
+//==============================================================================
+void OversampledDrive::shape (juce::dsp::AudioBlock<float>& block, float drive)
+{
+    // -------------------------------------------------------------------------
+    // tanh(k * x) / tanh(k): k sets how hard the curve bends, the division
+    // keeps a full-scale input at full scale whatever the drive
+    // -------------------------------------------------------------------------
+    const float k          = 1.0f + 9.0f * drive;
+    const float makeUpGain = 1.0f / std::tanh (k);
+
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    {
+        float* samples = block.getChannelPointer (channel);
+
+        for (size_t i = 0; i < block.getNumSamples(); ++i)
+            samples[i] = std::tanh (k * samples[i]) * makeUpGain;
+    }
+}
+
+void OversampledDrive::process (float* samples, int numSamples, float drive, int factorLog2)
+{
+    jassert (maxBlockSize > 0);   // prepare() first
+
+    if (maxBlockSize == 0)
+        return;
+
+    factorLog2 = juce::jlimit (0, kMaxFactorLog2, factorLog2);
+
+    // Filter state from another factor (or from before a pause) would click
+    if (factorLog2 != lastFactorLog2)
+    {
+        reset();
+        lastFactorLog2 = factorLog2;
+    }
+
+    for (int offset = 0; offset < numSamples; offset += maxBlockSize)
+    {
+        float* channels[] = { samples + offset };
+        juce::dsp::AudioBlock<float> block (channels, 1, (size_t) juce::jmin (maxBlockSize, numSamples - offset));
+
+        if (factorLog2 == 0)
+        {
+            shape (block, drive);
+            continue;
+        }
+
+        auto& oversampler = *oversamplers[(size_t) factorLog2 - 1];
+
+        auto upsampled = oversampler.processSamplesUp (block);
+        shape (upsampled, drive);
+        oversampler.processSamplesDown (block);
+    }
+}
@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+    OversampledDrive.h
+    A tanh saturator for the synth, run at 1x, 2x, 4x or 8x the sample rate.
+
+    CONCEPT: A nonlinearity makes harmonics. Drive a 5 kHz sine hard and it
+             grows partials at 15, 25, 35 kHz… — everything above Nyquist
+             folds back down as inharmonic aliasing, worst on high notes.
+             Upsampling first gives the harmonics room to exist; the
+             half-band filters on the way down remove them before they can
+             fold. juce::dsp::Oversampling does both with polyphase IIR
+             half-band stages (one per doubling).
+
+    CONCEPT: Only where it's needed. The voices themselves are clean sines
+             and the drum bus has no nonlinearity, so only this stage runs
+             oversampled — on the summed synth signal, and only while the
+             drive is above zero. At drive 0 nothing here runs at all.
+
+    Latency: each factor has its own filter delay (integer samples at the
+             base rate, so the plugin can report it exactly).
+
+    Threads: construction and prepare() off the audio thread; process()
+             and reset() on it.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+class OversampledDrive
+{
+public:
+    static constexpr int kMaxFactorLog2 = 3;     // 8x
+
+    // Builds one mono oversampler per factor (allocates)
+    OversampledDrive();
+
+    // Sizes the oversamplers for blocks of up to maximumBlockSize samples
+    void prepare (int maximumBlockSize);
+    void reset();
+
+    // Saturates numSamples mono samples in place. drive is 0..1;
+    // factorLog2 0 runs the shaper at the base rate, 1..3 at 2x..8x.
+    void process (float* samples, int numSamples, float drive, int factorLog2);
+
+    // The stage's delay at the base rate, for a factor. Known from
+    // construction, whatever the sample rate.
+    float getLatencySamples (int factorLog2) const;
+
+private:
+    static void shape (juce::dsp::AudioBlock<float>& block, float drive);
+
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, kMaxFactorLog2> oversamplers;
+    int maxBlockSize   = 0;
+    int lastFactorLog2 = -1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OversampledDrive)
+};
@@ -0,0 +1,308 @@
+/*
+  ==============================================================================
+    PadToneBank.cpp
+  ==============================================================================
+*/
+
+#include "PadToneBank.h"
+
+namespace
+{
+    // Filters whose state has decayed below this are considered silent
+    constexpr float kSilenceThreshold = 1.0e-8f;
+
+    struct BiquadCoefficients { float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f; };
+
+    // -------------------------------------------------------------------------
+    // CONCEPT: Robert Bristow-Johnson's "Audio EQ Cookbook" formulas. We do
+    // the maths ourselves instead of using dsp::IIR::Coefficients because
+    // those are heap-allocated objects, and this runs on the audio thread.
+    // -------------------------------------------------------------------------
+    BiquadCoefficients makeFilter (PadToneBank::FilterType type, double sampleRate, float cutoff, float q)
+    {
+        if (type == PadToneBank::FilterType::off)
+            return {};
+
+        const double w0    = juce::MathConstants<double>::twoPi
+                             * juce::jlimit (20.0, sampleRate * 0.49, (double) cutoff) / sampleRate;
+        const double cosW0 = std::cos (w0);
+        const double alpha = std::sin (w0) / (2.0 * juce::jmax (0.1, (double) q));
+        const double a0    = 1.0 + alpha;
+
+        const double b1 = type == PadToneBank::FilterType::lowPass ? 1.0 - cosW0 : -(1.0 + cosW0);
+        const double b0 = std::abs (b1) * 0.5;
+
+        return { (float) (b0 / a0), (float) (b1 / a0), (float) (b0 / a0),
+                 (float) (-2.0 * cosW0 / a0), (float) ((1.0 - alpha) / a0) };
+    }
+
+    BiquadCoefficients makePeak (double sampleRate, float freq, float gainDb)
+    {
+        if (std::abs (gainDb) < 0.01f)
+            return {};
+
+        const double A     = std::pow (10.0, gainDb / 40.0);
+        const double w0    = juce::MathConstants<double>::twoPi
+                             * juce::jlimit (20.0, sampleRate * 0.49, (double) freq) / sampleRate;
+        const double cosW0 = std::cos (w0);
+        const double alpha = std::sin (w0) / 2.0;   // Q = 1
+        const double a0    = 1.0 + alpha / A;
+
+        return { (float) ((1.0 + alpha * A) / a0), (float) (-2.0 * cosW0 / a0), (float) ((1.0 - alpha * A) / a0),
+                 (float) (-2.0 * cosW0 / a0),       (float) ((1.0 - alpha / A) / a0) };
+    }
+}
+
+//==============================================================================
+PadToneBank::PadToneBank()
+{
+    published.publish (editTones);
+    recalculateCoefficients (editTones);
+}
+
+void PadToneBank::setTone (int padIndex, const PadTone& tone)
+{
+    if (padIndex < 0 || padIndex >= kNumPads)
+        return;
+
+    editTones[(size_t) padIndex] = tone;
+    published.publish (editTones);
+}
+
+void PadToneBank::prepare (int maximumBlockSize, double sampleRate)
+{
+    currentSampleRate = sampleRate;
+
+   #if JUCE_USE_SIMD
+    interleaved.resize ((size_t) maximumBlockSize);
+   #else
+    juce::ignoreUnused (maximumBlockSize);
+   #endif
+
+    recalculateCoefficients (published.read());
+    reset();
+}
+
+void PadToneBank::reset()
+{
+    for (auto& channelState : state)
+        channelState.fill ({});
+}
+
+bool PadToneBank::update()
+{
+    if (published.update())
+        recalculateCoefficients (published.read());
+
+    return anyActive;
+}
+
+void PadToneBank::recalculateCoefficients (const std::array<PadTone, kNumPads>& tones)
+{
+    anyActive = false;
+
+    for (int pad = 0; pad < kPadSlots; ++pad)
+    {
+        BiquadCoefficients stages[kNumStages];
+
+        // Slots past the last pad (when 16 isn't a multiple of the lane
+        // count) keep the pass-through default
+        if (pad < kNumPads)
+        {
+            const auto& tone = tones[(size_t) pad];
+            stages[0] = makeFilter (tone.filterType, currentSampleRate, tone.cutoffHz, tone.resonance);
+            stages[1] = makePeak (currentSampleRate, tone.eqFreqHz, tone.eqGainDb);
+            anyActive = anyActive || ! tone.isFlat();
+        }
+
+        for (int stage = 0; stage < kNumStages; ++stage)
+        {
+            auto& c = coeffs[(size_t) stage];
+            c.b0.value[pad] = stages[stage].b0;
+            c.b1.value[pad] = stages[stage].b1;
+            c.b2.value[pad] = stages[stage].b2;
+            c.a1.value[pad] = stages[stage].a1;
+            c.a2.value[pad] = stages[stage].a2;
+        }
+    }
+}
+
+std::uint32_t PadToneBank::groupMask (int group)
+{
+    return (((1u << kLanes) - 1u) << (group * kLanes)) & ((1u << kNumPads) - 1u);
+}
+
+bool PadToneBank::groupIsIdle (int group, std::uint32_t activePads) const
+{
+    if ((activePads & groupMask (group)) != 0)
+        return false;
+
+    for (const auto& channelState : state)
+        for (const auto& stageState : channelState)
+            for (int pad = group * kLanes; pad < (group + 1) * kLanes; ++pad)
+                if (std::abs (stageState.s1.value[pad]) > kSilenceThreshold
+                    || std::abs (stageState.s2.value[pad]) > kSilenceThreshold)
+                    return false;
+
+    return true;
+}
+
+bool PadToneBank::isRinging() const
+{
+    for (int group = 0; group < kNumGroups; ++group)
+        if (! groupIsIdle (group, 0))
+            return true;
+
+    return false;
+}
+
+//==============================================================================
+std::uint32_t PadToneBank::process (std::array<juce::AudioBuffer<float>, kNumPads>& padBuffers,
+                                    std::uint32_t activePads, int numSamples)
+{
+   #if ! JUCE_USE_SIMD
+    return processScalar (padBuffers, activePads, numSamples);
+   #else
+    juce::ScopedNoDenormals noDenormals;
+    std::uint32_t producedOutput = 0;
+
+    jassert ((size_t) numSamples <= interleaved.size());
+    auto* lanes = reinterpret_cast<float*> (interleaved.data());
+
+    for (int group = 0; group < kNumGroups; ++group)
+    {
+        if (groupIsIdle (group, activePads))
+            continue;
+
+        producedOutput |= groupMask (group);
+        const int firstPad = group * kLanes;
+
+        for (int channel = 0; channel < kChannels; ++channel)
+        {
+            // -----------------------------------------------------------------
+            // Transpose in: gather this group's pads into SIMD lanes
+            // -----------------------------------------------------------------
+            for (int lane = 0; lane < kLanes; ++lane)
+            {
+                const int pad = firstPad + lane;
+
+                if (pad < kNumPads)
+                {
+                    const float* src = padBuffers[(size_t) pad].getReadPointer (channel);
+
+                    for (int n = 0; n < numSamples; ++n)
+                        lanes[n * kLanes + lane] = src[n];
+                }
+                else
+                {
+                    for (int n = 0; n < numSamples; ++n)
+                        lanes[n * kLanes + lane] = 0.0f;
+                }
+            }
+
+            // -----------------------------------------------------------------
+            // Both biquad stages, kLanes pads per instruction
+            // -----------------------------------------------------------------
+            Vec b0[kNumStages], b1[kNumStages], b2[kNumStages], a1[kNumStages], a2[kNumStages];
+            Vec s1[kNumStages], s2[kNumStages];
+
+            for (int stage = 0; stage < kNumStages; ++stage)
+            {
+                const auto& c  = coeffs[(size_t) stage];
+                const auto& st = state[(size_t) channel][(size_t) stage];
+
+                b0[stage] = Vec::fromRawArray (c.b0.value + firstPad);
+                b1[stage] = Vec::fromRawArray (c.b1.value + firstPad);
+                b2[stage] = Vec::fromRawArray (c.b2.value + firstPad);
+                a1[stage] = Vec::fromRawArray (c.a1.value + firstPad);
+                a2[stage] = Vec::fromRawArray (c.a2.value + firstPad);
+                s1[stage] = Vec::fromRawArray (st.s1.value + firstPad);
+                s2[stage] = Vec::fromRawArray (st.s2.value + firstPad);
+            }
+
+            for (int n = 0; n < numSamples; ++n)
+            {
+                Vec x = interleaved[(size_t) n];
+
+                for (int stage = 0; stage < kNumStages; ++stage)
+                {
+                    const Vec y = b0[stage] * x + s1[stage];
+                    s1[stage] = b1[stage] * x - a1[stage] * y + s2[stage];
+                    s2[stage] = b2[stage] * x - a2[stage] * y;
+                    x = y;
+                }
+
+                interleaved[(size_t) n] = x;
+            }
+
+            for (int stage = 0; stage < kNumStages; ++stage)
+            {
+                auto& st = state[(size_t) channel][(size_t) stage];
+                s1[stage].copyToRawArray (st.s1.value + firstPad);
+                s2[stage].copyToRawArray (st.s2.value + firstPad);
+            }
+
+            // -----------------------------------------------------------------
+            // Transpose out: scatter the lanes back to each pad's buffer
+            // -----------------------------------------------------------------
+            for (int lane = 0; lane < kLanes && firstPad + lane < kNumPads; ++lane)
+            {
+                float* dest = padBuffers[(size_t) (firstPad + lane)].getWritePointer (channel);
+
+                for (int n = 0; n < numSamples; ++n)
+                    dest[n] = lanes[n * kLanes + lane];
+            }
+        }
+    }
+
+    return producedOutput;
+   #endif
+}
+
+std::uint32_t PadToneBank::processScalar (std::array<juce::AudioBuffer<float>, kNumPads>& padBuffers,
+                                          std::uint32_t activePads, int numSamples)
+{
+    juce::ScopedNoDenormals noDenormals;
+    std::uint32_t producedOutput = 0;
+
+    for (int group = 0; group < kNumGroups; ++group)
+    {
+        // Same skipping rule as the SIMD path, so the two stay comparable
+        if (groupIsIdle (group, activePads))
+            continue;
+
+        producedOutput |= groupMask (group);
+
+        for (int pad = group * kLanes; pad < juce::jmin ((group + 1) * kLanes, kNumPads); ++pad)
+        {
+            for (int channel = 0; channel < kChannels; ++channel)
+            {
+                float* data = padBuffers[(size_t) pad].getWritePointer (channel);
+
+                for (int stage = 0; stage < kNumStages; ++stage)
+                {
+                    const auto& c = coeffs[(size_t) stage];
+                    auto& st      = state[(size_t) channel][(size_t) stage];
+
+                    const float b0 = c.b0.value[pad], b1 = c.b1.value[pad], b2 = c.b2.value[pad];
+                    const float a1 = c.a1.value[pad], a2 = c.a2.value[pad];
+                    float s1 = st.s1.value[pad], s2 = st.s2.value[pad];
+
+                    for (int n = 0; n < numSamples; ++n)
+                    {
+                        const float x = data[n];
+                        const float y = b0 * x + s1;
+                        s1 = b1 * x - a1 * y + s2;
+                        s2 = b2 * x - a2 * y;
+                        data[n] = y;
+                    }
+
+                    st.s1.value[pad] = s1;
+                    st.s2.value[pad] = s2;
+                }
+            }
+        }
+    }
+
+    return producedOutput;
+}
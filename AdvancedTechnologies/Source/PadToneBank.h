@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+    PadToneBank.h
+    Per-pad tone shaping for the drum engine: a low-pass / high-pass filter
+    followed by a peaking EQ band on each of the 16 pads.
+
+    CONCEPT: 16 pads x 2 biquads x 2 channels is 64 filters per block. Run
+             one at a time, that multiplies the drum bus cost. But every pad
+             runs the SAME maths with different numbers, so we store the
+             coefficients and state "structure of arrays" style —
+             b0[pad0..pad15], b1[pad0..pad15], … — and let one SIMD
+             instruction advance 4 (SSE / NEON) or 8 (AVX) pads at once
+             using juce::dsp::SIMDRegister.
+
+    Each biquad uses Transposed Direct Form II:
+        y  = b0*x + s1
+        s1 = b1*x - a1*y + s2
+        s2 = b2*x - a2*y
+
+    Threads: setTone() on the message thread publishes settings through a
+             TripleBuffer; the audio thread recomputes coefficients only
+             when a new version arrives.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "TripleBuffer.h"
+
+class PadToneBank
+{
+public:
+    static constexpr int kNumPads   = 16;
+    static constexpr int kNumStages = 2;     // filter, then EQ
+
+    enum class FilterType { off = 0, lowPass, highPass };
+
+    struct PadTone
+    {
+        FilterType filterType = FilterType::off;
+        float      cutoffHz   = 8000.0f;
+        float      resonance  = 0.707f;      // filter Q
+        float      eqFreqHz   = 1000.0f;
+        float      eqGainDb   = 0.0f;
+
+        bool isFlat() const { return filterType == FilterType::off && std::abs (eqGainDb) < 0.01f; }
+    };
+
+    PadToneBank();
+
+    //--------------------------------------------------------------------------
+    // Message thread
+    //--------------------------------------------------------------------------
+    void setTone (int padIndex, const PadTone& tone);
+    PadTone getTone (int padIndex) const     { return editTones[(size_t) padIndex]; }
+
+    //--------------------------------------------------------------------------
+    // Audio thread
+    //--------------------------------------------------------------------------
+    void prepare (int maximumBlockSize, double sampleRate);
+    void reset();
+
+    // Picks up new settings. Returns true if any pad is not flat, i.e. the
+    // engine needs to render pads separately and call process().
+    bool update();
+
+    // Filters each pad's stereo buffer in place. activePads has bit p set if
+    // pad p produced audio this block; idle groups whose filters have rung
+    // out are skipped. Returns the mask of pads whose buffers now hold
+    // output (active pads plus ringing filter tails).
+    std::uint32_t process (std::array<juce::AudioBuffer<float>, kNumPads>& padBuffers,
+                           std::uint32_t activePads, int numSamples);
+
+    // Same result, one pad at a time with plain floats. Used when SIMD is
+    // unavailable, and by the benchmark as the baseline.
+    std::uint32_t processScalar (std::array<juce::AudioBuffer<float>, kNumPads>& padBuffers,
+                                 std::uint32_t activePads, int numSamples);
+
+    // True while some pad's filters still hold a tail, with or without a
+    // pad playing into them
+    bool isRinging() const;
+
+private:
+   #if JUCE_USE_SIMD
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr int kLanes     = (int) Vec::size();
+   #else
+    static constexpr int kLanes     = 4;     // grouping only, no vector maths
+   #endif
+    static constexpr int kNumGroups = (kNumPads + kLanes - 1) / kLanes;
+    static constexpr int kPadSlots  = kNumGroups * kLanes;   // padded to whole groups
+    static constexpr int kChannels  = 2;
+
+    void recalculateCoefficients (const std::array<PadTone, kNumPads>& tones);
+    bool groupIsIdle (int group, std::uint32_t activePads) const;
+    static std::uint32_t groupMask (int group);
+
+    // -------------------------------------------------------------------------
+    // Structure of arrays: one aligned row per coefficient / state variable,
+    // one column per pad. A SIMD load of row[group * kLanes] reads kLanes
+    // neighbouring pads' values in one go.
+    // -------------------------------------------------------------------------
+    struct alignas (64) Row { float value[kPadSlots] {}; };
+
+    struct Coefficients { Row b0, b1, b2, a1, a2; };
+    struct State        { Row s1, s2; };
+
+    std::array<Coefficients, kNumStages>                           coeffs;
+    std::array<std::array<State, kNumStages>, kChannels>           state;
+
+   #if JUCE_USE_SIMD
+    // Transposed audio for one group: interleaved[n] holds sample n of each
+    // of the group's pads, one per lane. std::vector honours Vec's alignment.
+    std::vector<Vec> interleaved;
+   #endif
+
+    double currentSampleRate = 44100.0;
+
+    std::array<PadTone, kNumPads>               editTones;   // message thread
+    TripleBuffer<std::array<PadTone, kNumPads>> published;
+    bool anyActive = false;                                  // audio thread
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PadToneBank)
+};
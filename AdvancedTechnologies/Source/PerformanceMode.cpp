@@ -0,0 +1,228 @@
+/*
+  ==============================================================================
+    PerformanceMode.cpp
+  ==============================================================================
+*/
+
+#include "PerformanceMode.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if JUCE_LINUX
+ #include <pthread.h>
+ #include <sched.h>
+ #include <sys/mman.h>
+ #include <sys/resource.h>
+ #if defined (__GLIBC__)
+  #include <malloc.h>
+ #endif
+#endif
+
+namespace
+{
+    constexpr int kRealtimePriority = 80;    // below the kernel's IRQ threads, like JACK
+    constexpr int kUnsupported      = -2;    // error value: not available on this platform
+
+    juce::String describeBytes (size_t numBytes)
+    {
+        return juce::File::descriptionOfSizeInBytes ((juce::int64) numBytes);
+    }
+
+    int getRealtimePriorityLimit()
+    {
+       #if JUCE_LINUX
+        rlimit limit {};
+
+        if (getrlimit (RLIMIT_RTPRIO, &limit) == 0)
+            return limit.rlim_cur == RLIM_INFINITY ? 99 : (int) limit.rlim_cur;
+       #endif
+
+        return 0;
+    }
+}
+
+PerformanceMode::Options PerformanceMode::Options::fromCommandLine (const juce::String& commandLine)
+{
+    Options options;
+    options.enabled = commandLine.contains ("--performance-mode");
+
+    for (const auto& arg : juce::StringArray::fromTokens (commandLine, true))
+        if (arg.startsWith ("--audio-cpu="))
+            options.audioCpu = arg.fromFirstOccurrenceOf ("=", false, false).getIntValue();
+
+    return options;
+}
+
+PerformanceMode::PerformanceMode (const Options& options)
+    : audioCpu (options.audioCpu)
+{
+}
+
+//==============================================================================
+void PerformanceMode::audioDeviceIOCallbackWithContext (const float* const*, int,
+                                                        float* const* outputChannelData, int numOutputChannels,
+                                                        int numSamples,
+                                                        const juce::AudioIODeviceCallbackContext&)
+{
+    // The device manager sums every callback's output, so ours must be silence
+    for (int channel = 0; channel < numOutputChannels; ++channel)
+        if (outputChannelData[channel] != nullptr)
+            juce::FloatVectorOperations::clear (outputChannelData[channel], numSamples);
+
+    const auto thisThread = juce::Thread::getCurrentThreadId();
+
+    if (configuredThread.load() != thisThread)
+    {
+        configuredThread.store (thisThread);
+        configureAudioThread();
+    }
+}
+
+void PerformanceMode::audioDeviceAboutToStart (juce::AudioIODevice*)
+{
+    // The device may bring a new thread with it — configure that one too
+    configuredThread.store (nullptr);
+    prefaultHeap();
+}
+
+//==============================================================================
+void PerformanceMode::configureAudioThread()
+{
+    prefaultStack();
+
+   #if JUCE_LINUX
+    const auto self = pthread_self();
+
+    // -------------------------------------------------------------------------
+    // CONCEPT: SCHED_FIFO threads run before every normal thread and are
+    // never time-sliced against them, so a compile job or a browser can't
+    // delay the callback. Some backends (JACK) already run us this way.
+    // -------------------------------------------------------------------------
+    int policy = 0;
+    sched_param param {};
+
+    if (pthread_getschedparam (self, &policy, &param) == 0 && (policy == SCHED_FIFO || policy == SCHED_RR))
+    {
+        alreadyRealtime.store (true);
+        priority.store (param.sched_priority);
+        schedulingError.store (0);
+    }
+    else
+    {
+        param.sched_priority = juce::jmin (kRealtimePriority, sched_get_priority_max (SCHED_FIFO));
+        priority.store (param.sched_priority);
+        schedulingError.store (pthread_setschedparam (self, SCHED_FIFO, &param)); // returns the error number
+    }
+
+    // -------------------------------------------------------------------------
+    // Pinning keeps the thread's cache warm and off the core the scheduler
+    // is busy balancing. The last core is usually the least contended.
+    // -------------------------------------------------------------------------
+    const int numCpus = juce::SystemStats::getNumCpus();
+    const int cpu     = audioCpu >= 0 ? juce::jmin (audioCpu, numCpus - 1) : numCpus - 1;
+
+    cpu_set_t cpus;
+    CPU_ZERO (&cpus);
+    CPU_SET (cpu, &cpus);
+
+    pinnedCpu.store (cpu);
+    affinityError.store (pthread_setaffinity_np (self, sizeof (cpus), &cpus));
+   #else
+    schedulingError.store (kUnsupported);
+    affinityError.store (kUnsupported);
+   #endif
+}
+
+void PerformanceMode::prefaultStack()
+{
+    // Touching one byte per page of a large local array maps that much stack
+    // below the callback, so deeper calls later never fault
+    volatile char stack[kStackPrefaultBytes];
+
+    for (size_t i = 0; i < kStackPrefaultBytes; i += 4096)
+        stack[i] = 0;
+
+   #if JUCE_LINUX
+    stackLockError.store (mlock (const_cast<char*> (stack), kStackPrefaultBytes) == 0 ? 0 : errno);
+   #else
+    stackLockError.store (kUnsupported);
+   #endif
+}
+
+void PerformanceMode::prefaultHeap()
+{
+    if (heapPrefaulted.load())
+        return;
+
+   #if JUCE_LINUX && defined (__GLIBC__)
+    // -------------------------------------------------------------------------
+    // By default glibc returns freed memory to the kernel (trimming) and
+    // serves large requests with fresh mmaps — both mean new page faults on
+    // the next allocation. Turning both off lets the pages we touch below be
+    // reused by every later allocation, wherever it happens.
+    // -------------------------------------------------------------------------
+    mallopt (M_TRIM_THRESHOLD, -1);
+    mallopt (M_MMAP_MAX, 0);
+   #endif
+
+    if (auto* bytes = static_cast<volatile char*> (std::malloc (kHeapPrefaultBytes)))
+    {
+        for (size_t i = 0; i < kHeapPrefaultBytes; i += 4096)
+            bytes[i] = 0;
+
+        std::free (const_cast<char*> (bytes));
+    }
+
+    heapPrefaulted.store (true);
+}
+
+//==============================================================================
+juce::StringArray PerformanceMode::getReport() const
+{
+    juce::StringArray lines;
+
+    // Memory --------------------------------------------------------------------
+    const auto locked   = arena.getLockedBytes();
+    const auto unlocked = arena.getUnlockedBytes();
+    auto memory = "Memory: " + describeBytes (locked) + " locked";
+
+    if (unlocked > 0)
+    {
+        const auto limit = LockedArena::getLockLimitBytes();
+        memory << ", " << describeBytes (unlocked) << " NOT locked (" << arena.getLastError()
+               << (limit > 0 ? "; lock limit is " + describeBytes (limit) + ", raise it with ulimit -l" : juce::String())
+               << ")";
+    }
+
+    lines.add (memory);
+
+    lines.add (heapPrefaulted.load() ? "Heap: " + describeBytes (kHeapPrefaultBytes) + " pre-faulted, malloc trimming off"
+                                     : juce::String ("Heap: waiting for the audio device to start"));
+
+    // Audio thread ----------------------------------------------------------------
+    const auto describeError = [] (int error, const juce::String& success) -> juce::String
+    {
+        if (error == -1)           return "waiting for the first audio callback";
+        if (error == kUnsupported) return "not supported on this platform";
+        if (error == 0)            return success;
+        return "REFUSED (" + juce::String (std::strerror (error)) + ")";
+    };
+
+    lines.add ("Stack: " + describeError (stackLockError.load(),
+                                          describeBytes (kStackPrefaultBytes) + " pre-faulted and locked"));
+
+    auto scheduling = "Scheduling: " + describeError (schedulingError.load(),
+                                                     alreadyRealtime.load() ? "already realtime, priority " + juce::String (priority.load())
+                                                                            : "SCHED_FIFO priority " + juce::String (priority.load()));
+
+    if (schedulingError.load() > 0)
+        scheduling << " - needs CAP_SYS_NICE or an rtprio limit of " << priority.load()
+                   << " (currently " << getRealtimePriorityLimit() << ")";
+
+    lines.add (scheduling);
+
+    lines.add ("Affinity: " + describeError (affinityError.load(), "audio thread pinned to CPU " + juce::String (pinnedCpu.load())));
+
+    return lines;
+}
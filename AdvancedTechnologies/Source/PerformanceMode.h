@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+    PerformanceMode.h
+    Opt-in setup for machines where page faults and scheduling cause xruns.
+    Enabled with:
+
+        AdvancedTechnologies --performance-mode [--audio-cpu=3]
+
+    It does four things:
+      - Owns the LockedArena that the drum samples and mix buffers come from
+      - Pre-faults the heap when the device starts, and tells malloc to keep
+        those pages instead of handing them back to the kernel
+      - Pre-faults and locks a slice of the audio thread's stack
+      - Asks for SCHED_FIFO priority and pins the audio thread to one CPU
+
+    CONCEPT: JUCE creates the audio thread inside the device, so we can't
+             configure it when it is created. Instead this class is added to
+             the AudioDeviceManager as one more (silent) audio callback: the
+             first time it runs on a new thread, it configures THAT thread.
+             These are system calls — not real-time safe — but they happen
+             once per device start, before any sound has been made.
+
+    Every step can be refused by the system (limits.conf, missing
+    CAP_SYS_NICE, containers). Nothing is retried silently: getReport()
+    says what was granted and what wasn't, and why.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "LockedArena.h"
+
+class PerformanceMode : public juce::AudioIODeviceCallback
+{
+public:
+    struct Options
+    {
+        bool enabled  = false;
+        int  audioCpu = -1;     // -1 = the last CPU
+
+        static Options fromCommandLine (const juce::String& commandLine);
+    };
+
+    explicit PerformanceMode (const Options& options);
+
+    LockedArena& getArena() { return arena; }
+
+    // One line per item, for the status bar and the log (message thread)
+    juce::StringArray getReport() const;
+
+    //--------------------------------------------------------------------------
+    // AudioIODeviceCallback interface
+    //--------------------------------------------------------------------------
+    void audioDeviceIOCallbackWithContext (const float* const* inputChannelData, int numInputChannels,
+                                           float* const* outputChannelData, int numOutputChannels,
+                                           int numSamples,
+                                           const juce::AudioIODeviceCallbackContext& context) override;
+    void audioDeviceAboutToStart (juce::AudioIODevice* device) override;
+    void audioDeviceStopped() override {}
+
+private:
+    // Audio thread, first callback after each device start
+    void configureAudioThread();
+    void prefaultStack();
+
+    void prefaultHeap();
+
+    static constexpr size_t kStackPrefaultBytes = 256 * 1024;
+    static constexpr size_t kHeapPrefaultBytes  = 32 * 1024 * 1024;
+
+    LockedArena       arena;
+    const int         audioCpu;
+    std::atomic<bool> heapPrefaulted { false };
+
+    // -------------------------------------------------------------------------
+    // Results, written by the audio thread and read by getReport().
+    // An error value of -1 means "not tried yet"; 0 means success.
+    // -------------------------------------------------------------------------
+    std::atomic<juce::Thread::ThreadID> configuredThread { nullptr };
+    std::atomic<int>  schedulingError  { -1 };
+    std::atomic<int>  priority         { 0 };
+    std::atomic<bool> alreadyRealtime  { false };
+    std::atomic<int>  affinityError    { -1 };
+    std::atomic<int>  pinnedCpu        { -1 };
+    std::atomic<int>  stackLockError   { -1 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PerformanceMode)
+};
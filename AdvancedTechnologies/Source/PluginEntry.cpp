@@ -0,0 +1,18 @@
+/*
+  ==============================================================================
+    PluginEntry.cpp
+    Plugin entry point. Only compiled by AdvancedTechnologiesPlugin.jucer —
+    the standalone app has its own JUCEApplication in Main.cpp.
+
+    CONCEPT: JUCE's VST3 / LV2 wrappers call createPluginFilter() whenever a
+             host instantiates the plugin.
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "EngineProcessor.h"
+
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new EngineProcessor();
+}
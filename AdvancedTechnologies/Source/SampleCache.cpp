@@ -0,0 +1,203 @@
+/*
+  ==============================================================================
+    SampleCache.cpp
+  ==============================================================================
+*/
+
+#include "SampleCache.h"
+
+namespace
+{
+    constexpr const char* kEntryExtension = ".atsample";
+    constexpr juce::uint32 kFormatVersion = 1;
+
+    // Followed by numChannels planar runs of (numFrames + 2 * guardFrames) floats
+    struct EntryHeader
+    {
+        char         magic[8];
+        juce::uint32 version;
+        juce::uint32 numChannels;
+        juce::int64  numFrames;
+        juce::int64  sourceSize;
+        juce::int64  sourceModified;    // ms since 1970
+        double       sampleRate;
+        juce::uint32 guardFrames;
+        juce::uint32 reserved[3];
+    };
+
+    static_assert (sizeof (EntryHeader) == 64, "keeps the audio 64-byte aligned in the mapping");
+
+    const char kMagic[8] = { 'A', 'T', 'S', 'A', 'M', 'P', 'L', 'E' };
+
+    juce::int64 getEntrySize (const EntryHeader& header)
+    {
+        return (juce::int64) sizeof (EntryHeader)
+             + (juce::int64) sizeof (float) * header.numChannels * (header.numFrames + 2 * (juce::int64) header.guardFrames);
+    }
+}
+
+//==============================================================================
+float* SampleCache::Mapped::getChannel (int channel) const
+{
+    auto* audio = static_cast<const char*> (mapping->getData()) + sizeof (EntryHeader);
+    auto* first = reinterpret_cast<const float*> (audio) + (size_t) channel * (size_t) (numFrames + 2 * guardFrames);
+
+    return const_cast<float*> (first);
+}
+
+//==============================================================================
+SampleCache::SampleCache (const juce::File& dir, juce::int64 maxSize)
+    : directory (dir),
+      maxBytes (maxSize)
+{
+}
+
+juce::File SampleCache::getDefaultDirectory()
+{
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+               .getChildFile ("AdvancedTechnologies")
+               .getChildFile ("SampleCache");
+}
+
+bool SampleCache::isWorthCaching (const juce::File& source)
+{
+    return ! source.hasFileExtension ("wav;aif;aiff");
+}
+
+juce::File SampleCache::getEntryFile (const juce::File& source) const
+{
+    return directory.getChildFile (juce::String::toHexString (source.getFullPathName().hashCode64()) + kEntryExtension);
+}
+
+//==============================================================================
+std::unique_ptr<SampleCache::Mapped> SampleCache::open (const juce::File& source, int guardFrames) const
+{
+    const auto entryFile = getEntryFile (source);
+
+    if (! entryFile.existsAsFile())
+        return nullptr;
+
+    auto mapping = std::make_unique<juce::MemoryMappedFile> (entryFile, juce::MemoryMappedFile::readOnly);
+
+    if (mapping->getData() == nullptr || mapping->getSize() < sizeof (EntryHeader))
+        return nullptr;
+
+    EntryHeader header;
+    std::memcpy (&header, mapping->getData(), sizeof (header));
+
+    // -------------------------------------------------------------------------
+    // Anything unexpected means a miss: the caller decodes and rewrites it
+    // -------------------------------------------------------------------------
+    if (std::memcmp (header.magic, kMagic, sizeof (kMagic)) != 0
+        || header.version != kFormatVersion
+        || header.sourceSize != source.getSize()
+        || header.sourceModified != source.getLastModificationTime().toMilliseconds()
+        || header.guardFrames != (juce::uint32) guardFrames
+        || header.numChannels == 0
+        || header.numFrames <= 0 || header.numFrames > std::numeric_limits<int>::max() / 2
+        || getEntrySize (header) != (juce::int64) mapping->getSize())
+        return nullptr;
+
+    // Recently used: the size cap removes it last
+    entryFile.setLastModificationTime (juce::Time::getCurrentTime());
+
+    auto mapped = std::make_unique<Mapped>();
+    mapped->mapping     = std::move (mapping);
+    mapped->numChannels = (int) header.numChannels;
+    mapped->numFrames   = (int) header.numFrames;
+    mapped->guardFrames = guardFrames;
+    mapped->sampleRate  = header.sampleRate;
+    return mapped;
+}
+
+bool SampleCache::store (const juce::File& source, const juce::AudioBuffer<float>& data,
+                         int guardFrames, double sampleRate)
+{
+    if (! directory.createDirectory())
+        return false;
+
+    EntryHeader header {};
+    std::memcpy (header.magic, kMagic, sizeof (kMagic));
+    header.version        = kFormatVersion;
+    header.numChannels    = (juce::uint32) data.getNumChannels();
+    header.numFrames      = data.getNumSamples() - 2 * guardFrames;
+    header.sourceSize     = source.getSize();
+    header.sourceModified = source.getLastModificationTime().toMilliseconds();
+    header.sampleRate     = sampleRate;
+    header.guardFrames    = (juce::uint32) guardFrames;
+
+    if (header.numChannels == 0 || header.numFrames <= 0)
+        return false;
+
+    // -------------------------------------------------------------------------
+    // Written under a temporary name and renamed into place, so nobody can
+    // map a half-written entry
+    // -------------------------------------------------------------------------
+    const auto entryFile = getEntryFile (source);
+    const auto tempFile  = entryFile.getSiblingFile (entryFile.getFileName() + ".tmp").getNonexistentSibling();
+
+    bool written = false;
+
+    {
+        juce::FileOutputStream out (tempFile);
+
+        if (! out.openedOk())
+            return false;
+
+        out.write (&header, sizeof (header));
+
+        for (int channel = 0; channel < data.getNumChannels(); ++channel)
+            out.write (data.getReadPointer (channel), sizeof (float) * (size_t) data.getNumSamples());
+
+        out.flush();
+        written = out.getStatus().wasOk();
+    }
+
+    if (! written)
+    {
+        tempFile.deleteFile();   // e.g. the disk is full
+        return false;
+    }
+
+    if (! tempFile.moveFileTo (entryFile))
+    {
+        tempFile.deleteFile();
+        return false;
+    }
+
+    trim();
+    return true;
+}
+
+void SampleCache::trim()
+{
+    const juce::ScopedLock sl (trimLock);
+
+    auto entries = directory.findChildFiles (juce::File::findFiles, false, juce::String ("*") + kEntryExtension);
+
+    juce::int64 totalBytes = 0;
+
+    for (const auto& entry : entries)
+        totalBytes += entry.getSize();
+
+    if (totalBytes <= maxBytes)
+        return;
+
+    // Oldest first
+    std::sort (entries.begin(), entries.end(), [] (const juce::File& a, const juce::File& b)
+    {
+        return a.getLastModificationTime() < b.getLastModificationTime();
+    });
+
+    for (const auto& entry : entries)
+    {
+        if (totalBytes <= maxBytes)
+            break;
+
+        const auto size = entry.getSize();
+
+        // A mapped entry may refuse (Windows); it goes on a later trim
+        if (entry.deleteFile())
+            totalBytes -= size;
+    }
+}
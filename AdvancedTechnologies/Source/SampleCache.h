@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+    SampleCache.h
+    An on-disk cache of decoded samples, so compressed kits (FLAC, Ogg) are
+    decoded once rather than on every launch.
+
+    CONCEPT: Decoding FLAC or Vorbis is CPU work on every sample, and a big
+             kit can take minutes. The decoded result never changes while
+             the file doesn't, so we keep it: one flat file per sample, a
+             64-byte header followed by each channel's floats, laid out
+             exactly as SamplePlayer holds them in memory (guard frames
+             included). Loading is then a memory map — no parsing, no
+             conversion, and pages come in from disk as they are first read.
+
+    Invalidation: entries are named after the source's path and record its
+    size and modification time; if either differs the entry is ignored and
+    rewritten. (Hashing the whole source file would mean reading every
+    compressed byte on every launch, which is most of what we're avoiding.)
+
+    Size cap: after each write the least recently used entries are deleted
+    until the folder fits. Using an entry refreshes its timestamp.
+
+    The files are in native byte order: a cache belongs to one machine.
+
+    Threads: any. Pads load on several threads at once; writes go through
+             a temporary file and a rename, and trimming is serialised.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+class SampleCache
+{
+public:
+    static constexpr juce::int64 kDefaultMaxBytes = (juce::int64) 2 << 30;    // 2 GB
+
+    //==========================================================================
+    // A cache entry mapped into memory. Channel data stays valid for as long
+    // as this object exists.
+    //==========================================================================
+    class Mapped
+    {
+    public:
+        int    getNumChannels() const   { return numChannels; }
+        int    getNumFrames() const     { return numFrames; }       // excluding guards
+        int    getGuardFrames() const   { return guardFrames; }
+        double getSampleRate() const    { return sampleRate; }
+
+        // Starts with the channel's leading guard frames. Non-const only so
+        // an AudioBuffer can refer to it: the mapping is read-only, and
+        // writing through this pointer would crash.
+        float* getChannel (int channel) const;
+
+    private:
+        friend class SampleCache;
+
+        std::unique_ptr<juce::MemoryMappedFile> mapping;
+        int    numChannels = 0;
+        int    numFrames   = 0;
+        int    guardFrames = 0;
+        double sampleRate  = 0.0;
+    };
+
+    explicit SampleCache (const juce::File& directory = getDefaultDirectory(),
+                          juce::int64 maxBytes = kDefaultMaxBytes);
+
+    static juce::File getDefaultDirectory();
+
+    // Uncompressed formats load about as fast as the cache would, so only
+    // compressed ones are cached
+    static bool isWorthCaching (const juce::File& source);
+
+    // The entry for source, or nullptr if there is none, it's stale, or its
+    // guard size differs
+    std::unique_ptr<Mapped> open (const juce::File& source, int guardFrames) const;
+
+    // Saves decoded audio for source. data holds guardFrames of silence at
+    // each end of every channel. Returns false if it couldn't be written.
+    bool store (const juce::File& source, const juce::AudioBuffer<float>& data,
+                int guardFrames, double sampleRate);
+
+private:
+    juce::File getEntryFile (const juce::File& source) const;
+    void trim();
+
+    const juce::File        directory;
+    const juce::int64       maxBytes;
+    juce::CriticalSection   trimLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleCache)
+};
@@ -0,0 +1,180 @@
+/*
+  ==============================================================================
+    SampleMemoryManager.cpp
+  ==============================================================================
+*/
+
+#include "SampleMemoryManager.h"
+#include "Trace.h"
+
+SampleMemoryManager::SampleMemoryManager()
+    : Thread ("Sample memory manager")
+{
+    startThread();
+}
+
+SampleMemoryManager::~SampleMemoryManager()
+{
+    // A reload in progress finishes; the thread never dies holding a lock
+    stopThread (-1);
+}
+
+size_t SampleMemoryManager::getDefaultBudget()
+{
+    return (size_t) juce::SystemStats::getMemorySizeInMegabytes() / 4 * 1024 * 1024;
+}
+
+void SampleMemoryManager::addKit (const void* kit, const juce::String& name, std::vector<SamplePlayer*> players)
+{
+    const juce::ScopedLock sl (kitLock);
+
+    for (auto& existing : kits)
+    {
+        if (existing.kit == kit)
+        {
+            existing.name    = name;
+            existing.players = std::move (players);
+            return;
+        }
+    }
+
+    kits.push_back ({ kit, name, std::move (players) });
+}
+
+void SampleMemoryManager::removeKit (const void* kit)
+{
+    // A pass in progress may be decoding into this kit's players
+    const juce::ScopedLock passScope (passLock);
+    const juce::ScopedLock sl (kitLock);
+
+    kits.erase (std::remove_if (kits.begin(), kits.end(), [kit] (const Kit& k) { return k.kit == kit; }),
+                kits.end());
+}
+
+std::vector<SampleMemoryManager::KitStats> SampleMemoryManager::getKitStats() const
+{
+    const juce::ScopedLock sl (kitLock);
+
+    std::vector<KitStats> stats;
+
+    for (const auto& kit : kits)
+    {
+        KitStats kitStats;
+        kitStats.kit  = kit.kit;
+        kitStats.name = kit.name;
+
+        for (const auto* player : kit.players)
+        {
+            kitStats.bytes += player->getMemoryBytes();
+
+            if (player->getMemoryBytes() > 0)
+                ++kitStats.numLoaded;
+
+            if (player->isEvicted())
+                ++kitStats.numEvicted;
+        }
+
+        stats.push_back (kitStats);
+    }
+
+    return stats;
+}
+
+size_t SampleMemoryManager::getTotalBytes() const
+{
+    size_t total = 0;
+
+    for (const auto& kit : getKitStats())
+        total += kit.bytes;
+
+    return total;
+}
+
+//==============================================================================
+void SampleMemoryManager::run()
+{
+    while (! threadShouldExit())
+    {
+        runPass();
+        wait (kPassIntervalMs);
+    }
+}
+
+void SampleMemoryManager::runPass()
+{
+    // -------------------------------------------------------------------------
+    // kitLock only guards the list, and is held just long enough to copy it:
+    // the UI takes it for getKitStats() and mustn't wait out a decode.
+    // passLock keeps removeKit() (and so the players) away until we're done.
+    // -------------------------------------------------------------------------
+    const juce::ScopedLock passScope (passLock);
+
+    std::vector<SamplePlayer*> players;
+
+    {
+        const juce::ScopedLock sl (kitLock);
+
+        for (const auto& kit : kits)
+            players.insert (players.end(), kit.players.begin(), kit.players.end());
+    }
+
+    // -------------------------------------------------------------------------
+    // Housekeeping first: free what the audio thread let go of, and bring
+    // back every evicted pad that was hit since the last pass
+    // -------------------------------------------------------------------------
+    size_t total = 0;
+
+    for (auto* player : players)
+    {
+        player->collectGarbage();
+
+        // A take that just landed gives back the unused end of its reservation
+        player->compactCapture();
+
+        if (player->wantsReload())
+        {
+            AT_TRACE_SCOPE ("Reload evicted sample");
+            player->reload();
+        }
+
+        total += player->getMemoryBytes();
+    }
+
+    const size_t limit = budget.load();
+
+    if (limit == 0 || total <= limit)
+        return;
+
+    // -------------------------------------------------------------------------
+    // Over budget: evict the pads idle longest. A counter difference stays
+    // right across the millisecond counter's wrap.
+    //
+    // A pad whose last swap hasn't landed is skipped: its audio callback
+    // may never come (a suspended plugin, a closed device), and that mustn't
+    // stop every other kit from being evicted. Its copies both stay in the
+    // total until then, which only errs towards staying under budget.
+    // -------------------------------------------------------------------------
+    const auto now = juce::Time::getMillisecondCounter();
+
+    players.erase (std::remove_if (players.begin(), players.end(), [now] (const SamplePlayer* player)
+                   {
+                       return player->isEvicted() || player->isSwapPending()
+                              || now - player->getLastTriggerMs() < kMinIdleMs;
+                   }),
+                   players.end());
+
+    std::sort (players.begin(), players.end(), [now] (const SamplePlayer* a, const SamplePlayer* b)
+    {
+        return now - a->getLastTriggerMs() > now - b->getLastTriggerMs();
+    });
+
+    for (auto* player : players)
+    {
+        if (total <= limit)
+            break;
+
+        // The memory itself goes a pass later, once the audio thread has
+        // swapped in the head and let go of the full sample
+        total -= juce::jmin (total, player->evictToHead (kHeadSeconds));
+    }
+}
@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+    SampleMemoryManager.h
+    Counts the memory every loaded kit's samples take, and keeps the total
+    under a budget by evicting the pads nobody has played for a while.
+
+    CONCEPT: A set list means several kits loaded at once, and most of their
+             pads are silent most of the time. Only the start of a sample
+             has to be in RAM for a hit to sound on time: an evicted pad
+             keeps a short head (kHeadSeconds after its playback start),
+             and the rest is decoded again — from the SampleCache when it
+             was compressed — the moment it is hit. The head plays while
+             that happens; the full sample takes over under the same voice.
+
+    CONCEPT: Least recently triggered goes first. Over budget, the manager
+             evicts pads in order of their last hit (never hit counts from
+             the load) until the total fits. A pad hit within the last
+             kMinIdleMs is left alone, so a groove never thrashes.
+
+    One manager per process (SharedResourcePointer): every DrumEngine —
+    the app's page, or each plugin instance in a host — registers its pads
+    as a kit, and the budget covers them all. Its thread checks every
+    kPassIntervalMs.
+
+    Threads: any for the public functions. Eviction, reloading and freeing
+             happen on the manager's thread; the audio thread only swaps
+             pointers (SamplePlayer::adoptPendingSample()).
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "SamplePlayer.h"
+
+class SampleMemoryManager : private juce::Thread
+{
+public:
+    static constexpr double       kHeadSeconds    = 0.5;
+    static constexpr juce::uint32 kMinIdleMs      = 2000;
+    static constexpr int          kPassIntervalMs = 20;
+
+    struct KitStats
+    {
+        const void*  kit = nullptr;     // as passed to addKit()
+        juce::String name;
+        size_t       bytes      = 0;
+        int          numLoaded  = 0;
+        int          numEvicted = 0;
+    };
+
+    SampleMemoryManager();
+    ~SampleMemoryManager() override;
+
+    // A quarter of the machine's RAM: 1 GB on a 4 GB laptop
+    static size_t getDefaultBudget();
+
+    // Bytes all kits together may use; 0 = no limit. Going under the
+    // current total evicts on the next pass.
+    void   setBudget (size_t bytes)    { budget.store (bytes); }
+    size_t getBudget() const           { return budget.load(); }
+
+    // Registers (or renames) a kit. Its players must stay alive until
+    // removeKit(), which waits for a pass in progress to finish (including
+    // any reload it is decoding). getKitStats() never waits for a decode.
+    void addKit (const void* kit, const juce::String& name, std::vector<SamplePlayer*> players);
+    void removeKit (const void* kit);
+
+    std::vector<KitStats> getKitStats() const;
+    size_t                getTotalBytes() const;
+
+private:
+    void run() override;
+    void runPass();
+
+    struct Kit
+    {
+        const void*                kit = nullptr;
+        juce::String               name;
+        std::vector<SamplePlayer*> players;
+    };
+
+    std::vector<Kit>      kits;
+    juce::CriticalSection kitLock;     // the list only; never held across a decode
+    juce::CriticalSection passLock;    // held for a whole pass; taken before kitLock
+    std::atomic<size_t>   budget { getDefaultBudget() };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleMemoryManager)
+};
@@ -6,53 +6,889 @@
 
 #include "SamplePlayer.h"
 
+#include <cstring>
+
+namespace
+{
+    //==========================================================================
+    // CONCEPT: A windowed-sinc interpolator is a low-pass filter evaluated at
+    // a fractional position. Computing sin() and the window per tap per
+    // sample would be far too slow, so the 16 coefficients are tabulated for
+    // kSincPhases positions between two samples; at run time we blend the
+    // two nearest rows.
+    //
+    // Reading faster than 1:1 squeezes the spectrum up, so content near the
+    // old Nyquist would alias. The cutoff has to come down to 0.9 / increment
+    // of the source's Nyquist, and no further, or shifts up lose their top
+    // end for nothing. So there is a band every kSincBandsPerOctave-th of an
+    // octave up to 4x (the whole ±24 semitone range), each cut for the
+    // increment at its upper edge: a voice uses the first band whose edge
+    // is at or above its increment, at most a sixth of an octave darker
+    // than ideal. Band 0 covers increments up to 1 (no shift, or down).
+    //==========================================================================
+    constexpr int kSincTaps           = 16;
+    constexpr int kSincCentre         = kSincTaps / 2 - 1;   // tap that reads the sample at the index
+    constexpr int kSincPhases         = 256;
+    constexpr int kSincBandsPerOctave = 6;
+    constexpr int kSincBands          = 2 * kSincBandsPerOctave + 1;
+
+    struct SincTable
+    {
+        struct alignas (64) Row { float c[kSincTaps]; };
+
+        // kSincPhases + 1 rows, so phase + 1 is always valid
+        std::array<std::array<Row, kSincPhases + 1>, kSincBands> bands;
+
+        SincTable()
+        {
+            constexpr double beta = 8.0;   // Kaiser window: ~80 dB stop band
+
+            const auto besselI0 = [] (double x)
+            {
+                double sum = 1.0, term = 1.0;
+
+                for (int k = 1; k < 32; ++k)
+                {
+                    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                    sum  += term;
+                }
+
+                return sum;
+            };
+
+            for (int band = 0; band < kSincBands; ++band)
+            {
+                // Of the source's Nyquist, for the band's upper-edge increment
+                const double cutoff = 0.9 / std::exp2 ((double) band / kSincBandsPerOctave);
+
+                for (int phase = 0; phase <= kSincPhases; ++phase)
+                {
+                    auto& row = bands[(size_t) band][(size_t) phase];
+                    const double frac = (double) phase / kSincPhases;
+                    double sum = 0.0;
+
+                    for (int k = 0; k < kSincTaps; ++k)
+                    {
+                        const double t = (double) (k - kSincCentre) - frac;
+                        const double w = t / (kSincTaps / 2);
+                        const double window = std::abs (w) < 1.0 ? besselI0 (beta * std::sqrt (1.0 - w * w)) / besselI0 (beta) : 0.0;
+                        const double x = juce::MathConstants<double>::pi * cutoff * t;
+                        const double h = cutoff * (x == 0.0 ? 1.0 : std::sin (x) / x) * window;
+
+                        row.c[k] = (float) h;
+                        sum += h;
+                    }
+
+                    // Unity gain at DC, whatever the phase
+                    for (auto& c : row.c)
+                        c = (float) (c / sum);
+                }
+            }
+        }
+    };
+
+    const SincTable& getSincTable()
+    {
+        static const SincTable table;
+        return table;
+    }
+
+    //==========================================================================
+    // Readers: each returns the interpolated value at a fractional position.
+    // src points at frame 0 and may be read kGuardFrames either side.
+    //==========================================================================
+    struct DirectReader
+    {
+        float operator() (const float* src, double pos) const   { return src[(int) pos]; }
+    };
+
+    struct LinearReader
+    {
+        float operator() (const float* src, double pos) const
+        {
+            const int   index = (int) pos;
+            const float frac  = (float) (pos - index);
+            return src[index] + frac * (src[index + 1] - src[index]);
+        }
+    };
+
+    struct CubicReader
+    {
+        // 4-point, 3rd-order Hermite (Catmull-Rom)
+        float operator() (const float* src, double pos) const
+        {
+            const int   index = (int) pos;
+            const float frac  = (float) (pos - index);
+            const float xm1 = src[index - 1], x0 = src[index], x1 = src[index + 1], x2 = src[index + 2];
+
+            const float c1 = 0.5f * (x1 - xm1);
+            const float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+            const float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+
+            return ((c3 * frac + c2) * frac + c1) * frac + x0;
+        }
+    };
+
+    struct SincReader
+    {
+        const std::array<SincTable::Row, kSincPhases + 1>& rows;
+
+        float operator() (const float* src, double pos) const
+        {
+            const int    index  = (int) pos;
+            const float  phase  = (float) (pos - index) * (float) kSincPhases;
+            const int    row    = juce::jmin ((int) phase, kSincPhases - 1);
+            const float  blend  = phase - (float) row;
+            const float* a      = rows[(size_t) row].c;
+            const float* b      = rows[(size_t) row + 1].c;
+            const float* x      = src + index - kSincCentre;
+
+           #if JUCE_USE_SIMD
+            // -----------------------------------------------------------------
+            // The table rows are aligned; the audio isn't, so copy it into an
+            // aligned scratch first (the compiler turns this into unaligned
+            // vector loads). Then blend rows and multiply-accumulate kLanes
+            // taps per instruction.
+            // -----------------------------------------------------------------
+            using Vec = juce::dsp::SIMDRegister<float>;
+
+            alignas (64) float taps[kSincTaps];
+            std::memcpy (taps, x, sizeof (taps));
+
+            const auto mix = Vec::expand (blend);
+            auto acc = Vec::expand (0.0f);
+
+            for (int k = 0; k < kSincTaps; k += (int) Vec::size())
+            {
+                const auto ca = Vec::fromRawArray (a + k);
+                const auto cb = Vec::fromRawArray (b + k);
+                acc += (ca + mix * (cb - ca)) * Vec::fromRawArray (taps + k);
+            }
+
+            return acc.sum();
+           #else
+            // Four running sums break the add chain so it can pipeline
+            float acc[4] = {};
+
+            for (int k = 0; k < kSincTaps; k += 4)
+                for (int j = 0; j < 4; ++j)
+                    acc[j] += (a[k + j] + blend * (b[k + j] - a[k + j])) * x[k + j];
+
+            return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+           #endif
+        }
+    };
+}
+
 SamplePlayer::SamplePlayer()
 {
+    // Build the sinc table now, on the message thread, rather than on the
+    // first sinc-quality hit
+    getSincTable();
+
     // Register the built-in JUCE decoders (WAV, AIFF, and more with the
     // right flags in the Projucer).
     formatManager.registerBasicFormats();
 }
 
-bool SamplePlayer::loadSample (const juce::File& file)
+SamplePlayer::~SamplePlayer()
+{
+    delete current.exchange (nullptr);
+    delete pending.exchange (nullptr);
+    delete retired.exchange (nullptr);
+    delete reserved.exchange (nullptr);
+    delete captured.exchange (nullptr);
+    delete abandoned.exchange (nullptr);
+    delete filling;
+}
+
+size_t SamplePlayer::Sample::getBytes() const
+{
+    return sizeof (float) * (size_t) audio.getNumChannels() * (size_t) audio.getNumSamples();
+}
+
+bool SamplePlayer::loadSample (const juce::File& file, LockedArena* arena, SampleCache* cache)
+{
+    auto sample = decode (file, arena, cache);
+
+    if (sample == nullptr)
+        return false; // file not found or format not supported
+
+    install (std::move (sample), file.getFileNameWithoutExtension(), file, arena, cache);
+    return true;
+}
+
+std::unique_ptr<SamplePlayer::Sample> SamplePlayer::decode (const juce::File& file, LockedArena* arena, SampleCache* cache)
 {
+    if (cache != nullptr && SampleCache::isWorthCaching (file))
+        if (auto cached = loadFromCache (file, arena, *cache))
+            return cached;
+
     // createReaderFor() tries all registered formats in order
-    auto* reader = formatManager.createReaderFor (file);
+    std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (file));
 
     if (reader == nullptr)
-        return false; // file not found or format not supported
+        return nullptr;
+
+    // -------------------------------------------------------------------------
+    // CONCEPT: read() decodes the whole file into our buffer in one go.
+    // Drum hits are short, so keeping them in RAM is cheap.
+    // -------------------------------------------------------------------------
+    auto sample = std::make_unique<Sample>();
+    sample->numFrames  = (int) reader->lengthInSamples;
+    sample->sampleRate = reader->sampleRate;
+    sample->memory     = LockedArena::allocateBuffer (arena, sample->audio, (int) reader->numChannels,
+                                                      sample->numFrames + 2 * kGuardFrames);
+    reader->read (&sample->audio, kGuardFrames, sample->numFrames, 0, true, true);
+
+    if (cache != nullptr && SampleCache::isWorthCaching (file))
+        cache->store (file, sample->audio, kGuardFrames, sample->sampleRate);
+
+    return sample;
+}
+
+std::unique_ptr<SamplePlayer::Sample> SamplePlayer::loadFromCache (const juce::File& file, LockedArena* arena,
+                                                                   SampleCache& cache)
+{
+    auto cached = cache.open (file, kGuardFrames);
+
+    if (cached == nullptr)
+        return nullptr;
+
+    const int numChannels = cached->getNumChannels();
+    const int totalFrames = cached->getNumFrames() + 2 * kGuardFrames;
+
+    auto sample = std::make_unique<Sample>();
+    sample->numFrames  = cached->getNumFrames();
+    sample->sampleRate = cached->getSampleRate();
 
-    name = file.getFileNameWithoutExtension();
+    if (arena != nullptr)
+    {
+        // Copied: locked memory can't page-fault
+        sample->memory = LockedArena::allocateBuffer (arena, sample->audio, numChannels, totalFrames);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            sample->audio.copyFrom (channel, 0, cached->getChannel (channel), totalFrames);
+    }
+    else
+    {
+        // -------------------------------------------------------------------------
+        // CONCEPT: No copy at all: the audio points into the mapped file.
+        // The analysis at install reads every frame, which pulls the pages in
+        // then rather than on the audio thread at the first hit.
+        // -------------------------------------------------------------------------
+        std::vector<float*> channels;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            channels.push_back (cached->getChannel (channel));
+
+        sample->audio.setDataToReferTo (channels.data(), numChannels, totalFrames);
+        sample->mapped = std::move (cached);
+    }
+
+    return sample;
+}
+
+void SamplePlayer::setSample (const juce::AudioBuffer<float>& source, double sampleRate,
+                              const juce::String& newName, LockedArena* arena)
+{
+    auto sample = std::make_unique<Sample>();
+    sample->numFrames  = source.getNumSamples();
+    sample->sampleRate = sampleRate;
+    sample->memory     = LockedArena::allocateBuffer (arena, sample->audio, source.getNumChannels(),
+                                                      sample->numFrames + 2 * kGuardFrames);
+
+    for (int channel = 0; channel < source.getNumChannels(); ++channel)
+        sample->audio.copyFrom (channel, kGuardFrames, source, channel, 0, sample->numFrames);
+
+    install (std::move (sample), newName, {}, arena, nullptr);
+}
+
+void SamplePlayer::install (std::unique_ptr<Sample> sample, const juce::String& newName,
+                            const juce::File& source, LockedArena* arena, SampleCache* cache)
+{
+    buildPeakEnvelope (*sample);
+    const auto newInfo = analyse (*sample, trimLeadingSilence);
+
+    const juce::ScopedLock sl (sampleLock);
+
+    // Nothing is playing (see loadSample()), so all of these can go now.
+    // A capture reservation stays: the pad may still be armed.
+    for (auto* old : { current.exchange (nullptr), pending.exchange (nullptr),
+                       retired.exchange (nullptr), captured.exchange (nullptr) })
+    {
+        if (old != nullptr)
+            memoryBytes -= old->getBytes();
+
+        delete old;
+    }
+
+    memoryBytes += sample->getBytes();
+    current = sample.release();
+
+    info          = newInfo;
+    loaded        = true;
+    evicted       = false;
+    reloadWanted  = false;
+    lastTriggerMs = juce::Time::getMillisecondCounter();
+    name          = newName;
+    sourceFile    = source;
+    sourceArena   = arena;
+    sourceCache   = cache;
+    playing       = false;
+}
+
+//==============================================================================
+size_t SamplePlayer::evictToHead (double headSeconds)
+{
+    const juce::ScopedLock sl (sampleLock);
+
+    auto* sample = current.load();
+
+    if (sample == nullptr || sample->isHead || sample->isCapture || sourceFile == juce::File()
+         || pending.load() != nullptr || retired.load() != nullptr)
+        return 0;
+
+    const int headFrames = sample->startFrame + (int) (headSeconds * sample->sampleRate);
+
+    if (headFrames >= sample->numFrames)
+        return 0;   // shorter than a head anyway
 
     // -------------------------------------------------------------------------
-    // CONCEPT: AudioFormatReaderSource takes ownership of the reader.
-    // The second argument (shouldDeleteReader) = true means it will be freed.
+    // The head keeps the full sample's frame numbering, so a voice that
+    // started on it carries on seamlessly if the full sample comes back
+    // before it reaches the end of the head.
     // -------------------------------------------------------------------------
-    readerSource = std::make_unique<juce::AudioFormatReaderSource> (reader, true);
+    const int numChannels = sample->audio.getNumChannels();
+
+    auto head = std::make_unique<Sample>();
+    head->numFrames    = headFrames;
+    head->sampleRate   = sample->sampleRate;
+    head->isHead       = true;
+    head->startFrame   = sample->startFrame;
+    head->endFrame     = sample->endFrame;
+    head->peakEnvelope = sample->peakEnvelope;
+    head->generation   = sample->generation;
+    head->memory     = LockedArena::allocateBuffer (sourceArena, head->audio, numChannels,
+                                                    headFrames + 2 * kGuardFrames);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        head->audio.copyFrom (channel, 0, sample->audio, channel, 0, kGuardFrames + headFrames);
+        head->audio.clear (channel, kGuardFrames + headFrames, kGuardFrames);
+    }
+
+    const size_t freed = sample->getBytes() - head->getBytes();
+    memoryBytes += head->getBytes();
+    pending.store (head.release());
+    return freed;
+}
+
+bool SamplePlayer::reload()
+{
+    const juce::ScopedLock sl (sampleLock);
+
+    auto* sample = current.load();
+
+    if (sample == nullptr || ! sample->isHead)
+    {
+        reloadWanted = false;   // already whole, or a reload is waiting to be adopted
+        return false;
+    }
+
+    if (pending.load() != nullptr || retired.load() != nullptr)
+        return false;           // asked again on the next pass
+
+    auto full = decode (sourceFile, sourceArena, sourceCache);
+    reloadWanted = false;
+
+    if (full == nullptr)
+        return false;           // the file has gone: the head is all there is
+
+    buildPeakEnvelope (*full);
+    analyse (*full, info.trimmed);
+    full->generation = sample->generation;
+
+    memoryBytes += full->getBytes();
+    pending.store (full.release());
+    return true;
+}
+
+void SamplePlayer::collectGarbage()
+{
+    const juce::ScopedLock sl (sampleLock);
+
+    for (auto* old : { retired.exchange (nullptr), abandoned.exchange (nullptr) })
+    {
+        if (old != nullptr)
+            memoryBytes -= old->getBytes();
+
+        delete old;
+    }
+
+    // -------------------------------------------------------------------------
+    // A head or reload made before a take replaced the sample is for the old
+    // audio, and the audio thread won't adopt it. current can't be freed
+    // while we hold the lock: only this function deletes what it retires.
+    // -------------------------------------------------------------------------
+    auto* next = pending.load();
+
+    if (next != nullptr && current.load() != nullptr && next->generation != current.load()->generation)
+    {
+        pending = nullptr;
+        memoryBytes -= next->getBytes();
+        delete next;
+    }
+}
+
+bool SamplePlayer::compactCapture()
+{
+    const juce::ScopedLock sl (sampleLock);
+
+    auto* sample = current.load();
+
+    if (sample == nullptr || ! sample->isCapture
+         || sample->audio.getNumSamples() <= sample->numFrames + 2 * kGuardFrames
+         || pending.load() != nullptr || retired.load() != nullptr)
+        return false;
+
+    // Same frames, same numbering: a voice on the take carries straight on
+    const int numChannels = sample->audio.getNumChannels();
+
+    auto copy = std::make_unique<Sample>();
+    copy->numFrames    = sample->numFrames;
+    copy->sampleRate   = sample->sampleRate;
+    copy->isCapture    = true;
+    copy->startFrame   = sample->startFrame;
+    copy->endFrame     = sample->endFrame;
+    copy->peakEnvelope = sample->peakEnvelope;
+    copy->generation   = sample->generation;
+    copy->memory       = LockedArena::allocateBuffer (sourceArena, copy->audio, numChannels,
+                                                      sample->numFrames + 2 * kGuardFrames);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        copy->audio.copyFrom (channel, 0, sample->audio, channel, 0, sample->numFrames + 2 * kGuardFrames);
+
+    memoryBytes += copy->getBytes();
+    pending.store (copy.release());
+    return true;
+}
+
+//==============================================================================
+void SamplePlayer::reserveCapture (int numChannels, int maxFrames)
+{
+    const juce::ScopedLock sl (sampleLock);
+
+    auto take = std::make_unique<Sample>();
+    take->isCapture = true;
+    take->memory    = LockedArena::allocateBuffer (sourceArena, take->audio, juce::jmax (1, numChannels),
+                                                   juce::jmax (1, maxFrames) + 2 * kGuardFrames);
+
+    // The audio thread grows it block by block, which won't reallocate
+    take->peakEnvelope.reserve ((size_t) (maxFrames / kEnvelopeBlockSize + 1));
+
+    memoryBytes += take->getBytes();
+
+    if (auto* old = reserved.exchange (take.release()))
+    {
+        memoryBytes -= old->getBytes();
+        delete old;
+    }
+}
+
+void SamplePlayer::releaseCapture()
+{
+    const juce::ScopedLock sl (sampleLock);
+
+    if (auto* old = reserved.exchange (nullptr))
+    {
+        memoryBytes -= old->getBytes();
+        delete old;
+    }
+}
+
+bool SamplePlayer::beginCapture (double sampleRate)
+{
+    if (filling != nullptr || captured.load() != nullptr)
+        return false;
+
+    filling = reserved.exchange (nullptr);
 
-    // Set the reader into the transport, using the reader's sample rate for resampling
-    transportSource.setSource (readerSource.get(),
-                               0,            // read-ahead buffer size (0 = synchronous)
-                               nullptr,      // background thread (nullptr = synchronous)
-                               reader->sampleRate);
+    if (filling == nullptr)
+        return false;
+
+    filling->numFrames  = 0;
+    filling->sampleRate = sampleRate;
+    filling->peakEnvelope.clear();
     return true;
 }
 
-void SamplePlayer::trigger()
+int SamplePlayer::appendCapture (const float* const* input, int numInputs, int start, int count)
+{
+    if (filling == nullptr)
+        return 0;
+
+    auto& take = *filling;
+    const int position = take.numFrames;
+    count = juce::jmin (count, take.audio.getNumSamples() - 2 * kGuardFrames - position);
+
+    if (count <= 0)
+        return 0;
+
+    for (int channel = 0; channel < take.audio.getNumChannels(); ++channel)
+        take.audio.copyFrom (channel, kGuardFrames + position, input[juce::jmin (channel, numInputs - 1)] + start, count);
+
+    // Within what reserveCapture() reserved, so resize() won't allocate
+    take.numFrames += count;
+    take.peakEnvelope.resize ((size_t) (take.numFrames / kEnvelopeBlockSize + 1), 0.0f);
+    updatePeakEnvelope (take, position, take.numFrames);
+    return count;
+}
+
+bool SamplePlayer::finishCapture (int numFrames, int fadeFrames)
 {
+    auto* take = filling;
+
+    if (take == nullptr)
+        return false;
+
+    filling = nullptr;
+
+    take->numFrames = juce::jlimit (0, take->numFrames, numFrames);
+    const int fadeStart = take->numFrames - juce::jlimit (0, take->numFrames, fadeFrames);
+
+    for (int channel = 0; channel < take->audio.getNumChannels(); ++channel)
+    {
+        take->audio.applyGainRamp (channel, kGuardFrames + fadeStart, take->numFrames - fadeStart, 1.0f, 0.0f);
+        take->audio.clear (channel, kGuardFrames + take->numFrames, kGuardFrames);
+    }
+
+    // Only the blocks under the fade and the cut-off end have changed
+    auto& peakEnvelope = take->peakEnvelope;
+    const int firstBlock = fadeStart / kEnvelopeBlockSize;
+    peakEnvelope.resize ((size_t) (take->numFrames / kEnvelopeBlockSize + 1));
+    std::fill (peakEnvelope.begin() + firstBlock, peakEnvelope.end(), 0.0f);
+    updatePeakEnvelope (*take, firstBlock * kEnvelopeBlockSize, take->numFrames);
+
+    // The take starts at its threshold crossing already; no analysis
+    take->startFrame = 0;
+    take->endFrame   = take->numFrames;
+    take->generation = current.load() != nullptr ? current.load()->generation + 1 : 1;
+
+    captured = take;
+    return true;
+}
+
+bool SamplePlayer::abortCapture()
+{
+    if (filling == nullptr)
+        return true;
+
+    Sample* expected = nullptr;
+
+    if (! abandoned.compare_exchange_strong (expected, filling))
+        return false;
+
+    filling = nullptr;
+    return true;
+}
+
+void SamplePlayer::adoptPendingSample()
+{
+    // The previous swap must have been collected first
+    if (retired.load() != nullptr)
+        return;
+
+    if (auto* take = captured.load())
+    {
+        // A new take replaces whatever was there, under a voice or not
+        retired.store (current.load());
+        current.store (take);
+        captured.store (nullptr);
+        evicted = false;
+        loaded  = true;
+        playing = false;
+        return;
+    }
+
+    auto* next = pending.load();
+
+    if (next == nullptr || next->generation != current.load()->generation)
+        return;
+
+    // Swapping to the head under a voice would cut it off
+    if (next->isHead && playing)
+        return;
+
+    retired.store (current.load());
+    current.store (next);
+    evicted = next->isHead;
+    pending.store (nullptr);
+}
+
+//==============================================================================
+void SamplePlayer::buildPeakEnvelope (Sample& sample)
+{
+    // Peak envelope across all channels, one value per kEnvelopeBlockSize
+    sample.peakEnvelope.assign ((size_t) (sample.numFrames / kEnvelopeBlockSize + 1), 0.0f);
+    updatePeakEnvelope (sample, 0, sample.numFrames);
+}
+
+void SamplePlayer::updatePeakEnvelope (Sample& sample, int from, int to)
+{
+    for (int channel = 0; channel < sample.audio.getNumChannels(); ++channel)
+    {
+        for (int start = from; start < to;)
+        {
+            const int block = start / kEnvelopeBlockSize;
+            const int end   = juce::jmin (to, (block + 1) * kEnvelopeBlockSize);
+            const auto range = juce::FloatVectorOperations::findMinAndMax (sample.getFrames (channel) + start, end - start);
+
+            auto& peak = sample.peakEnvelope[(size_t) block];
+            peak = juce::jmax (peak, std::abs (range.getStart()), std::abs (range.getEnd()));
+            start = end;
+        }
+    }
+}
+
+SamplePlayer::SampleInfo SamplePlayer::analyse (Sample& sample, bool trim)
+{
+    const int numChannels = sample.audio.getNumChannels();
+    const int numFrames   = sample.numFrames;
+
+    SampleInfo info;
+    info.numFrames  = numFrames;
+    info.sampleRate = sample.sampleRate;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        info.peak = juce::jmax (info.peak, juce::FloatVectorOperations::findMaximum (sample.getFrames (channel), numFrames),
+                                -juce::FloatVectorOperations::findMinimum (sample.getFrames (channel), numFrames));
+
     // -------------------------------------------------------------------------
-    // CONCEPT: setPosition(0) rewinds, then start() begins playback.
-    // Both calls are safe from any thread once prepareToPlay has been called.
+    // CONCEPT: Thresholds relative to the peak, not absolute: a quiet rim
+    // shot's attack can sit below -48 dBFS, but 48 dB below its own peak is
+    // inaudible in any mix.
     // -------------------------------------------------------------------------
-    transportSource.setPosition (0.0);
-    transportSource.start();
+    const float onsetThreshold = info.peak * juce::Decibels::decibelsToGain (kOnsetThresholdDb);
+    const float tailThreshold  = info.peak * juce::Decibels::decibelsToGain (kTailThresholdDb);
+
+    int onset = numFrames;
+    int end   = 0;
+
+    for (int channel = 0; channel < numChannels && info.peak > 0.0f; ++channel)
+    {
+        const float* frames = sample.getFrames (channel);
+
+        for (int i = 0; i < onset; ++i)
+            if (std::abs (frames[i]) > onsetThreshold)
+            {
+                onset = i;
+                break;
+            }
+
+        for (int i = numFrames - 1; i >= end; --i)
+            if (std::abs (frames[i]) > tailThreshold)
+            {
+                end = i + 1;
+                break;
+            }
+    }
+
+    info.onsetFrame = juce::jmin (onset, end);
+    info.endFrame   = end;
+    info.trimmed    = trim;
+
+    double sumOfSquares = 0.0;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        for (int i = info.onsetFrame; i < info.endFrame; ++i)
+            sumOfSquares += (double) sample.getFrames (channel)[i] * sample.getFrames (channel)[i];
+
+    const int numMeasured = (info.endFrame - info.onsetFrame) * numChannels;
+    info.rms = numMeasured > 0 ? (float) std::sqrt (sumOfSquares / numMeasured) : 0.0f;
+
+    // A silent file has nothing to play: endFrame 0 retires it at once
+    sample.startFrame = info.trimmed ? info.onsetFrame : 0;
+    sample.endFrame   = info.endFrame;
+    return info;
 }
 
-void SamplePlayer::prepareToPlay (int samplesPerBlock, double sampleRate)
+void SamplePlayer::prepareToPlay (int /*samplesPerBlock*/, double sampleRate)
 {
-    transportSource.prepareToPlay (samplesPerBlock, sampleRate);
+    outputSampleRate = sampleRate;
+    playing          = false;
+
+    fadeLengthSamples = juce::jmax (1, (int) (sampleRate * 0.005)); // 5 ms
 }
 
 void SamplePlayer::releaseResources()
 {
-    transportSource.releaseResources();
+    playing = false;
+}
+
+void SamplePlayer::trigger (double pitchRatio)
+{
+    auto* sample = current.load();
+
+    if (sample == nullptr || sample->numFrames == 0)
+        return;
+
+    lastTriggerMs = juce::Time::getMillisecondCounter();
+
+    // The head covers the manager's next pass and the reload
+    if (sample->isHead)
+        reloadWanted = true;
+
+    increment = sample->sampleRate / outputSampleRate * pitchRatio;
+    position  = (double) sample->startFrame;
+    playing  = true;
+    fadeGain = 1.0f;
+    fadeStep = 0.0f;
+}
+
+void SamplePlayer::fastRelease()
+{
+    if (playing && fadeStep == 0.0f)
+        fadeStep = 1.0f / (float) fadeLengthSamples;
+}
+
+float SamplePlayer::getCurrentLevel() const
+{
+    if (! playing)
+        return 0.0f;
+
+    const auto& peakEnvelope = current.load()->peakEnvelope;
+
+    if (peakEnvelope.empty())
+        return 0.0f;
+
+    const auto block = juce::jmin ((size_t) position / (size_t) kEnvelopeBlockSize, peakEnvelope.size() - 1);
+    return peakEnvelope[block] * fadeGain;
+}
+
+//==============================================================================
+namespace
+{
+    // -------------------------------------------------------------------------
+    // CONCEPT: The fade, the send and the interpolator are decided once per
+    // block, and each combination gets its own copy of the loop via
+    // templates and "if constexpr" — so the per-sample loop never tests them.
+    // -------------------------------------------------------------------------
+    template <bool isFading, bool hasSend, typename Reader>
+    void renderVoiceChannel (const Reader& read, const float* src, float* dest, float* send, float sendGain,
+                             double pos, double increment, float gain, float fadeStep, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float value = read (src, pos);
+
+            if constexpr (isFading)
+            {
+                value *= gain;
+                gain = juce::jmax (0.0f, gain - fadeStep);
+            }
+
+            dest[i] += value;
+
+            if constexpr (hasSend)
+                send[i] += sendGain * value;
+
+            pos += increment;
+        }
+    }
+
+    template <typename Reader>
+    void renderChannel (const Reader& read, bool isFading, const float* src, float* dest, float* send, float sendGain,
+                             double pos, double increment, float gain, float fadeStep, int numSamples)
+    {
+        if (isFading)
+        {
+            if (send != nullptr) renderVoiceChannel<true, true>   (read, src, dest, send, sendGain, pos, increment, gain, fadeStep, numSamples);
+            else                 renderVoiceChannel<true, false>  (read, src, dest, send, sendGain, pos, increment, gain, fadeStep, numSamples);
+        }
+        else
+        {
+            if (send != nullptr) renderVoiceChannel<false, true>  (read, src, dest, send, sendGain, pos, increment, gain, fadeStep, numSamples);
+            else                 renderVoiceChannel<false, false> (read, src, dest, send, sendGain, pos, increment, gain, fadeStep, numSamples);
+        }
+    }
+
+    int getSincBand (double increment)
+    {
+        if (increment <= 1.0)
+            return 0;
+
+        // The first band edge 2^(band / kSincBandsPerOctave) >= increment
+        const int band = (int) std::ceil (std::log2 (increment) * kSincBandsPerOctave - 1.0e-9);
+        return juce::jmin (band, kSincBands - 1);
+    }
+}
+
+void SamplePlayer::renderNextBlock (juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                                    juce::AudioBuffer<float>* sendBuffer, float sendGain)
+{
+    if (! playing)
+        return;
+
+    const auto& sample = *current.load();
+
+    // Playback ends where the analysis found the tail inaudible, not at
+    // the end of the file — or where an evicted sample's head runs out
+    const int lastIndex       = juce::jmin (sample.endFrame, sample.numFrames) - 1;
+    const int numSrcChannels  = sample.audio.getNumChannels();
+    const int numOutChannels  = buffer.getNumChannels();
+    const int numSendChannels = (sendBuffer != nullptr && sendGain > 0.0f) ? sendBuffer->getNumChannels() : 0;
+
+    // How many output samples remain before we run off the end of the file
+    const int samplesLeft = (int) std::ceil ((lastIndex - position) / increment);
+    int numToRender       = juce::jlimit (0, numSamples, samplesLeft);
+
+    // A releasing voice also stops when its fade reaches zero
+    const bool isFading = fadeStep > 0.0f;
+
+    if (isFading)
+        numToRender = juce::jmin (numToRender, (int) std::ceil (fadeGain / fadeStep));
+
+    // Native pitch: every read lands exactly on a stored sample
+    const bool isDirect = increment == 1.0 && position == std::floor (position);
+    const int  sincBand = (! isDirect && quality == Interpolation::sinc) ? getSincBand (increment) : 0;
+
+    for (int channel = 0; channel < numOutChannels; ++channel)
+    {
+        // Mono files feed every output; extra outputs reuse the last channel
+        const float* src = sample.getFrames (juce::jmin (channel, numSrcChannels - 1));
+        float* dest = buffer.getWritePointer (channel, startSample);
+        float* send = channel < numSendChannels ? sendBuffer->getWritePointer (channel, startSample) : nullptr;
+
+        if (isDirect)
+        {
+            renderChannel (DirectReader(), isFading, src, dest, send, sendGain, position, increment, fadeGain, fadeStep, numToRender);
+            continue;
+        }
+
+        switch (quality)
+        {
+            case Interpolation::linear:
+                renderChannel (LinearReader(), isFading, src, dest, send, sendGain, position, increment, fadeGain, fadeStep, numToRender);
+                break;
+
+            case Interpolation::sinc:
+                renderChannel (SincReader { getSincTable().bands[(size_t) sincBand] },
+                               isFading, src, dest, send, sendGain, position, increment, fadeGain, fadeStep, numToRender);
+                break;
+
+            case Interpolation::cubic:
+            default:
+                renderChannel (CubicReader(), isFading, src, dest, send, sendGain, position, increment, fadeGain, fadeStep, numToRender);
+                break;
+        }
+    }
+
+    position += increment * numToRender;
+
+    if (isFading)
+        fadeGain = juce::jmax (0.0f, fadeGain - fadeStep * (float) numToRender);
+
+    if (numToRender < numSamples || position >= lastIndex || fadeGain <= 0.0f)
+        playing = false;
 }
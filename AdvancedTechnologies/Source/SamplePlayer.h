@@ -1,47 +1,314 @@
 /*
   ==============================================================================
     SamplePlayer.h
-    Loads a single .wav file and plays it back on demand.
+    Loads a single .wav file into memory and plays it back on demand.
 
     CONCEPT: AudioFormatManager knows about all registered file formats.
-             AudioFormatReaderSource wraps a reader for use as an AudioSource.
-             We mix multiple SamplePlayers via a MixerAudioSource.
+             We decode the whole file into an AudioBuffer once, at load time,
+             so playback never touches the disk. Because the voice is our own
+             code (not an AudioTransportSource) it can start on ANY sample
+             inside a block — DrumEngine splits the block at each hit.
+
+    CONCEPT: Pitch shifting by resampling. To play a fifth up, read the
+             sample 1.5x faster; the read position lands between stored
+             samples, so we interpolate. Quality levels trade CPU for
+             accuracy:
+               - linear : 2 points, cheapest, dulls highs and adds aliasing
+               - cubic  : 4-point Hermite, the usual sampler default
+               - sinc   : 16-tap Kaiser-windowed sinc from a precomputed
+                          table, computed with SIMD; band-limited, so shifts
+                          up stay free of aliasing
+             A voice at its native pitch (reading exactly one stored sample
+             per output sample) skips interpolation entirely, so untuned
+             pads cost the same as plain playback.
+
+    CONCEPT: Every sample is analysed once at load. Leading silence is
+             latency — a pad whose file starts with 5 ms of nothing sounds
+             5 ms late — so playback starts at the onset. And a long
+             near-silent tail keeps a voice rendering (and counting against
+             the voice limit) long after anyone can hear it, so the voice
+             retires where the tail drops below the threshold.
+
+    CONCEPT: The decoded audio lives in a Sample object that never changes
+             once built. To evict or reload, SampleMemoryManager builds a
+             new one and leaves it in `pending`; the audio thread adopts it
+             between blocks and parks the old one in `retired`, from where
+             the manager deletes it. The audio thread never allocates, frees
+             or waits for the thread that does.
+
+    CONCEPT: Live sampling uses the same hand-over from the other side. The
+             message thread reserves an empty Sample big enough for a take
+             when a pad is armed; the capturing audio callback writes the
+             take into it block by block as it comes in, peak envelope and
+             all, and at the end leaves it in `captured`. The pad adopts it
+             at the start of the next block — no allocation, no lock, no
+             file and no pass over the whole take.
   ==============================================================================
 */
 
 #pragma once
 #include <JuceHeader.h>
+#include "LockedArena.h"
+#include "SampleCache.h"
 
 class SamplePlayer
 {
 public:
+    enum class Interpolation { linear = 0, cubic, sinc };
+
+    // Thresholds for the load-time analysis, relative to the sample's peak
+    static constexpr float kOnsetThresholdDb = -48.0f;
+    static constexpr float kTailThresholdDb  = -60.0f;
+
+    // -------------------------------------------------------------------------
+    // What the analysis found. Frames count from the start of the file.
+    // -------------------------------------------------------------------------
+    struct SampleInfo
+    {
+        int    numFrames   = 0;
+        double sampleRate  = 44100.0;
+        int    onsetFrame  = 0;       // first frame above the onset threshold
+        int    endFrame    = 0;       // one past the last frame above the tail threshold
+        float  peak        = 0.0f;    // linear, across all channels
+        float  rms         = 0.0f;    // linear, over onset..end
+        bool   trimmed     = false;   // playback starts at onsetFrame
+
+        double getLeadMs() const  { return 1000.0 * (trimmed ? onsetFrame : 0) / sampleRate; }
+        double getPlayedMs() const
+        {
+            return 1000.0 * juce::jmax (0, endFrame - (trimmed ? onsetFrame : 0)) / sampleRate;
+        }
+    };
+
     SamplePlayer();
+    ~SamplePlayer();
 
-    // Load a sample from disk. Returns true on success.
-    bool loadSample (const juce::File& file);
+    // Whether playback skips the leading silence found at load time.
+    // Applies to the next load; on by default.
+    void setTrimLeadingSilence (bool shouldTrim)   { trimLeadingSilence = shouldTrim; }
 
-    // Trigger playback from the beginning (called from UI or MIDI thread)
-    void trigger();
+    // Load a sample from disk. Returns true on success. Not real-time safe:
+    // call before playback starts, or with the audio callback locked out.
+    // With an arena the audio is decoded straight into locked memory.
+    // With a cache, a compressed file decoded on an earlier run is mapped
+    // from the cache instead (copied, with an arena: locked memory can't
+    // page-fault), and a freshly decoded one is added to it.
+    bool loadSample (const juce::File& file, LockedArena* arena = nullptr, SampleCache* cache = nullptr);
 
-    // AudioSource interface — used by MixerAudioSource
-    juce::AudioSource* getAudioSource() { return &transportSource; }
+    // Copies audio that is already in memory. Same threading rules as loadSample().
+    void setSample (const juce::AudioBuffer<float>& source, double sampleRate,
+                    const juce::String& newName, LockedArena* arena = nullptr);
+
+    bool hasSample() const { return loaded.load(); }
+
+    // -------------------------------------------------------------------------
+    // Live sampling. reserveCapture() (message thread) preallocates room for
+    // a take of up to maxFrames, replacing any earlier reservation, and
+    // releaseCapture() frees it again.
+    //
+    // The rest is the audio thread's. beginCapture() claims the reservation;
+    // it returns false if nothing is reserved or the previous take hasn't
+    // been adopted yet. appendCapture() writes count frames from start of
+    // each input channel after what is there (a mono input fills both
+    // sides) and returns how many fitted. finishCapture() cuts the take to
+    // numFrames, fades out its last fadeFrames and swaps it in at the start
+    // of the next block. abortCapture() drops a take midway for
+    // collectGarbage() to free; false means the last dropped one hasn't been
+    // freed yet, so try again later.
+    // -------------------------------------------------------------------------
+    void reserveCapture (int numChannels, int maxFrames);
+    void releaseCapture();
+    bool beginCapture (double sampleRate);
+    int  appendCapture (const float* const* input, int numInputs, int start, int count);
+    bool finishCapture (int numFrames, int fadeFrames);
+    bool abortCapture();
 
     // Must be called before playback starts
     void prepareToPlay (int samplesPerBlock, double sampleRate);
     void releaseResources();
 
-    const juce::String& getName() const { return name; }
+    // -------------------------------------------------------------------------
+    // Audio thread only. DrumEngine queues triggers from the UI / MIDI threads
+    // and calls these at the right sample inside the block.
+    // -------------------------------------------------------------------------
+
+    // Restart playback from the beginning. pitchRatio 2.0 plays an octave up.
+    // Hitting an evicted pad plays its head and asks for a reload.
+    void trigger (double pitchRatio = 1.0);
+
+    // Switches to a new take, or a reloaded or evicted copy of the sample,
+    // if one is waiting. Called at the start of every block. A head never
+    // replaces the full sample under a sounding voice; a take cuts it.
+    void adoptPendingSample();
+
+    // Applies from the next renderNextBlock() call
+    void setInterpolation (Interpolation newQuality) { quality = newQuality; }
+
+    // Fades the voice out over a few milliseconds instead of cutting it,
+    // so a stolen voice doesn't click
+    void fastRelease();
+
+    // ADDS this voice's output into buffer[startSample, startSample + numSamples).
+    // If sendBuffer is given, sendGain times the same signal is added there too.
+    void renderNextBlock (juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                          juce::AudioBuffer<float>* sendBuffer = nullptr, float sendGain = 0.0f);
+
+    bool isPlaying() const   { return playing; }
+    bool isReleasing() const { return playing && fadeStep > 0.0f; }
+
+    // Rough loudness of the voice right now (0..1), from the envelope
+    // computed at load time. Used to pick which voice to steal.
+    float getCurrentLevel() const;
+
+    const juce::String& getName() const     { return name; }
+    const SampleInfo&   getInfo() const     { return info; }
+
+    // -------------------------------------------------------------------------
+    // Memory management, for SampleMemoryManager. Any thread but the audio
+    // thread; calls on one player are serialised with each other and with
+    // the load functions.
+    // -------------------------------------------------------------------------
+
+    // Bytes held for this pad, counting a copy the audio thread has not
+    // adopted or released yet, and a capture reservation. Lock-free.
+    size_t getMemoryBytes() const               { return memoryBytes.load(); }
+
+    // True while only the head is resident. Lock-free.
+    bool isEvicted() const                      { return evicted.load(); }
+
+    // Millisecond counter at the last hit (or the load, if never hit)
+    juce::uint32 getLastTriggerMs() const       { return lastTriggerMs.load(); }
+
+    // An evicted pad was hit and wants its full sample back
+    bool wantsReload() const                    { return reloadWanted.load(); }
+
+    // An evicted or reloaded copy is waiting to be adopted or freed
+    bool isSwapPending() const                  { return pending.load() != nullptr || retired.load() != nullptr; }
+
+    // Replaces the sample with a copy of its first headSeconds (from the
+    // playback start) and returns the bytes that frees once the audio thread
+    // lets go of the full one. Returns 0 if there is nothing to gain, the
+    // sample has no file to come back from, or a previous swap is unfinished.
+    size_t evictToHead (double headSeconds);
+
+    // Decodes an evicted sample again (through the cache it was loaded with)
+    // and hands it to the audio thread. Returns false if it didn't.
+    bool reload();
+
+    // Deletes the copy the audio thread has finished with, and a take it
+    // dropped midway, if any
+    void collectGarbage();
+
+    // A take lands in its whole kMaxSeconds reservation. This hands the
+    // audio thread a copy just long enough for the take, so a short hit
+    // doesn't hold the rest against the budget. Returns false if the
+    // sample is not an oversized take or a previous swap is unfinished.
+    bool compactCapture();
 
 private:
+    static constexpr int kGuardFrames = 8;
+
+    // -------------------------------------------------------------------------
+    // CONCEPT: A coarse peak envelope — the loudest sample in each block of
+    // kEnvelopeBlockSize — lets the audio thread ask "how loud is this voice
+    // now?" with one array lookup instead of scanning audio.
+    // -------------------------------------------------------------------------
+    static constexpr int kEnvelopeBlockSize = 256;
+
+    struct Sample
+    {
+        // ---------------------------------------------------------------------
+        // audio holds kGuardFrames of silence either side of the frames, so
+        // interpolators can read their neighbours at the very start and end
+        // without a bounds check per sample.
+        // ---------------------------------------------------------------------
+        juce::AudioBuffer<float>             audio;
+        std::unique_ptr<LockedArena::Block>  memory;   // audio's storage, when locked
+        std::unique_ptr<SampleCache::Mapped> mapped;   // audio's storage, when mapped
+        int                                  numFrames  = 0;   // resident frames, without guards
+        double                               sampleRate = 44100.0;
+        bool                                 isHead     = false;
+        bool                                 isCapture  = false;   // live take: no file behind it
+
+        // Playback range from the analysis, and the envelope for voice stealing
+        int                                  startFrame = 0;
+        int                                  endFrame   = 0;
+        std::vector<float>                   peakEnvelope;
+
+        // Bumped by each take. Copies made for an older version are stale.
+        int                                  generation = 0;
+
+        // First real frame of a channel
+        const float* getFrames (int channel) const  { return audio.getReadPointer (channel, kGuardFrames); }
+        size_t       getBytes() const;
+    };
+
+    std::unique_ptr<Sample> decode (const juce::File& file, LockedArena* arena, SampleCache* cache);
+    std::unique_ptr<Sample> loadFromCache (const juce::File& file, LockedArena* arena, SampleCache& cache);
+
+    // Makes sample the one to play, dropping any other (not real-time safe)
+    void install (std::unique_ptr<Sample> sample, const juce::String& newName,
+                  const juce::File& source, LockedArena* arena, SampleCache* cache);
+
+    static void buildPeakEnvelope (Sample& sample);
+
+    // Raises the envelope's blocks over frames [from, to); they must exist
+    static void updatePeakEnvelope (Sample& sample, int from, int to);
+
+    // Sets sample's playback range and returns what it found
+    static SampleInfo analyse (Sample& sample, bool trim);
+
     // -------------------------------------------------------------------------
     // CONCEPT: AudioFormatManager registers decoders (WAV, AIFF, etc.).
-    //          createReaderFor() opens a file and returns an AudioFormatReader.
-    //          AudioFormatReaderSource wraps a reader as an AudioSource.
-    //          AudioTransportSource adds start/stop/seek on top.
+    //          createReaderFor() opens a file and returns an AudioFormatReader,
+    //          which we read once into a Sample.
+    // -------------------------------------------------------------------------
+    juce::AudioFormatManager formatManager;
+
     // -------------------------------------------------------------------------
-    juce::AudioFormatManager        formatManager;
-    std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
-    juce::AudioTransportSource      transportSource;
+    // current is written only by the audio thread once playback runs (and by
+    // the load functions before it does); pending only by the loading side,
+    // and emptied by the audio thread; retired the other way round.
+    // -------------------------------------------------------------------------
+    std::atomic<Sample*>      current { nullptr };
+    std::atomic<Sample*>      pending { nullptr };
+    std::atomic<Sample*>      retired { nullptr };
+    std::atomic<Sample*>      reserved { nullptr };   // empty, for the next take
+    std::atomic<Sample*>      captured { nullptr };   // a take, until adopted
+    std::atomic<Sample*>      abandoned { nullptr };  // a take dropped midway, until freed
+    Sample*                   filling = nullptr;      // the take being written; audio thread's alone
+    juce::CriticalSection     sampleLock;     // never taken by the audio thread
+    std::atomic<size_t>       memoryBytes   { 0 };
+    std::atomic<bool>         evicted       { false };
+    std::atomic<bool>         reloadWanted  { false };
+    std::atomic<bool>         loaded        { false };
+    std::atomic<juce::uint32> lastTriggerMs { 0 };
+
+    // Where the sample came from, for reloads. No file (setSample(), or a
+    // take) means it can't be evicted.
+    juce::File   sourceFile;
+    LockedArena* sourceArena = nullptr;
+    SampleCache* sourceCache = nullptr;
+
+    // -------------------------------------------------------------------------
+    // Voice state. position advances by increment per output sample:
+    // the sample's rate / the device's (so a 48k file plays at the right
+    // pitch on a 44.1k device), times the pitch ratio of the current hit.
+    // -------------------------------------------------------------------------
+    double        position         = 0.0;
+    double        outputSampleRate = 44100.0;
+    double        increment        = 1.0;
+    bool          playing          = false;
+    Interpolation quality          = Interpolation::cubic;
+
+    // Fast-release fade: gain drops by fadeStep per sample while releasing
+    float fadeGain          = 1.0f;
+    float fadeStep          = 0.0f;
+    int   fadeLengthSamples = 256;
+
+    // Load-time analysis of the file (a take isn't analysed)
+    SampleInfo info;
+    bool       trimLeadingSilence = true;
 
     juce::String name;
 
@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+    SendReverb.cpp
+  ==============================================================================
+*/
+
+#include "SendReverb.h"
+
+SendReverb::SendReverb()
+{
+    loadDefaultRoom();
+}
+
+bool SendReverb::loadImpulseResponse (const juce::File& irFile)
+{
+    if (! irFile.existsAsFile())
+        return false;
+
+    // size 0 = use the whole IR, however long it is
+    convolution.loadImpulseResponse (irFile,
+                                     juce::dsp::Convolution::Stereo::yes,
+                                     juce::dsp::Convolution::Trim::yes,
+                                     0,
+                                     juce::dsp::Convolution::Normalise::yes);
+    return true;
+}
+
+void SendReverb::loadDefaultRoom (double roomSeconds)
+{
+    // -------------------------------------------------------------------------
+    // CONCEPT: A plausible room IR is just noise with an exponential decay.
+    // Independent noise per channel gives a wide stereo image. The decay
+    // constant makes the tail fall by 60 dB (RT60) over roomSeconds.
+    // -------------------------------------------------------------------------
+    constexpr double irSampleRate = 48000.0;
+    const int length = (int) (roomSeconds * irSampleRate);
+
+    juce::AudioBuffer<float> ir (2, length);
+    juce::Random random (0x5eed);
+
+    const double decayPerSample = std::pow (0.001, 1.0 / (double) length); // -60 dB at the end
+
+    for (int channel = 0; channel < ir.getNumChannels(); ++channel)
+    {
+        auto* data = ir.getWritePointer (channel);
+        double envelope = 1.0;
+
+        for (int i = 0; i < length; ++i)
+        {
+            data[i] = (float) (envelope * (random.nextFloat() * 2.0f - 1.0f));
+            envelope *= decayPerSample;
+        }
+    }
+
+    convolution.loadImpulseResponse (std::move (ir),
+                                     irSampleRate,
+                                     juce::dsp::Convolution::Stereo::yes,
+                                     juce::dsp::Convolution::Trim::no,
+                                     juce::dsp::Convolution::Normalise::yes);
+}
+
+void SendReverb::prepare (int maximumBlockSize, double sampleRate)
+{
+    convolution.prepare ({ sampleRate, (juce::uint32) maximumBlockSize, 2 });
+}
+
+void SendReverb::reset()
+{
+    convolution.reset();
+}
+
+void SendReverb::process (juce::AudioBuffer<float>& bus, int numSamples)
+{
+    auto block = juce::dsp::AudioBlock<float> (bus).getSubBlock (0, (size_t) numSamples);
+    convolution.process (juce::dsp::ProcessContextReplacing<float> (block));
+}
+
+int SendReverb::getTailSamples() const
+{
+    return convolution.getCurrentIRSize() + convolution.getLatency();
+}
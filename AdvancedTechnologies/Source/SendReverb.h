@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+    SendReverb.h
+    A convolution reverb on a shared send bus. Each pad sends some of its
+    signal to the bus; the bus is convolved with a room impulse response
+    (IR) and mixed back in at the return level.
+
+    CONCEPT: Convolving with a multi-second IR directly would cost millions
+             of multiplies per block. juce::dsp::Convolution splits the IR
+             into partitions and multiplies them in the frequency domain.
+             With NonUniform { kHeadSize }, the first partition is tiny (so
+             latency stays at zero even with 64-sample buffers) and later
+             partitions use larger, more efficient FFTs.
+
+    CONCEPT: loadImpulseResponse() may be called from any thread. Reading
+             the file, resampling it and preparing its FFTs happens on
+             Convolution's own background thread; the audio thread swaps the
+             new IR in when it is ready, crossfading to avoid clicks.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+class SendReverb
+{
+public:
+    // Head partition size in samples — small enough for 64-sample buffers
+    static constexpr int kHeadSize = 64;
+
+    SendReverb();
+
+    // Loads an IR from disk (WAV / AIFF). Returns false if the file is missing.
+    bool loadImpulseResponse (const juce::File& irFile);
+
+    // Builds a synthetic room (decaying stereo noise) so the bus does
+    // something useful when no IR file is provided
+    void loadDefaultRoom (double roomSeconds = 1.5);
+
+    // Audio thread
+    void prepare (int maximumBlockSize, double sampleRate);
+    void reset();
+
+    // Convolves bus[0, numSamples) in place. bus must have 2 channels.
+    void process (juce::AudioBuffer<float>& bus, int numSamples);
+
+    // How long the output keeps ringing after the input goes silent: the
+    // current IR's length plus the convolution's latency, in samples
+    int getTailSamples() const;
+
+private:
+    juce::dsp::Convolution convolution { juce::dsp::Convolution::NonUniform { kHeadSize } };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SendReverb)
+};
@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+    StepSequencer.cpp
+  ==============================================================================
+*/
+
+#include "StepSequencer.h"
+
+void StepSequencer::Pattern::setStep (int step, int pad, bool on)
+{
+    const auto bit = (std::uint16_t) (1u << pad);
+
+    if (on)
+        steps[(size_t) step] |= bit;
+    else
+        steps[(size_t) step] &= (std::uint16_t) ~bit;
+}
+
+//==============================================================================
+StepSequencer::StepSequencer()
+    : state (State {})
+{
+}
+
+void StepSequencer::prepareToPlay (double sampleRate)
+{
+    currentSampleRate = sampleRate;
+    wasRunning = false; // restart cleanly on the next block
+}
+
+int StepSequencer::renderEvents (int numSamples, Event* dest, int maxEvents)
+{
+    state.update();
+
+    const bool isNowRunning = running.load();
+
+    if (! isNowRunning)
+    {
+        if (wasRunning)
+            playingStep.store (-1);
+
+        wasRunning = false;
+        return 0;
+    }
+
+    const auto& current = state.read();
+
+    // -------------------------------------------------------------------------
+    // Start from the top of the chain on the first block after Play
+    // -------------------------------------------------------------------------
+    if (! wasRunning)
+    {
+        wasRunning    = true;
+        nextStepTime  = 0.0;
+        currentStep   = 0;
+        chainPosition = 0;
+    }
+
+    // -------------------------------------------------------------------------
+    // CONCEPT: A 16th note lasts (60 / bpm) / 4 seconds. Swing lengthens the
+    // even (on-beat) step and shortens the odd one by the same amount, so
+    // every pair still takes exactly two 16ths and the bar stays in time.
+    // -------------------------------------------------------------------------
+    const double samplesPerStep = currentSampleRate * 60.0 / tempo.load() / 4.0;
+    const double swingOffset    = 0.5 * (double) swing.load() * samplesPerStep;
+
+    int numEvents = 0;
+
+    while (nextStepTime < (double) numSamples)
+    {
+        const int chainLength  = juce::jlimit (1, kMaxChainLength, current.chainLength);
+        chainPosition          = chainPosition % chainLength;
+        const int patternIndex = juce::jlimit (0, kNumPatterns - 1, current.chain[(size_t) chainPosition]);
+        const auto stepBits    = current.patterns[(size_t) patternIndex].steps[(size_t) currentStep];
+        const int offset       = juce::jlimit (0, numSamples - 1, (int) nextStepTime);
+
+        for (int pad = 0; pad < kNumTracks && stepBits != 0; ++pad)
+            if (((stepBits >> pad) & 1) != 0 && numEvents < maxEvents)
+                dest[numEvents++] = { offset, pad };
+
+        playingStep.store (currentStep);
+        playingPattern.store (patternIndex);
+
+        nextStepTime += (currentStep % 2 == 0) ? samplesPerStep + swingOffset
+                                               : samplesPerStep - swingOffset;
+
+        if (++currentStep == kNumSteps)
+        {
+            currentStep = 0;
+            ++chainPosition;   // wrapped against chainLength on the next step
+        }
+    }
+
+    nextStepTime -= (double) numSamples;
+    return numEvents;
+}
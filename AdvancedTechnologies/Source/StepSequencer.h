@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+    StepSequencer.h
+    A 16-step pattern sequencer for the 16 drum pads, with tempo, swing and
+    pattern chaining.
+
+    CONCEPT: Mouse clicks and MIDI reach the pads via the message thread, so
+             their timing wobbles with GUI load. The sequencer instead runs
+             INSIDE the audio callback: it counts samples, not milliseconds,
+             and reports each hit as a sample offset within the current
+             block. DrumEngine starts the voice on exactly that sample, so the
+             groove cannot drift however busy the UI is.
+
+    Threads:
+      - Message thread : edits patterns and publishes them (TripleBuffer),
+                         sets tempo / swing / running (atomics)
+      - Audio thread   : renderEvents() — no locks, no allocation
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "TripleBuffer.h"
+
+class StepSequencer
+{
+public:
+    static constexpr int kNumSteps       = 16;
+    static constexpr int kNumTracks      = 16;   // one per pad
+    static constexpr int kNumPatterns    = 8;
+    static constexpr int kMaxChainLength = 16;
+
+    // One bit per pad for each step — small and trivially copyable
+    struct Pattern
+    {
+        std::array<std::uint16_t, kNumSteps> steps {};
+
+        bool isStepOn (int step, int pad) const     { return (steps[(size_t) step] >> pad) & 1; }
+        void setStep (int step, int pad, bool on);
+    };
+
+    struct State
+    {
+        std::array<Pattern, kNumPatterns> patterns {};
+
+        // Patterns played in order, looping. Defaults to pattern 0 on its own.
+        std::array<int, kMaxChainLength> chain {};
+        int chainLength = 1;
+    };
+
+    // A pad hit, placed at a sample offset inside the current block.
+    // semitones transposes the hit on top of the pad's own tune.
+    struct Event
+    {
+        int   sampleOffset;
+        int   pad;
+        float semitones = 0.0f;
+        juce::uint32 traceId = 0;   // links a played hit to its MIDI input in a trace
+    };
+
+    StepSequencer();
+
+    //--------------------------------------------------------------------------
+    // Message thread
+    //--------------------------------------------------------------------------
+    void publish (const State& newState)            { state.publish (newState); }
+
+    void setTempo (double bpm)                      { tempo.store (juce::jlimit (20.0, 300.0, bpm)); }
+    double getTempo() const                         { return tempo.load(); }
+
+    // 0 = straight, 1 = off-beat 16ths pushed halfway to the next step
+    void setSwing (float amount)                    { swing.store (juce::jlimit (0.0f, 1.0f, amount)); }
+    float getSwing() const                          { return swing.load(); }
+
+    void setRunning (bool shouldRun)                { running.store (shouldRun); }
+    bool isRunning() const                          { return running.load(); }
+
+    // For the playhead display. -1 when stopped.
+    int getPlayingStep() const                      { return playingStep.load(); }
+    int getPlayingPattern() const                   { return playingPattern.load(); }
+
+    //--------------------------------------------------------------------------
+    // Audio thread
+    //--------------------------------------------------------------------------
+    void prepareToPlay (double sampleRate);
+
+    // Writes the hits falling inside the next numSamples into dest, in
+    // ascending sampleOffset order. Returns how many were written.
+    int renderEvents (int numSamples, Event* dest, int maxEvents);
+
+private:
+    TripleBuffer<State> state;
+
+    std::atomic<double> tempo   { 120.0 };
+    std::atomic<float>  swing   { 0.0f };
+    std::atomic<bool>   running { false };
+
+    std::atomic<int> playingStep    { -1 };
+    std::atomic<int> playingPattern { 0 };
+
+    // -------------------------------------------------------------------------
+    // Audio-thread-only state. nextStepTime is kept as a fractional sample
+    // position relative to the start of the current block, so rounding never
+    // accumulates into drift.
+    // -------------------------------------------------------------------------
+    double currentSampleRate = 44100.0;
+    double nextStepTime      = 0.0;
+    int    currentStep       = 0;
+    int    chainPosition     = 0;
+    bool   wasRunning        = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StepSequencer)
+};
@@ -0,0 +1,203 @@
+/*
+  ==============================================================================
+    StepSequencerComponent.cpp
+  ==============================================================================
+*/
+
+#include "StepSequencerComponent.h"
+
+StepSequencerComponent::StepSequencerComponent (StepSequencer& seq)
+    : sequencer (seq)
+{
+    // -------------------------------------------------------------------------
+    // Step buttons — every 4th one is brighter so the beats stand out
+    // -------------------------------------------------------------------------
+    for (int step = 0; step < StepSequencer::kNumSteps; ++step)
+    {
+        auto button = std::make_unique<juce::TextButton>();
+        button->setClickingTogglesState (false);
+        button->setColour (juce::TextButton::buttonColourId,
+                           step % 4 == 0 ? juce::Colour (0xff3a3a5a) : juce::Colour (0xff2a2a3e));
+        button->setColour (juce::TextButton::buttonOnColourId, juce::Colour (0xffE63946));
+        button->onClick = [this, step] { stepClicked (step); };
+        addAndMakeVisible (*button);
+        stepButtons[(size_t) step] = std::move (button);
+    }
+
+    // -------------------------------------------------------------------------
+    // Transport
+    // -------------------------------------------------------------------------
+    playButton.setClickingTogglesState (true);
+    playButton.onClick = [this]
+    {
+        sequencer.setRunning (playButton.getToggleState());
+        playButton.setButtonText (playButton.getToggleState() ? "Stop" : "Play");
+    };
+    addAndMakeVisible (playButton);
+
+    tempoSlider.setSliderStyle (juce::Slider::LinearHorizontal);
+    tempoSlider.setTextBoxStyle (juce::Slider::TextBoxRight, false, 50, 20);
+    tempoSlider.setRange (40.0, 240.0, 1.0);
+    tempoSlider.setValue (sequencer.getTempo(), juce::dontSendNotification);
+    tempoSlider.onValueChange = [this] { sequencer.setTempo (tempoSlider.getValue()); };
+    addAndMakeVisible (tempoSlider);
+
+    swingSlider.setSliderStyle (juce::Slider::LinearHorizontal);
+    swingSlider.setTextBoxStyle (juce::Slider::TextBoxRight, false, 50, 20);
+    swingSlider.setRange (0.0, 100.0, 1.0);
+    swingSlider.setTextValueSuffix ("%");
+    swingSlider.setValue (sequencer.getSwing() * 100.0, juce::dontSendNotification);
+    swingSlider.onValueChange = [this] { sequencer.setSwing ((float) swingSlider.getValue() / 100.0f); };
+    addAndMakeVisible (swingSlider);
+
+    // -------------------------------------------------------------------------
+    // Pattern being edited, and the chain that plays ("1 1 2 3")
+    // -------------------------------------------------------------------------
+    for (int i = 0; i < StepSequencer::kNumPatterns; ++i)
+        patternBox.addItem ("Pattern " + juce::String (i + 1), i + 1);
+
+    patternBox.setSelectedId (1, juce::dontSendNotification);
+    patternBox.onChange = [this]
+    {
+        editingPattern = patternBox.getSelectedId() - 1;
+        refreshStepButtons();
+    };
+    addAndMakeVisible (patternBox);
+
+    chainEditor.setText ("1", false);
+    chainEditor.setTooltip ("Patterns to play in order, e.g. 1 1 2 3");
+    chainEditor.onReturnKey = [this] { chainEdited(); };
+    chainEditor.onFocusLost = [this] { chainEdited(); };
+    addAndMakeVisible (chainEditor);
+
+    for (auto* label : { &padLabel, &tempoLabel, &swingLabel, &chainLabel })
+    {
+        label->setFont (juce::Font (13.0f));
+        label->setColour (juce::Label::textColourId, juce::Colours::white.withAlpha (0.7f));
+        addAndMakeVisible (*label);
+    }
+
+    setSelectedPad (0);
+    publishState();
+
+    startTimerHz (30);
+}
+
+StepSequencerComponent::~StepSequencerComponent()
+{
+    stopTimer();
+}
+
+void StepSequencerComponent::setSelectedPad (int padIndex)
+{
+    selectedPad = juce::jlimit (0, StepSequencer::kNumTracks - 1, padIndex);
+    padLabel.setText ("Pad " + juce::String (selectedPad + 1), juce::dontSendNotification);
+    refreshStepButtons();
+}
+
+void StepSequencerComponent::stepClicked (int step)
+{
+    auto& pattern = editState.patterns[(size_t) editingPattern];
+    pattern.setStep (step, selectedPad, ! pattern.isStepOn (step, selectedPad));
+
+    refreshStepButtons();
+    publishState();
+}
+
+void StepSequencerComponent::chainEdited()
+{
+    // -------------------------------------------------------------------------
+    // Parse space- or comma-separated pattern numbers; ignore anything else
+    // -------------------------------------------------------------------------
+    auto tokens = juce::StringArray::fromTokens (chainEditor.getText(), " ,", {});
+    int length = 0;
+
+    for (const auto& token : tokens)
+    {
+        const int patternNumber = token.getIntValue();
+
+        if (patternNumber >= 1 && patternNumber <= StepSequencer::kNumPatterns
+            && length < StepSequencer::kMaxChainLength)
+            editState.chain[(size_t) length++] = patternNumber - 1;
+    }
+
+    if (length == 0)
+    {
+        editState.chain[0] = editingPattern;
+        length = 1;
+    }
+
+    editState.chainLength = length;
+
+    // Show the chain as it was understood
+    juce::StringArray shown;
+    for (int i = 0; i < length; ++i)
+        shown.add (juce::String (editState.chain[(size_t) i] + 1));
+
+    chainEditor.setText (shown.joinIntoString (" "), false);
+    publishState();
+}
+
+void StepSequencerComponent::refreshStepButtons()
+{
+    const auto& pattern = editState.patterns[(size_t) editingPattern];
+
+    for (int step = 0; step < StepSequencer::kNumSteps; ++step)
+        stepButtons[(size_t) step]->setToggleState (pattern.isStepOn (step, selectedPad),
+                                                    juce::dontSendNotification);
+}
+
+void StepSequencerComponent::publishState()
+{
+    sequencer.publish (editState);
+}
+
+void StepSequencerComponent::timerCallback()
+{
+    // Only show the playhead when the pattern on screen is the one playing
+    const int step = sequencer.getPlayingPattern() == editingPattern ? sequencer.getPlayingStep() : -1;
+
+    if (step == lastShownStep)
+        return;
+
+    lastShownStep = step;
+
+    for (int i = 0; i < StepSequencer::kNumSteps; ++i)
+        stepButtons[(size_t) i]->setButtonText (i == step ? juce::String (juce::CharPointer_UTF8 ("\xe2\x97\x8f"))
+                                                          : juce::String());
+}
+
+void StepSequencerComponent::paint (juce::Graphics& g)
+{
+    g.setColour (juce::Colours::white.withAlpha (0.08f));
+    g.fillRoundedRectangle (getLocalBounds().toFloat(), 6.0f);
+}
+
+void StepSequencerComponent::resized()
+{
+    auto area = getLocalBounds().reduced (8);
+
+    // Top row: transport and settings
+    auto top = area.removeFromTop (26);
+    padLabel.setBounds (top.removeFromLeft (60));
+    playButton.setBounds (top.removeFromLeft (60));
+    top.removeFromLeft (8);
+    tempoLabel.setBounds (top.removeFromLeft (36));
+    tempoSlider.setBounds (top.removeFromLeft (140));
+    swingLabel.setBounds (top.removeFromLeft (44));
+    swingSlider.setBounds (top.removeFromLeft (140));
+    top.removeFromLeft (8);
+    patternBox.setBounds (top.removeFromLeft (100));
+    top.removeFromLeft (8);
+    chainLabel.setBounds (top.removeFromLeft (44));
+    chainEditor.setBounds (top);
+
+    area.removeFromTop (8);
+
+    // Bottom row: the 16 steps
+    const int stepW = area.getWidth() / StepSequencer::kNumSteps;
+
+    for (int step = 0; step < StepSequencer::kNumSteps; ++step)
+        stepButtons[(size_t) step]->setBounds (area.getX() + step * stepW, area.getY(),
+                                               stepW - 2, area.getHeight());
+}
@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+    StepSequencerComponent.h
+    Editor strip for the StepSequencer: 16 step buttons for the selected pad,
+    transport, tempo, swing, the pattern being edited and the pattern chain.
+
+    CONCEPT: The UI keeps its own copy of the sequencer State. Every edit
+             changes that copy and publishes the whole thing to the audio
+             thread in one lock-free step, so the sequencer never sees a
+             half-edited pattern.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "StepSequencer.h"
+
+class StepSequencerComponent : public juce::Component,
+                               private juce::Timer
+{
+public:
+    explicit StepSequencerComponent (StepSequencer& sequencer);
+    ~StepSequencerComponent() override;
+
+    // Which pad's row the step buttons show and edit
+    void setSelectedPad (int padIndex);
+
+    void paint (juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    void timerCallback() override;   // moves the playhead highlight
+
+    void stepClicked (int step);
+    void chainEdited();
+    void refreshStepButtons();
+    void publishState();
+
+    StepSequencer&        sequencer;
+    StepSequencer::State  editState;   // message-thread copy
+
+    int selectedPad    = 0;
+    int editingPattern = 0;
+    int lastShownStep  = -1;
+
+    std::array<std::unique_ptr<juce::TextButton>, StepSequencer::kNumSteps> stepButtons;
+
+    juce::TextButton playButton   { "Play" };
+    juce::Slider     tempoSlider;
+    juce::Slider     swingSlider;
+    juce::ComboBox   patternBox;
+    juce::TextEditor chainEditor;
+
+    juce::Label padLabel;
+    juce::Label tempoLabel   { {}, "BPM" };
+    juce::Label swingLabel   { {}, "Swing" };
+    juce::Label chainLabel   { {}, "Chain" };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StepSequencerComponent)
+};
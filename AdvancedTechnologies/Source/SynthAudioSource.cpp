@@ -5,60 +5,428 @@
 */
 
 #include "SynthAudioSource.h"
+#include "Trace.h"
+
+namespace
+{
+    // Cycle length in beats for each "Sync" choice; 0 = free running
+    constexpr double kSyncBeats[] = { 0.0, 4.0, 2.0, 1.0, 0.5, 0.25 };
+}
 
 SynthAudioSource::SynthAudioSource (juce::AudioProcessorValueTreeState& apvts_)
     : apvts (apvts_)
-{}
+{
+    for (int i = 0; i < ModMatrix::kNumLfos; ++i)
+        lfoParameters[(size_t) i] = { apvts.getRawParameterValue (getLfoParameterId (i, "Rate")),
+                                      apvts.getRawParameterValue (getLfoParameterId (i, "Sync")),
+                                      apvts.getRawParameterValue (getLfoParameterId (i, "Shape")) };
+
+    for (int slot = 0; slot < ModMatrix::kMaxRoutings; ++slot)
+        routingParameters[(size_t) slot] = { apvts.getRawParameterValue (getRoutingParameterId (slot, "Source")),
+                                             apvts.getRawParameterValue (getRoutingParameterId (slot, "Target")),
+                                             apvts.getRawParameterValue (getRoutingParameterId (slot, "Depth")) };
+
+    intervalParameter = apvts.getRawParameterValue ("modInterval");
+}
+
+juce::String SynthAudioSource::getLfoParameterId (int lfoIndex, const juce::String& name)
+{
+    return "lfo" + juce::String (lfoIndex + 1) + name;
+}
+
+juce::String SynthAudioSource::getRoutingParameterId (int slot, const juce::String& name)
+{
+    return "mod" + juce::String (slot + 1) + name;
+}
+
+//==============================================================================
+juce::AudioProcessorValueTreeState::ParameterLayout SynthAudioSource::createParameterLayout()
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+
+    // -------------------------------------------------------------------------
+    // "frequency" is now a semitone detune offset (-24 .. +24).
+    // The base pitch comes from MIDI. Default 0 = no detune.
+    // -------------------------------------------------------------------------
+    layout.add (std::make_unique<juce::AudioParameterFloat> (
+        "frequency",
+        "Detune (semitones)",
+        juce::NormalisableRange<float> (-24.0f, 24.0f, 0.01f),
+        0.0f));
+
+    layout.add (std::make_unique<juce::AudioParameterFloat> (
+        "volume",
+        "Volume",
+        juce::NormalisableRange<float> (0.0f, 1.0f, 0.01f),
+        0.5f));
+
+    layout.add (std::make_unique<juce::AudioParameterFloat> (
+        "attack",
+        "Attack (ms)",
+        juce::NormalisableRange<float> (1.0f, 2000.0f, 1.0f, 0.4f),
+        10.0f));
+
+    // -------------------------------------------------------------------------
+    // Drive 0 bypasses the saturator and its oversampling altogether
+    // -------------------------------------------------------------------------
+    layout.add (std::make_unique<juce::AudioParameterFloat> (
+        "drive",
+        "Drive",
+        juce::NormalisableRange<float> (0.0f, 1.0f, 0.01f),
+        0.0f));
+
+    layout.add (std::make_unique<juce::AudioParameterChoice> (
+        "oversampling",
+        "Oversampling",
+        juce::StringArray { "Off", "2x", "4x", "8x" },   // index = log2 (factor)
+        1));
+
+    // -------------------------------------------------------------------------
+    // Modulation: two LFOs, then kMaxRoutings slots of source -> target.
+    // The choices' order is the order of ModMatrix's enums.
+    // -------------------------------------------------------------------------
+    for (int i = 0; i < ModMatrix::kNumLfos; ++i)
+    {
+        const juce::String name = "LFO " + juce::String (i + 1);
+
+        layout.add (std::make_unique<juce::AudioParameterFloat> (
+            getLfoParameterId (i, "Rate"),
+            name + " Rate (Hz)",
+            juce::NormalisableRange<float> (0.05f, 20.0f, 0.01f, 0.4f),
+            i == 0 ? 5.0f : 0.5f));
+
+        layout.add (std::make_unique<juce::AudioParameterChoice> (
+            getLfoParameterId (i, "Sync"),
+            name + " Sync",
+            juce::StringArray { "Free", "1 bar", "1/2", "1/4", "1/8", "1/16" },   // see kSyncBeats
+            0));
+
+        layout.add (std::make_unique<juce::AudioParameterChoice> (
+            getLfoParameterId (i, "Shape"),
+            name + " Shape",
+            juce::StringArray { "Sine", "Triangle", "Saw", "Square" },
+            0));
+    }
+
+    for (int slot = 0; slot < ModMatrix::kMaxRoutings; ++slot)
+    {
+        const juce::String name = "Mod " + juce::String (slot + 1);
+
+        layout.add (std::make_unique<juce::AudioParameterChoice> (
+            getRoutingParameterId (slot, "Source"),
+            name + " Source",
+            juce::StringArray { "Off", "LFO 1", "LFO 2", "Velocity", "Aftertouch", "Mod wheel" },
+            0));
+
+        layout.add (std::make_unique<juce::AudioParameterChoice> (
+            getRoutingParameterId (slot, "Target"),
+            name + " Target",
+            juce::StringArray { "Pitch", "Volume" },
+            0));
+
+        layout.add (std::make_unique<juce::AudioParameterFloat> (
+            getRoutingParameterId (slot, "Depth"),
+            name + " Depth",
+            juce::NormalisableRange<float> (-1.0f, 1.0f, 0.001f),
+            0.0f));
+    }
+
+    // Samples between modulation updates: 8 << index
+    layout.add (std::make_unique<juce::AudioParameterChoice> (
+        "modInterval",
+        "Modulation interval",
+        juce::StringArray { "8 samples", "16 samples", "32 samples", "64 samples" },
+        2));
 
-void SynthAudioSource::prepareToPlay (int /*samplesPerBlockExpected*/, double sampleRate)
+    return layout;
+}
+
+void SynthAudioSource::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
 {
-    currentSampleRate = sampleRate;
-    currentPhase = 0.0;
+    voices.prepare (samplesPerBlockExpected, sampleRate);
+
+    // Volume moves glide over 20 ms instead of stepping (zipper noise)
+    volume.reset (sampleRate, 0.02);
+    volume.setCurrentAndTargetValue (apvts.getRawParameterValue ("volume")->load());
+
+    driveStage.prepare (samplesPerBlockExpected);
+    driveBuffer.setSize (1, juce::jmax (1, samplesPerBlockExpected));
+    driveWasOn = false;
+
+    if (constantLatency)
+    {
+        directDelay.setMaximumDelayInSamples (juce::roundToInt (getMaximumLatencySamples()) + 1);
+        directDelay.prepare ({ sampleRate, (juce::uint32) driveBuffer.getNumSamples(), 1 });
+    }
+
+    delayWasOn = false;
+    currentNote.store (-1);
+
+    modulation.prepare (sampleRate);
+    modulationGain = 1.0f;
+
+    // Room for a full queue, so addEvent() never allocates on the audio thread
+    blockMidi.ensureSize ((size_t) kMidiQueueSize * 16);
+    lastBlockTimeMs = 0.0;
 }
 
-void SynthAudioSource::getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill)
+bool SynthAudioSource::renderBus (const juce::AudioSourceChannelInfo& bufferToFill)
 {
+    const int numSamples = bufferToFill.numSamples;
+    collectMidi (numSamples);
+
+    // -------------------------------------------------------------------------
+    // Idle: nothing sounding and nothing to start. The voices' tails are
+    // inside their envelopes and the drive stage is reset when it next
+    // starts, so there is no other state to wait for. The volume jumps to
+    // where its glide was heading; there is nothing for it to click on.
+    // -------------------------------------------------------------------------
+    if (blockMidi.isEmpty() && voices.getNumActiveVoices() == 0)
+    {
+        volume.setCurrentAndTargetValue (apvts.getRawParameterValue ("volume")->load());
+        driveWasOn = delayWasOn = false;
+        return false;
+    }
+
+    AT_TRACE_SCOPE ("Synth render");
+
     bufferToFill.clearActiveBufferRegion();
+    updateModulation();
 
-    if (! isPlaying.load())
-        return;
+    // -------------------------------------------------------------------------
+    // Split the block at each message, as EngineProcessor does with host
+    // MIDI: render up to the message with the old note, apply it, carry on
+    // -------------------------------------------------------------------------
+    int position = 0;
+
+    for (const auto metadata : blockMidi)
+    {
+        const int eventPos = juce::jlimit (0, numSamples, metadata.samplePosition);
+
+        if (eventPos > position)
+        {
+            renderSegment (*bufferToFill.buffer, bufferToFill.startSample + position, eventPos - position);
+            position = eventPos;
+        }
+
+        applyMidiMessage (metadata.getMessage());
+    }
+
+    if (position < numSamples)
+        renderSegment (*bufferToFill.buffer, bufferToFill.startSample + position, numSamples - position);
+
+    return true;
+}
+
+void SynthAudioSource::collectMidi (int numSamples)
+{
+    const double nowMs        = juce::Time::getMillisecondCounterHiRes();
+    const double blockStartMs = lastBlockTimeMs > 0.0 ? lastBlockTimeMs : nowMs;
+    const double elapsedMs    = nowMs - blockStartMs;
+    lastBlockTimeMs = nowMs;
+
+    blockMidi.clear();
+
+    const auto scope = midiFifo.read (midiFifo.getNumReady());
+
+    // -------------------------------------------------------------------------
+    // CONCEPT: A message that arrived a third of the way through the last
+    // callback interval plays a third of the way through this block. Scaling
+    // by the measured interval (rather than assuming it equals the block
+    // length) keeps this right when callbacks arrive unevenly.
+    // -------------------------------------------------------------------------
+    const auto addMessage = [&] (const TimedMessage& message)
+    {
+        const double proportion = elapsedMs > 0.0 ? (message.timeMs - blockStartMs) / elapsedMs : 0.0;
+        const int    position   = juce::jlimit (0, juce::jmax (0, numSamples - 1),
+                                                (int) (proportion * numSamples));
+
+        blockMidi.addEvent (message.bytes, message.numBytes, position);
+    };
+
+    for (int i = 0; i < scope.blockSize1; ++i)
+        addMessage (midiQueue[(size_t) (scope.startIndex1 + i)]);
+
+    for (int i = 0; i < scope.blockSize2; ++i)
+        addMessage (midiQueue[(size_t) (scope.startIndex2 + i)]);
+}
+
+void SynthAudioSource::updateModulation()
+{
+    for (int i = 0; i < ModMatrix::kNumLfos; ++i)
+    {
+        const auto& parameters = lfoParameters[(size_t) i];
+        modulation.setLfo (i, parameters.rate->load(),
+                           (ModMatrix::LfoShape) (int) parameters.shape->load(),
+                           kSyncBeats[(size_t) juce::jlimit (0, juce::numElementsInArray (kSyncBeats) - 1, (int) parameters.sync->load())]);
+    }
+
+    for (int slot = 0; slot < ModMatrix::kMaxRoutings; ++slot)
+    {
+        const auto& parameters = routingParameters[(size_t) slot];
+        modulation.setRouting (slot, { (ModMatrix::Source) (int) parameters.source->load(),
+                                       (ModMatrix::Target) (int) parameters.target->load(),
+                                       parameters.depth->load() });
+    }
 
+    modulation.setControlInterval (8 << (int) intervalParameter->load());
+    modulation.setTempo (tempo.load());
+}
+
+void SynthAudioSource::renderSegment (juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
     // -------------------------------------------------------------------------
-    // CONCEPT: We combine two frequency sources:
-    //   1. midiFrequency  -- set atomically by the MIDI thread on note-on
-    //   2. "detune" param -- the Frequency slider now offsets by +/- 24 semitones
+    // CONCEPT: We combine three frequency sources:
+    //   1. each voice's note -- set by applyMidiMessage() at the note-on's sample
+    //   2. "detune" param    -- the Frequency slider offsets by +/- 24 semitones
+    //   3. pitch modulation  -- the matrix's pitch target, in semitones
     //
     // Semitone offset -> frequency multiplier: 2^(semitones/12)
     // This shows students how parameters and live MIDI can work together.
     // -------------------------------------------------------------------------
-    const float baseMidiHz  = midiFrequency.load();
-    const float detuneSemi  = apvts.getRawParameterValue ("frequency")->load(); // -24 .. +24
-    const float finalHz     = baseMidiHz * std::pow (2.0f, detuneSemi / 12.0f);
-    const float volume      = apvts.getRawParameterValue ("volume")->load();
+    const float detune = apvts.getRawParameterValue ("frequency")->load();   // -24 .. +24
+
+    if (governor != nullptr)
+        voices.setVoiceLimit (governor->getVoiceLimit (SynthVoiceBank::kMaxVoices));
+
+    volume.setTargetValue (apvts.getRawParameterValue ("volume")->load());
+
+    if (voices.getNumActiveVoices() == 0 || buffer.getNumChannels() == 0)
+    {
+        voices.setDetune (detune);
+        volume.skip (numSamples);
+        driveWasOn = delayWasOn = false;
+        return;
+    }
+
+    // -------------------------------------------------------------------------
+    // CONCEPT: Control rate. The matrix is evaluated at the end of each
+    // interval; the voices glide to its pitch and the gain ramps to its
+    // volume across the interval, so everything in between is a straight
+    // line drawn inside the kernels. Without routings the segment renders
+    // in one go, with the detune slider gliding the same way.
+    // -------------------------------------------------------------------------
+    const int interval = modulation.isActive() ? juce::jmin (modulation.getControlInterval(), driveBuffer.getNumSamples())
+                                               : numSamples;
+
+    for (int offset = 0; offset < numSamples; offset += interval)
+    {
+        const int numToDo = juce::jmin (interval, numSamples - offset);
+
+        modulation.advance (numToDo);
+        voices.setDetune (detune + modulation.getEndValue (ModMatrix::Target::pitch), true);
+
+        const float endModulationGain = juce::Decibels::decibelsToGain (modulation.getEndValue (ModMatrix::Target::volume));
+        const float startGain         = volume.getCurrentValue() * modulationGain;
+        const float endGain           = volume.skip (numToDo) * endModulationGain;
+        modulationGain = endModulationGain;
+
+        renderVoices (buffer, startSample + offset, numToDo, startGain, endGain);
+
+        // The last voice may have finished inside this interval
+        if (voices.getNumActiveVoices() == 0)
+        {
+            volume.skip (numSamples - offset - numToDo);
+            break;
+        }
+    }
+}
+
+void SynthAudioSource::renderVoices (juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                                     float startGain, float endGain)
+{
+    if (const float drive = apvts.getRawParameterValue ("drive")->load(); drive > 0.0f || constantLatency)
+    {
+        renderDriven (buffer, startSample, numSamples, drive, startGain, endGain);
+        return;
+    }
+
+    driveWasOn = false;
+
+    // -------------------------------------------------------------------------
+    // The voices are mono. The bank writes the first two channels itself
+    // (its kernels are specialised for mono and stereo); any further
+    // channels get a copy of the first.
+    // -------------------------------------------------------------------------
+    const int numChannels = juce::jmin (2, buffer.getNumChannels());
+    float* outputs[2] = { buffer.getWritePointer (0, startSample),
+                          buffer.getWritePointer (numChannels - 1, startSample) };
+
+    voices.render (outputs, numChannels, numSamples, startGain, endGain);
+
+    for (int channel = 2; channel < buffer.getNumChannels(); ++channel)
+        buffer.copyFrom (channel, startSample, buffer, 0, startSample, numSamples);
+}
+
+void SynthAudioSource::renderDriven (juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                                     float drive, float startGain, float endGain)
+{
+    AT_TRACE_SCOPE ("Synth drive");
+
+    const bool driven = drive > 0.0f;
+
+    // Whatever the filters (or the delay) held when last used is stale now
+    if (driven && ! driveWasOn)
+        driveStage.reset();
+
+    if (! driven && ! delayWasOn)
+        directDelay.reset();
 
-    const double phaseIncrement = juce::MathConstants<double>::twoPi
-                                  * finalHz / currentSampleRate;
+    driveWasOn = driven;
+    delayWasOn = ! driven;
 
-    const int numSamples  = bufferToFill.numSamples;
-    const int startSample = bufferToFill.startSample;
+    const int factorLog2 = (int) apvts.getRawParameterValue ("oversampling")->load();
+    const float latency  = driveStage.getLatencySamples (factorLog2);
+    const int chunkSize  = driveBuffer.getNumSamples();
+    const float gainStep = (endGain - startGain) / (float) numSamples;
+    float* mono          = driveBuffer.getWritePointer (0);
 
-    for (int channel = 0; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+    // -------------------------------------------------------------------------
+    // Voices at unity gain -> saturator -> volume. The volume has to come
+    // after the nonlinearity, or turning it down would also clean up the
+    // distortion.
+    // -------------------------------------------------------------------------
+    for (int offset = 0; offset < numSamples; offset += chunkSize)
     {
-        float* channelData = bufferToFill.buffer->getWritePointer (channel, startSample);
-        double phase = currentPhase;
+        const int numToDo = juce::jmin (chunkSize, numSamples - offset);
+
+        juce::FloatVectorOperations::clear (mono, numToDo);
+        voices.render (&mono, 1, numToDo, 1.0f, 1.0f);
 
-        for (int sample = 0; sample < numSamples; ++sample)
+        if (driven)
+        {
+            driveStage.process (mono, numToDo, drive, factorLog2);
+        }
+        else
         {
-            channelData[sample] = volume * (float) std::sin (phase);
-            phase += phaseIncrement;
-            if (phase >= juce::MathConstants<double>::twoPi)
-                phase -= juce::MathConstants<double>::twoPi;
+            for (int i = 0; i < numToDo; ++i)
+            {
+                directDelay.pushSample (0, mono[i]);
+                mono[i] = directDelay.popSample (0, latency);
+            }
         }
+
+        const float chunkStartGain = startGain + gainStep * (float) offset;
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            buffer.addFromWithRamp (channel, startSample + offset, mono, numToDo,
+                                    chunkStartGain, chunkStartGain + gainStep * (float) numToDo);
     }
+}
 
-    currentPhase += phaseIncrement * numSamples;
-    if (currentPhase >= juce::MathConstants<double>::twoPi)
-        currentPhase -= juce::MathConstants<double>::twoPi;
+float SynthAudioSource::getLatencySamples() const
+{
+    return driveStage.getLatencySamples ((int) apvts.getRawParameterValue ("oversampling")->load());
+}
+
+float SynthAudioSource::getMaximumLatencySamples() const
+{
+    float latency = 0.0f;
+
+    for (int factorLog2 = 0; factorLog2 <= OversampledDrive::kMaxFactorLog2; ++factorLog2)
+        latency = juce::jmax (latency, driveStage.getLatencySamples (factorLog2));
+
+    return latency;
 }
 
 void SynthAudioSource::releaseResources() {}
@@ -68,6 +436,52 @@ void SynthAudioSource::releaseResources() {}
 //------------------------------------------------------------------------------
 void SynthAudioSource::handleIncomingMidiMessage (juce::MidiInput* /*source*/,
                                                    const juce::MidiMessage& message)
+{
+    AT_TRACE_SCOPE ("Synth MIDI in");
+
+    // Only notes and the modulation sources matter; 3 bytes hold any of them
+    if (! (message.isNoteOn() || message.isNoteOff() || message.isAllNotesOff()
+           || message.isChannelPressure() || message.isControllerOfType (1))
+        || message.getRawDataSize() > 3)
+        return;
+
+    const double timeMs = message.getTimeStamp() > 0.0 ? message.getTimeStamp() * 1000.0
+                                                       : juce::Time::getMillisecondCounterHiRes();
+    int noteForUi = -2; // unchanged
+
+    {
+        const juce::SpinLock::ScopedLockType lock (midiWriteLock);
+
+        // If the queue is full the message is dropped rather than blocking
+        const auto scope = midiFifo.write (1);
+
+        if (scope.blockSize1 == 0)
+            return;
+
+        auto& queued = midiQueue[(size_t) scope.startIndex1];
+        std::memcpy (queued.bytes, message.getRawData(), (size_t) message.getRawDataSize());
+        queued.numBytes = message.getRawDataSize();
+        queued.timeMs   = timeMs;
+
+        // Mirrors applyMidiMessage(), so the label can update now rather
+        // than wait for the audio thread
+        if (message.isNoteOn())
+            noteForUi = lastQueuedNote = message.getNoteNumber();
+        else if (message.isAllNotesOff() || (message.isNoteOff() && message.getNoteNumber() == lastQueuedNote))
+            noteForUi = lastQueuedNote = -1;
+    }
+
+    if (noteForUi == -2)
+        return;
+
+    // Post a UI update to show the note name on the message thread
+    juce::MessageManager::callAsync ([this, noteForUi]
+    {
+        if (onNoteChanged) onNoteChanged (noteForUi);
+    });
+}
+
+bool SynthAudioSource::applyMidiMessage (const juce::MidiMessage& message)
 {
     // -------------------------------------------------------------------------
     // CONCEPT: isNoteOn() returns true for status byte 0x9n with velocity > 0.
@@ -77,35 +491,49 @@ void SynthAudioSource::handleIncomingMidiMessage (juce::MidiInput* /*source*/,
     if (message.isNoteOn())
     {
         const int note = message.getNoteNumber();
-        midiFrequency.store (midiNoteToHz (note));  // atomic write -- audio thread safe
+        voices.noteOn (note, message.getFloatVelocity(), apvts.getRawParameterValue ("attack")->load());
+        modulation.setSourceValue (ModMatrix::Source::velocity, message.getFloatVelocity());
         currentNote.store (note);
-        isPlaying.store (true);
-
-        // Post a UI update to show the note name on the message thread
-        juce::MessageManager::callAsync ([this, note]
-        {
-            if (onNoteChanged) onNoteChanged (note);
-        });
+        return true;
     }
-    else if (message.isNoteOff())
+
+    if (message.isNoteOff())
     {
-        // Only stop if this is the note we're currently holding
+        voices.noteOff (message.getNoteNumber());
+
+        // The label follows the most recent note until it is let go
         if (message.getNoteNumber() == currentNote.load())
         {
-            isPlaying.store (false);
             currentNote.store (-1);
-
-            juce::MessageManager::callAsync ([this]
-            {
-                if (onNoteChanged) onNoteChanged (-1);
-            });
+            return true;
         }
     }
+
+    if (message.isAllNotesOff())
+    {
+        voices.allNotesOff();
+        currentNote.store (-1);
+        return true;
+    }
+
+    // -------------------------------------------------------------------------
+    // The matrix's MIDI sources are global, like a mono synth's: the last
+    // velocity, channel pressure and the mod wheel, each 0..1
+    // -------------------------------------------------------------------------
+    if (message.isChannelPressure())
+        modulation.setSourceValue (ModMatrix::Source::aftertouch, message.getChannelPressureValue() / 127.0f);
+    else if (message.isControllerOfType (1))
+        modulation.setSourceValue (ModMatrix::Source::modWheel, message.getControllerValue() / 127.0f);
+
+    return false;
 }
 
 void SynthAudioSource::setPlaying (bool shouldPlay)
 {
-    isPlaying.store (shouldPlay);
-    if (! shouldPlay)
-        currentNote.store (-1);
+    // -------------------------------------------------------------------------
+    // Through the MIDI queue like any other note: the voices belong to the
+    // audio thread. Play holds an A4; stop lets go of everything.
+    // -------------------------------------------------------------------------
+    handleIncomingMidiMessage (nullptr, shouldPlay ? juce::MidiMessage::noteOn (1, 69, 0.8f)
+                                                   : juce::MidiMessage::allNotesOff (1));
 }
@@ -1,7 +1,7 @@
 /*
   ==============================================================================
     SynthAudioSource.h
-    A minimal sine-wave oscillator that reads its parameters from an
+    A polyphonic sine synth that reads its parameters from an
     AudioProcessorValueTreeState AND responds to MIDI note-on / note-off
     messages.
 
@@ -10,67 +10,191 @@
              safely -- here we use std::atomic<> members rather than locks,
              which is the lightest-weight approach for simple values.
 
+    CONCEPT: Sample-accurate MIDI. Applying notes the moment they arrive
+             would snap every note to the next block boundary (11 ms steps
+             at 512 samples) and lose a note-on/off pair that falls inside
+             one block. Instead the MIDI thread queues each message with its
+             timestamp; the audio thread maps the messages that arrived
+             during the previous block onto the same positions in this one
+             and renders in segments between them. Timing within a phrase
+             is exact, at the cost of a constant one-block delay — the same
+             trade JUCE's MidiMessageCollector makes.
+
     MIDI behaviour:
-      - Note-on  : sets the oscillator frequency from the MIDI note number
-                   (standard equal temperament: f = 440 * 2^((n-69)/12))
-                   and starts playback.
-      - Note-off : stops playback only if it matches the currently held note
-                   (so fast re-triggers don't cut the sound early).
-      - The Frequency slider in the UI now acts as a fine-tune offset in
-                   semitones (+/- 24), combining parameter automation with MIDI.
+      - Note-on  : starts a voice at the note's equal-temperament pitch
+                   (f = 440 * 2^((n-69)/12)), fading in over the Attack time.
+                   Up to 128 notes sound at once (see SynthVoiceBank).
+      - Note-off : releases every voice playing that note.
+      - All-notes-off (CC 123) releases everything.
+      - Channel pressure and the mod wheel (CC 1) feed the modulation
+                   matrix, as does each note-on's velocity.
+      - The Frequency slider in the UI acts as a fine-tune offset in
+                   semitones (+/- 24) on every voice, combining parameter
+                   automation with MIDI.
+
+    Drive saturates the summed voices through OversampledDrive, at the
+    rate the Oversampling parameter picks.
+
+    Two LFOs and the MIDI controls modulate pitch and volume through a
+    ModMatrix of kMaxRoutings slots, evaluated every "modInterval" samples
+    and interpolated in between.
+
+    A BusSource: a block with no voice sounding and no MIDI arriving is
+    skipped outright, so an idle synth costs nothing but the MIDI check.
   ==============================================================================
 */
 
 #pragma once
 #include <JuceHeader.h>
+#include "BusMixer.h"
+#include "LoadGovernor.h"
+#include "SynthVoiceBank.h"
+#include "OversampledDrive.h"
+#include "ModMatrix.h"
 
-class SynthAudioSource : public juce::AudioSource,
+class SynthAudioSource : public BusSource,
                          public juce::MidiInputCallback   // <-- MIDI thread callback
 {
 public:
     explicit SynthAudioSource (juce::AudioProcessorValueTreeState& apvts);
 
+    // -------------------------------------------------------------------------
+    // createParameterLayout() defines every parameter with its range,
+    // default, and identifier string. Whoever owns the APVTS (SynthComponent
+    // or EngineProcessor) builds it from this so both share one definition.
+    // -------------------------------------------------------------------------
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
+    // Modulation parameter IDs: "lfo1Rate", "mod2Depth" and so on, counting
+    // from 1. name is Rate / Sync / Shape, or Source / Target / Depth.
+    static juce::String getLfoParameterId (int lfoIndex, const juce::String& name);
+    static juce::String getRoutingParameterId (int slot, const juce::String& name);
+
     // AudioSource interface
     void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
-    void getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill) override;
     void releaseResources() override;
 
     // -------------------------------------------------------------------------
-    // MidiInputCallback interface -- called on the MIDI background thread.
-    // We update atomics so the audio thread picks up the change lock-free.
+    // MidiInputCallback interface -- called on the MIDI background thread
+    // (or any other thread injecting MIDI). Queues the message for its
+    // sample in an upcoming block; a message without a timestamp counts as
+    // arriving now.
     // -------------------------------------------------------------------------
     void handleIncomingMidiMessage (juce::MidiInput* source,
                                     const juce::MidiMessage& message) override;
 
+    // Applies a note-on / note-off to the voices immediately, without
+    // posting any UI update. Audio thread only: renderNextBlock() calls it
+    // between segments, and so does EngineProcessor::processBlock, whose
+    // host MIDI already carries sample positions.
+    // Returns true if the held note changed.
+    bool applyMidiMessage (const juce::MidiMessage& message);
+
+    // The drive stage's delay in samples for the current Oversampling
+    // setting, whether or not the drive is on. Any thread.
+    float getLatencySamples() const;
+
+    // The largest delay any Oversampling setting can have, for sizing
+    // compensation delays
+    float getMaximumLatencySamples() const;
+
+    // When set, the undriven signal is delayed by getLatencySamples() too,
+    // so the latency a host compensates for doesn't jump each time Drive
+    // crosses zero. The plugin sets it; the app has no PDC and doesn't.
+    // Call before prepareToPlay().
+    void setConstantLatency (bool shouldBeConstant)  { constantLatency = shouldBeConstant; }
+
     // Called from the UI play button -- manual play/stop without MIDI
     void setPlaying (bool shouldPlay);
 
-    // Returns the MIDI note number currently held (-1 if none)
+    // Tempo the synced LFOs follow (any thread)
+    void setTempo (double bpm)          { tempo.store (bpm); }
+
+    // Returns the most recent MIDI note still held (-1 if none)
     int getCurrentNote() const { return currentNote.load(); }
 
+    // When set, the number of held voices is capped by the governor's
+    // voice limit, like the drum engine's pads
+    void setGovernor (LoadGovernor* newGovernor) { governor = newGovernor; }
+
     // Optional callback fired on the message thread when the note changes.
     // Set this from SynthComponent to update the UI label.
     std::function<void(int note)> onNoteChanged;
 
+protected:
+    bool renderBus (const juce::AudioSourceChannelInfo& bufferToFill) override;
+
 private:
+    // Renders the voices into [startSample, startSample + numSamples)
+    void renderSegment (juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+    // Renders the voices for one control interval, from startGain to endGain
+    void renderVoices (juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                       float startGain, float endGain);
+
+    // Renders the voices through the drive stage, then adds them to the
+    // output with the volume ramp. At drive 0 (constantLatency only) they
+    // go through directDelay instead, for the same delay without the shaper.
+    void renderDriven (juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                       float drive, float startGain, float endGain);
+
+    // Passes the modulation parameters to the matrix, once per block
+    void updateModulation();
+
+    // Moves the queued messages into blockMidi at their sample positions
+    void collectMidi (int numSamples);
+
     juce::AudioProcessorValueTreeState& apvts;
 
-    double currentSampleRate = 44100.0;
-    double currentPhase      = 0.0;
+    SynthVoiceBank              voices;             // audio thread only
+    juce::SmoothedValue<float>  volume;             // audio thread only
+    OversampledDrive            driveStage;         // audio thread only
+    juce::AudioBuffer<float>    driveBuffer;        // mono, at the base rate
+    bool                        driveWasOn = false;
+    bool                        constantLatency = false;
+    bool                        delayWasOn = false;
+    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None> directDelay;   // constantLatency only
+    LoadGovernor*               governor = nullptr;
+    ModMatrix                   modulation;         // audio thread only
+    float                       modulationGain = 1.0f;
+
+    // The modulation parameters, looked up once
+    struct LfoParameters     { std::atomic<float>* rate; std::atomic<float>* sync; std::atomic<float>* shape; };
+    struct RoutingParameters { std::atomic<float>* source; std::atomic<float>* target; std::atomic<float>* depth; };
+
+    std::array<LfoParameters, ModMatrix::kNumLfos>         lfoParameters;
+    std::array<RoutingParameters, ModMatrix::kMaxRoutings> routingParameters;
+    std::atomic<float>*                                    intervalParameter = nullptr;
+    std::atomic<double>                                    tempo { 120.0 };
 
     // -------------------------------------------------------------------------
-    // CONCEPT: std::atomic<> lets the MIDI thread write and the audio thread
-    // read without a mutex. Only use this for simple scalar values.
+    // MIDI queue. Several threads may inject MIDI (each input, the latency
+    // harness, calibration), so writers take a SpinLock among themselves;
+    // the audio thread is the only reader and never takes it.
     // -------------------------------------------------------------------------
-    std::atomic<float> midiFrequency { 440.0f }; // set by MIDI note-on
-    std::atomic<bool>  isPlaying     { false };
-    std::atomic<int>   currentNote   { -1 };      // -1 = no note held
-
-    // Converts a MIDI note number to Hz using equal temperament
-    static float midiNoteToHz (int note)
+    struct TimedMessage
     {
-        return 440.0f * std::pow (2.0f, (note - 69) / 12.0f);
-    }
+        juce::uint8 bytes[3];
+        int         numBytes;
+        double      timeMs;     // Time::getMillisecondCounterHiRes() base
+    };
+
+    static constexpr int kMidiQueueSize = 512;
+
+    juce::SpinLock                          midiWriteLock;
+    juce::AbstractFifo                      midiFifo { kMidiQueueSize };
+    std::array<TimedMessage, kMidiQueueSize> midiQueue;
+    int                                     lastQueuedNote = -1;   // under midiWriteLock, for the UI
+
+    // Audio thread only
+    juce::MidiBuffer blockMidi;
+    double           lastBlockTimeMs = 0.0;
+
+    // -------------------------------------------------------------------------
+    // CONCEPT: std::atomic<> lets the audio thread write and the UI read
+    // without a mutex. Only use this for simple scalar values.
+    // -------------------------------------------------------------------------
+    std::atomic<int> currentNote { -1 };      // -1 = no note held
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SynthAudioSource)
 };
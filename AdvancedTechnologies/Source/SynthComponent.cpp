@@ -7,41 +7,17 @@
 #include "SynthComponent.h"
 
 //==============================================================================
-juce::AudioProcessorValueTreeState::ParameterLayout SynthComponent::createParameterLayout()
-{
-    juce::AudioProcessorValueTreeState::ParameterLayout layout;
-
-    // -------------------------------------------------------------------------
-    // "frequency" is now a semitone detune offset (-24 .. +24).
-    // The base pitch comes from MIDI. Default 0 = no detune.
-    // -------------------------------------------------------------------------
-    layout.add (std::make_unique<juce::AudioParameterFloat> (
-        "frequency",
-        "Detune (semitones)",
-        juce::NormalisableRange<float> (-24.0f, 24.0f, 0.01f),
-        0.0f));
-
-    layout.add (std::make_unique<juce::AudioParameterFloat> (
-        "volume",
-        "Volume",
-        juce::NormalisableRange<float> (0.0f, 1.0f, 0.01f),
-        0.5f));
-
-    layout.add (std::make_unique<juce::AudioParameterFloat> (
-        "attack",
-        "Attack (ms)",
-        juce::NormalisableRange<float> (1.0f, 2000.0f, 1.0f, 0.4f),
-        10.0f));
-
-    return layout;
-}
-
-//==============================================================================
-SynthComponent::SynthComponent (juce::AudioDeviceManager& dm)
-    : apvts (dummyProcessor, nullptr, "SynthState", createParameterLayout()),
+SynthComponent::SynthComponent (juce::AudioDeviceManager& dm, BusMixer& mix,
+                                LoadGovernor& governor)
+    : apvts (dummyProcessor, nullptr, "SynthState", SynthAudioSource::createParameterLayout()),
       audioSource (apvts),
-      deviceManager (dm)
+      meteredSource (governor, audioSource),
+      deviceManager (dm),
+      masterMix (mix),
+      modMatrix (apvts)
 {
+    audioSource.setGovernor (&governor);
+
     // -------------------------------------------------------------------------
     // CONCEPT: onNoteChanged is a std::function set here on the UI thread.
     // It is called via MessageManager::callAsync so it always runs on the
@@ -67,6 +43,7 @@ SynthComponent::SynthComponent (juce::AudioDeviceManager& dm)
     setupSlider (detuneSlider, detuneLabel, "Detune (semitones)");
     setupSlider (volumeSlider, volumeLabel, "Volume");
     setupSlider (attackSlider, attackLabel, "Attack (ms)");
+    setupSlider (driveSlider,  driveLabel,  "Drive");
 
     detuneAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>
                        (apvts, "frequency", detuneSlider);
@@ -74,25 +51,49 @@ SynthComponent::SynthComponent (juce::AudioDeviceManager& dm)
                        (apvts, "volume", volumeSlider);
     attackAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>
                        (apvts, "attack", attackSlider);
+    driveAttachment  = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>
+                       (apvts, "drive", driveSlider);
 
     // -------------------------------------------------------------------------
-    // Register audioSource as a MIDI callback -- it now receives note events
-    // directly from the device manager on the MIDI background thread.
+    // ComboBoxAttachment maps item i to choice i, so the items must be added
+    // in the parameter's order before attaching
     // -------------------------------------------------------------------------
-    deviceManager.addMidiInputDeviceCallback ({}, &audioSource);
+    if (auto* choice = dynamic_cast<juce::AudioParameterChoice*> (apvts.getParameter ("oversampling")))
+        oversamplingBox.addItemList (choice->choices, 1);
+
+    oversamplingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+                             (apvts, "oversampling", oversamplingBox);
+    addAndMakeVisible (oversamplingBox);
+
+    oversamplingLabel.setFont (juce::Font (12.0f));
+    oversamplingLabel.setColour (juce::Label::textColourId, juce::Colours::white.withAlpha (0.7f));
+    addAndMakeVisible (oversamplingLabel);
 
-    // Hook audio into device
-    audioSourcePlayer.setSource (&audioSource);
-    deviceManager.addAudioCallback (&audioSourcePlayer);
+    oversamplingBox.onChange   = [this] { updateLatencyLabel(); };
+    driveSlider.onValueChange  = [this] { updateLatencyLabel(); };
+    updateLatencyLabel();
 
-    setSize (700, 420);
+    addAndMakeVisible (modMatrix);
+
+    // Hook audio into the master bus (prepared straight away if it's running)
+    masterMix.addInputSource (&meteredSource);
+
+    setSize (700, 640);
 }
 
 SynthComponent::~SynthComponent()
 {
     deviceManager.removeMidiInputDeviceCallback ({}, &audioSource);
-    deviceManager.removeAudioCallback (&audioSourcePlayer);
-    audioSourcePlayer.setSource (nullptr);
+    masterMix.removeInputSource (&meteredSource);
+}
+
+void SynthComponent::connectMidiInputs()
+{
+    // -------------------------------------------------------------------------
+    // Register audioSource as a MIDI callback -- it now receives note events
+    // directly from the device manager on the MIDI background thread.
+    // -------------------------------------------------------------------------
+    deviceManager.addMidiInputDeviceCallback ({}, &audioSource);
 }
 
 void SynthComponent::setupSlider (juce::Slider& slider, juce::Label& label,
@@ -108,6 +109,19 @@ void SynthComponent::setupSlider (juce::Slider& slider, juce::Label& label,
     addAndMakeVisible (label);
 }
 
+void SynthComponent::updateLatencyLabel()
+{
+    if (driveSlider.getValue() <= 0.0)
+    {
+        oversamplingLabel.setText ("Drive off: nothing is oversampled", juce::dontSendNotification);
+        return;
+    }
+
+    const auto latency = audioSource.getLatencySamples();
+    oversamplingLabel.setText ("Drive stage latency: " + juce::String (latency, 1) + " samples",
+                               juce::dontSendNotification);
+}
+
 void SynthComponent::paint (juce::Graphics& g)
 {
     g.fillAll (juce::Colour (0xff1e1e2e));
@@ -121,8 +135,19 @@ void SynthComponent::resized()
     midiNoteLabel.setBounds (area.removeFromTop (36));
     area.removeFromTop (16);
 
-    // Three knobs
-    const int knobW  = area.getWidth() / 3;
+    // Oversampling row along the bottom
+    auto oversamplingRow = area.removeFromBottom (28);
+    oversamplingBox.setBounds (oversamplingRow.removeFromLeft (120));
+    oversamplingRow.removeFromLeft (10);
+    oversamplingLabel.setBounds (oversamplingRow);
+    area.removeFromBottom (12);
+
+    // Modulation matrix above it
+    modMatrix.setBounds (area.removeFromBottom (ModMatrixComponent::kPreferredHeight));
+    area.removeFromBottom (12);
+
+    // Four knobs
+    const int knobW  = area.getWidth() / 4;
     const int labelH = 24;
 
     auto detuneB = area.removeFromLeft (knobW);
@@ -133,8 +158,10 @@ void SynthComponent::resized()
     volumeLabel.setBounds (volB.removeFromBottom (labelH));
     volumeSlider.setBounds (volB);
 
-    attackLabel.setBounds (area.removeFromBottom (labelH));
-    attackSlider.setBounds (area);
-}
-
+    auto attackB = area.removeFromLeft (knobW);
+    attackLabel.setBounds (attackB.removeFromBottom (labelH));
+    attackSlider.setBounds (attackB);
 
+    driveLabel.setBounds (area.removeFromBottom (labelH));
+    driveSlider.setBounds (area);
+}
@@ -1,8 +1,9 @@
 /*
   ==============================================================================
     SynthComponent.h
-    The Synth tab UI.  Three sliders (Frequency, Volume, Attack) are backed by
-    an AudioProcessorValueTreeState, demonstrating the full APVTS pattern
+    The Synth tab UI.  Four sliders (Frequency, Volume, Attack, Drive), the
+    Oversampling choice and the modulation matrix are backed by an
+    AudioProcessorValueTreeState, demonstrating the full APVTS pattern
     outside of an AudioProcessor.
 
     CONCEPT: APVTS stores all parameters in a ValueTree. Sliders don't need
@@ -13,16 +14,30 @@
 #pragma once
 #include <JuceHeader.h>
 #include "SynthAudioSource.h"
+#include "ModMatrixComponent.h"
+#include "LoadGovernor.h"
 
 class SynthComponent : public juce::Component
 {
 public:
-    explicit SynthComponent (juce::AudioDeviceManager& deviceManager);
+    // The synth's audio is added to masterMix, which must outlive this page
+    SynthComponent (juce::AudioDeviceManager& deviceManager, BusMixer& masterMix,
+                    LoadGovernor& governor);
     ~SynthComponent() override;
 
     void paint  (juce::Graphics&) override;
     void resized() override;
 
+    // The synth's MIDI entry point, as registered with the device manager
+    juce::MidiInputCallback& getMidiInputCallback() { return audioSource; }
+
+    // Registers that entry point for every MIDI input. Called by the owner
+    // once the device manager is free (after DeviceOpener), not here.
+    void connectMidiInputs();
+
+    // Tempo for the LFOs' Sync settings (the app follows the drum sequencer)
+    void setTempo (double bpm)                      { audioSource.setTempo (bpm); }
+
 private:
     //--------------------------------------------------------------------------
     // APVTS needs a "dummy" AudioProcessor to satisfy its constructor.
@@ -49,12 +64,6 @@ private:
         void setStateInformation (const void*, int) override   {}
     };
 
-    // -------------------------------------------------------------------------
-    // createParameterLayout() defines every parameter with its range,
-    // default, and identifier string. This layout is stored in the ValueTree.
-    // -------------------------------------------------------------------------
-    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
-
     // -------------------------------------------------------------------------
     // Member order matters! dummyProcessor must exist before apvts is
     // constructed, because APVTS takes a reference to an AudioProcessor.
@@ -65,8 +74,12 @@ private:
     // The audio source that reads from apvts and generates the waveform
     SynthAudioSource                     audioSource;
 
-    // Reference to the shared device manager (owned by MainComponent)
+    // Times every audioSource block for the shared LoadGovernor
+    LoadGovernor::MeteredSource          meteredSource;
+
+    // Reference to the shared device manager and master bus (owned by MainComponent)
     juce::AudioDeviceManager&            deviceManager;
+    BusMixer&                            masterMix;
 
     //--------------------------------------------------------------------------
     // UI Controls
@@ -74,14 +87,23 @@ private:
     juce::Slider detuneSlider;   // was frequencySlider -- now semitone offset +/-24
     juce::Slider volumeSlider;
     juce::Slider attackSlider;
+    juce::Slider driveSlider;
 
     juce::Label  detuneLabel;
     juce::Label  volumeLabel;
     juce::Label  attackLabel;
+    juce::Label  driveLabel;
+
+    // Oversampling factor for the drive stage, and what it costs in latency
+    juce::ComboBox oversamplingBox;
+    juce::Label    oversamplingLabel;
 
     // Shows the currently held MIDI note
     juce::Label  midiNoteLabel;
 
+    // LFOs and modulation routings (attached to apvts, so declared after it)
+    ModMatrixComponent modMatrix;
+
     // -------------------------------------------------------------------------
     // CONCEPT: SliderAttachment keeps the Slider and the APVTS parameter in
     // sync bidirectionally with no extra listener code.
@@ -89,13 +111,13 @@ private:
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> detuneAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> volumeAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> attackAttachment;
-
-    // AudioSourcePlayer wraps our AudioSource as an AudioIODeviceCallback
-    // so it can be registered with the AudioDeviceManager
-    juce::AudioSourcePlayer audioSourcePlayer;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> driveAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingAttachment;
 
     void setupSlider (juce::Slider& slider, juce::Label& label,
                       const juce::String& labelText);
 
+    void updateLatencyLabel();
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SynthComponent)
 };
@@ -0,0 +1,537 @@
+/*
+  ==============================================================================
+    SynthVoiceBank.cpp
+  ==============================================================================
+*/
+
+#include "SynthVoiceBank.h"
+
+namespace
+{
+    // Converts a MIDI note number to Hz using equal temperament
+    float midiNoteToHz (int note)
+    {
+        return 440.0f * std::pow (2.0f, (note - 69) / 12.0f);
+    }
+
+    float samplesFor (float ms, double sampleRate)
+    {
+        return juce::jmax (1.0f, ms * (float) sampleRate / 1000.0f);
+    }
+}
+
+void SynthVoiceBank::prepare (int maximumBlockSize, double sampleRate)
+{
+    currentSampleRate = sampleRate;
+
+    const auto size = (size_t) juce::jmax (1, maximumBlockSize);
+    mix.assign (size, 0.0f);
+
+   #if JUCE_USE_SIMD
+    mixLanes.resize (size);
+   #endif
+
+    reset();
+}
+
+void SynthVoiceBank::reset()
+{
+    for (auto* row : { &re, &im, &cosW, &sinW, &omega, &cosStep, &sinStep, &level, &step, &velocity })
+        *row = {};
+
+    numActive    = 0;
+    glidePending = false;
+}
+
+//==============================================================================
+void SynthVoiceBank::noteOn (int note, float noteVelocity, float attackMs)
+{
+    const int slot = numActive < kMaxVoices ? numActive++ : findQuietestVoice (false);
+
+    re.value[slot]       = 1.0f;   // phase 0: (1, 0)
+    im.value[slot]       = 0.0f;
+    level.value[slot]    = 0.0f;
+    step.value[slot]     = 1.0f / samplesFor (attackMs, currentSampleRate);
+    velocity.value[slot] = noteVelocity;
+
+    notes[(size_t) slot]     = note;
+    baseOmega[(size_t) slot] = (float) (juce::MathConstants<double>::twoPi * midiNoteToHz (note) / currentSampleRate);
+    setRotation (slot);
+}
+
+void SynthVoiceBank::noteOff (int note)
+{
+    for (int slot = 0; slot < numActive; ++slot)
+        if (notes[(size_t) slot] == note && step.value[slot] > 0.0f)
+            releaseVoice (slot, kReleaseMs);
+}
+
+void SynthVoiceBank::allNotesOff()
+{
+    for (int slot = 0; slot < numActive; ++slot)
+        if (step.value[slot] > 0.0f)
+            releaseVoice (slot, kReleaseMs);
+}
+
+void SynthVoiceBank::releaseVoice (int slot, float releaseMs)
+{
+    step.value[slot] = -1.0f / samplesFor (releaseMs, currentSampleRate);
+}
+
+void SynthVoiceBank::setVoiceLimit (int maxVoices)
+{
+    int numHeld = 0;
+
+    for (int slot = 0; slot < numActive; ++slot)
+        if (step.value[slot] > 0.0f)
+            ++numHeld;
+
+    while (numHeld > maxVoices)
+    {
+        const int quietest = findQuietestVoice (true);
+
+        if (quietest < 0)
+            break;
+
+        releaseVoice (quietest, kStealReleaseMs);
+        --numHeld;
+    }
+}
+
+int SynthVoiceBank::findQuietestVoice (bool heldOnly) const
+{
+    int quietest = -1;
+
+    for (int slot = 0; slot < numActive; ++slot)
+    {
+        if (heldOnly && step.value[slot] <= 0.0f)
+            continue;
+
+        const float loudness = level.value[slot] * velocity.value[slot];
+
+        if (quietest < 0 || loudness < level.value[quietest] * velocity.value[quietest])
+            quietest = slot;
+    }
+
+    return quietest;
+}
+
+//==============================================================================
+void SynthVoiceBank::setDetune (float semitones, bool glide)
+{
+    if (semitones == detuneSemitones)
+        return;
+
+    detuneSemitones = semitones;
+    detuneRatio     = std::exp2 (semitones / 12.0f);
+
+    // The next render() glides; a note started before it begins on the new pitch
+    if (glide)
+    {
+        glidePending = true;
+        return;
+    }
+
+    glidePending = false;
+
+    for (int slot = 0; slot < numActive; ++slot)
+        setRotation (slot);
+}
+
+void SynthVoiceBank::setRotation (int slot)
+{
+    omega.value[slot] = baseOmega[(size_t) slot] * detuneRatio;
+    cosW.value[slot]  = std::cos (omega.value[slot]);
+    sinW.value[slot]  = std::sin (omega.value[slot]);
+}
+
+void SynthVoiceBank::beginGlide (int numSamples)
+{
+    // -------------------------------------------------------------------------
+    // CONCEPT: Each sample adds dw to the angle. Rotating (cos w, sin w) by dw
+    // gives (cos (w + dw), sin (w + dw)). dw is usually tiny, but a square
+    // LFO at full depth moves 24 semitones within one short interval, which
+    // on a high note is a tenth of a radian per sample — far past where a
+    // small-angle step is exact, and the rotation's magnitude would drift.
+    // So the step is computed properly: two calls per voice per interval,
+    // not per sample.
+    // -------------------------------------------------------------------------
+    for (int slot = 0; slot < numActive; ++slot)
+    {
+        const float target = baseOmega[(size_t) slot] * detuneRatio;
+        const float dw     = (target - omega.value[slot]) / (float) numSamples;
+
+        cosStep.value[slot] = std::cos (dw);
+        sinStep.value[slot] = std::sin (dw);
+        omega.value[slot]   = target;
+    }
+}
+
+void SynthVoiceBank::endGlide()
+{
+    // The stepped rotation has picked up rounding; start the next one clean
+    for (int slot = 0; slot < numActive; ++slot)
+    {
+        cosW.value[slot] = std::cos (omega.value[slot]);
+        sinW.value[slot] = std::sin (omega.value[slot]);
+    }
+
+    glidePending = false;
+}
+
+void SynthVoiceBank::renormalise()
+{
+    // -------------------------------------------------------------------------
+    // CONCEPT: One Newton step towards 1/sqrt(r^2). The radius only drifts by
+    // a few parts per million per block, so one step lands back on 1 with
+    // no sqrt or divide.
+    // -------------------------------------------------------------------------
+    for (int slot = 0; slot < numActive; ++slot)
+    {
+        const float radiusSquared = re.value[slot] * re.value[slot] + im.value[slot] * im.value[slot];
+        const float correction    = 1.5f - 0.5f * radiusSquared;
+
+        re.value[slot] *= correction;
+        im.value[slot] *= correction;
+    }
+}
+
+void SynthVoiceBank::retireFinishedVoices()
+{
+    // Backwards, so the voice swapped into a freed slot has already been checked
+    for (int slot = numActive - 1; slot >= 0; --slot)
+        if (step.value[slot] < 0.0f && level.value[slot] <= 0.0f)
+            removeVoice (slot);
+}
+
+void SynthVoiceBank::removeVoice (int slot)
+{
+    const int last = --numActive;
+
+    for (auto* row : { &re, &im, &cosW, &sinW, &omega, &cosStep, &sinStep, &level, &step, &velocity })
+    {
+        row->value[slot] = row->value[last];
+        row->value[last] = 0.0f;
+    }
+
+    notes[(size_t) slot]     = notes[(size_t) last];
+    baseOmega[(size_t) slot] = baseOmega[(size_t) last];
+}
+
+//==============================================================================
+bool SynthVoiceBank::isEnvelopeMoving() const
+{
+    // A held voice whose attack has finished sits clamped at 1
+    for (int slot = 0; slot < numActive; ++slot)
+        if (! (step.value[slot] > 0.0f && level.value[slot] >= 1.0f))
+            return true;
+
+    return false;
+}
+
+void SynthVoiceBank::render (float* const* outputs, int numChannels, int numSamples, float startGain, float endGain)
+{
+   #if ! JUCE_USE_SIMD
+    renderScalar (outputs, numChannels, numSamples, startGain, endGain);
+   #else
+    if (numActive == 0 || numSamples <= 0)
+        return;
+
+    juce::ScopedNoDenormals noDenormals;
+
+    const bool glide = glidePending;
+
+    if (glide)
+        beginGlide (numSamples);
+
+    selectKernel (numChannels, isEnvelopeMoving(), startGain != endGain, glide);
+
+    const float gainStep  = (endGain - startGain) / (float) numSamples;
+    const int   chunkSize = (int) mixLanes.size();
+
+    for (int offset = 0; offset < numSamples; offset += chunkSize)
+        (this->*kernel) (outputs, offset, juce::jmin (chunkSize, numSamples - offset),
+                         startGain + gainStep * (float) offset, gainStep);
+
+    if (glide)
+        endGlide();
+
+    renormalise();
+    retireFinishedVoices();
+   #endif
+}
+
+#if JUCE_USE_SIMD
+void SynthVoiceBank::selectKernel (int numChannels, bool envelopeMoving, bool gainRamp, bool pitchGlide)
+{
+    const int key = (pitchGlide ? 8 : 0) | (numChannels >= 2 ? 4 : 0) | (envelopeMoving ? 2 : 0) | (gainRamp ? 1 : 0);
+
+    if (key == kernelKey)
+        return;
+
+    static constexpr Kernel kernels[] =
+    {
+        &SynthVoiceBank::renderKernel<1, false, false, false>, &SynthVoiceBank::renderKernel<1, false, true, false>,
+        &SynthVoiceBank::renderKernel<1, true,  false, false>, &SynthVoiceBank::renderKernel<1, true,  true, false>,
+        &SynthVoiceBank::renderKernel<2, false, false, false>, &SynthVoiceBank::renderKernel<2, false, true, false>,
+        &SynthVoiceBank::renderKernel<2, true,  false, false>, &SynthVoiceBank::renderKernel<2, true,  true, false>,
+        &SynthVoiceBank::renderKernel<1, false, false, true>,  &SynthVoiceBank::renderKernel<1, false, true, true>,
+        &SynthVoiceBank::renderKernel<1, true,  false, true>,  &SynthVoiceBank::renderKernel<1, true,  true, true>,
+        &SynthVoiceBank::renderKernel<2, false, false, true>,  &SynthVoiceBank::renderKernel<2, false, true, true>,
+        &SynthVoiceBank::renderKernel<2, true,  false, true>,  &SynthVoiceBank::renderKernel<2, true,  true, true>
+    };
+
+    kernel    = kernels[key];
+    kernelKey = key;
+}
+
+template <int numChannels, bool envelopeMoving, bool gainRamp, bool pitchGlide>
+void SynthVoiceBank::renderKernel (float* const* outputs, int offset, int numSamples, float gain, float gainStep)
+{
+    std::fill (mixLanes.begin(), mixLanes.begin() + numSamples, Vec::expand (0.0f));
+
+    const int numGroups = (numActive + kLanes - 1) / kLanes;
+
+    for (int group = 0; group < numGroups; ++group)
+    {
+        const int first = group * kLanes;
+
+        auto vRe    = Vec::fromRawArray (re.value + first);
+        auto vIm    = Vec::fromRawArray (im.value + first);
+        auto vLevel = Vec::fromRawArray (level.value + first);
+        auto vCos   = Vec::fromRawArray (cosW.value + first);
+        auto vSin   = Vec::fromRawArray (sinW.value + first);
+        const auto vVel     = Vec::fromRawArray (velocity.value + first);
+        const auto vCosStep = Vec::fromRawArray (cosStep.value + first);
+        const auto vSinStep = Vec::fromRawArray (sinStep.value + first);
+
+        // One sample of the phasor, and of the rotation while it glides
+        const auto advance = [&]
+        {
+            const auto nextRe = vRe * vCos - vIm * vSin;
+            vIm = vRe * vSin + vIm * vCos;
+            vRe = nextRe;
+
+            if constexpr (pitchGlide)
+            {
+                const auto nextCos = vCos * vCosStep - vSin * vSinStep;
+                vSin = vCos * vSinStep + vSin * vCosStep;
+                vCos = nextCos;
+            }
+        };
+
+        // ---------------------------------------------------------------------
+        // kLanes voices per instruction. The sum stays split across lanes
+        // until every group is done.
+        // ---------------------------------------------------------------------
+        if constexpr (envelopeMoving)
+        {
+            const auto vStep = Vec::fromRawArray (step.value + first);
+            const auto zero  = Vec::expand (0.0f);
+            const auto one   = Vec::expand (1.0f);
+
+            for (int n = 0; n < numSamples; ++n)
+            {
+                mixLanes[(size_t) n] += vIm * (vLevel * vVel);
+                advance();
+                vLevel = Vec::min (one, Vec::max (zero, vLevel + vStep));
+            }
+
+            vLevel.copyToRawArray (level.value + first);
+        }
+        else
+        {
+            // Every voice is sustaining: its amplitude is fixed for the block
+            const auto amplitude = vLevel * vVel;
+
+            for (int n = 0; n < numSamples; ++n)
+            {
+                mixLanes[(size_t) n] += vIm * amplitude;
+                advance();
+            }
+        }
+
+        vRe.copyToRawArray (re.value + first);
+        vIm.copyToRawArray (im.value + first);
+
+        // A render longer than one chunk carries on gliding from here
+        if constexpr (pitchGlide)
+        {
+            vCos.copyToRawArray (cosW.value + first);
+            vSin.copyToRawArray (sinW.value + first);
+        }
+    }
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        const float value = mixLanes[(size_t) n].sum() * gain;
+
+        outputs[0][offset + n] += value;
+
+        if constexpr (numChannels == 2)
+            outputs[1][offset + n] += value;
+
+        if constexpr (gainRamp)
+            gain += gainStep;
+    }
+}
+#endif
+
+void SynthVoiceBank::renderGeneric (float* const* outputs, int numChannels, int numSamples, float startGain, float endGain)
+{
+   #if ! JUCE_USE_SIMD
+    renderScalar (outputs, numChannels, numSamples, startGain, endGain);
+   #else
+    if (numActive == 0 || numSamples <= 0)
+        return;
+
+    juce::ScopedNoDenormals noDenormals;
+
+    const auto zero = Vec::expand (0.0f);
+    const auto one  = Vec::expand (1.0f);
+
+    const bool  glide          = glidePending;
+
+    if (glide)
+        beginGlide (numSamples);
+
+    const bool  envelopeMoving = isEnvelopeMoving();
+    const bool  gainRamp       = startGain != endGain;
+    const float gainStep       = (endGain - startGain) / (float) numSamples;
+    const int   numGroups      = (numActive + kLanes - 1) / kLanes;
+    const int   chunkSize      = (int) mixLanes.size();
+
+    for (int offset = 0; offset < numSamples; offset += chunkSize)
+    {
+        const int numToDo = juce::jmin (chunkSize, numSamples - offset);
+        std::fill (mixLanes.begin(), mixLanes.begin() + numToDo, zero);
+
+        for (int group = 0; group < numGroups; ++group)
+        {
+            const int first = group * kLanes;
+
+            auto vRe    = Vec::fromRawArray (re.value + first);
+            auto vIm    = Vec::fromRawArray (im.value + first);
+            auto vLevel = Vec::fromRawArray (level.value + first);
+            auto vCos   = Vec::fromRawArray (cosW.value + first);
+            auto vSin   = Vec::fromRawArray (sinW.value + first);
+            const auto vCosStep = Vec::fromRawArray (cosStep.value + first);
+            const auto vSinStep = Vec::fromRawArray (sinStep.value + first);
+            const auto vStep    = Vec::fromRawArray (step.value + first);
+            const auto vVel     = Vec::fromRawArray (velocity.value + first);
+
+            for (int n = 0; n < numToDo; ++n)
+            {
+                mixLanes[(size_t) n] += vIm * (vLevel * vVel);
+
+                const auto nextRe = vRe * vCos - vIm * vSin;
+                vIm = vRe * vSin + vIm * vCos;
+                vRe = nextRe;
+
+                if (glide)
+                {
+                    const auto nextCos = vCos * vCosStep - vSin * vSinStep;
+                    vSin = vCos * vSinStep + vSin * vCosStep;
+                    vCos = nextCos;
+                }
+
+                if (envelopeMoving)
+                    vLevel = Vec::min (one, Vec::max (zero, vLevel + vStep));
+            }
+
+            vRe.copyToRawArray (re.value + first);
+            vIm.copyToRawArray (im.value + first);
+            vCos.copyToRawArray (cosW.value + first);
+            vSin.copyToRawArray (sinW.value + first);
+            vLevel.copyToRawArray (level.value + first);
+        }
+
+        for (int n = 0; n < numToDo; ++n)
+        {
+            const float gain  = gainRamp ? startGain + gainStep * (float) (offset + n) : startGain;
+            const float value = mixLanes[(size_t) n].sum() * gain;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                outputs[channel][offset + n] += value;
+        }
+    }
+
+    if (glide)
+        endGlide();
+
+    renormalise();
+    retireFinishedVoices();
+   #endif
+}
+
+void SynthVoiceBank::renderScalar (float* const* outputs, int numChannels, int numSamples, float startGain, float endGain)
+{
+    if (numActive == 0 || numSamples <= 0)
+        return;
+
+    juce::ScopedNoDenormals noDenormals;
+
+    const bool glide = glidePending;
+
+    if (glide)
+        beginGlide (numSamples);
+
+    const float gainStep  = (endGain - startGain) / (float) numSamples;
+    const int   chunkSize = (int) mix.size();
+
+    for (int offset = 0; offset < numSamples; offset += chunkSize)
+    {
+        const int numToDo = juce::jmin (chunkSize, numSamples - offset);
+        std::fill (mix.begin(), mix.begin() + numToDo, 0.0f);
+
+        for (int slot = 0; slot < numActive; ++slot)
+        {
+            float vRe    = re.value[slot];
+            float vIm    = im.value[slot];
+            float vLevel = level.value[slot];
+            float vCos   = cosW.value[slot];
+            float vSin   = sinW.value[slot];
+            const float vCosStep = cosStep.value[slot];
+            const float vSinStep = sinStep.value[slot];
+            const float vStep    = step.value[slot];
+            const float vVel     = velocity.value[slot];
+
+            for (int n = 0; n < numToDo; ++n)
+            {
+                mix[(size_t) n] += vIm * (vLevel * vVel);
+
+                const float nextRe = vRe * vCos - vIm * vSin;
+                vIm    = vRe * vSin + vIm * vCos;
+                vRe    = nextRe;
+                vLevel = juce::jlimit (0.0f, 1.0f, vLevel + vStep);
+
+                if (glide)
+                {
+                    const float nextCos = vCos * vCosStep - vSin * vSinStep;
+                    vSin = vCos * vSinStep + vSin * vCosStep;
+                    vCos = nextCos;
+                }
+            }
+
+            re.value[slot]    = vRe;
+            im.value[slot]    = vIm;
+            cosW.value[slot]  = vCos;
+            sinW.value[slot]  = vSin;
+            level.value[slot] = vLevel;
+        }
+
+        for (int n = 0; n < numToDo; ++n)
+        {
+            const float value = mix[(size_t) n] * (startGain + gainStep * (float) (offset + n));
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                outputs[channel][offset + n] += value;
+        }
+    }
+
+    if (glide)
+        endGlide();
+
+    renormalise();
+    retireFinishedVoices();
+}
@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+    SynthVoiceBank.h
+    Up to 128 sine voices, each with a linear attack / release envelope,
+    rendered several voices per instruction.
+
+    CONCEPT: A voice object per note ("for each voice: render") keeps one
+             voice's phase, envelope and gain together in memory, which is
+             the wrong way round for SIMD. Here every per-voice variable is
+             its own aligned row — re[v0..v127], im[v0..v127], level[…] —
+             so one juce::dsp::SIMDRegister load picks up 4 (SSE / NEON),
+             8 (AVX) or 16 (AVX-512) voices' values and every instruction
+             after it advances all of them.
+
+    CONCEPT: The oscillator is a rotating phasor rather than sin(phase).
+             A sine has no SIMDRegister instruction, but rotating the point
+             (re, im) by the per-sample angle is four multiplies and two
+             adds, and im is the sine:
+                 re' = re*cos(w) - im*sin(w)
+                 im' = re*sin(w) + im*cos(w)
+             Rounding makes the radius drift very slowly, so it is pulled
+             back to 1 once per block.
+
+    CONCEPT: Compaction. Active voices always occupy slots 0..numActive-1:
+             a finished voice is swapped with the last one. The render loop
+             then touches only ceil(numActive / lanes) groups, so 3 notes
+             cost one group, not 128 voices' worth of silent lanes.
+
+    CONCEPT: Pitch glides. Modulation changes the pitch every control
+             interval (ModMatrix). Jumping there would step; recomputing
+             cos / sin per sample would cost two transcendentals per voice.
+             Instead the rotation itself is rotated each sample by a tiny
+             step, so the frequency moves linearly to its new value across
+             the render — a second complex multiply. The step's cos / sin
+             are worked out once per voice per interval, and the exact
+             rotation is set once at the end.
+
+    CONCEPT: Specialised kernels. Whether any envelope is still moving,
+             whether the gain is ramping, whether the pitch is gliding and
+             whether the output is mono or stereo are all fixed for a whole
+             block, so each combination is
+             its own template instance with the tests compiled out. The
+             right one is looked up when one of them changes and kept in a
+             member function pointer; the sample loops never branch.
+
+    Threads: audio thread only. SynthAudioSource applies its MIDI here
+             between render segments.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+class SynthVoiceBank
+{
+public:
+    static constexpr int   kMaxVoices       = 128;
+    static constexpr float kReleaseMs       = 60.0f;
+    static constexpr float kStealReleaseMs  = 5.0f;    // voices cut by the voice limit
+
+    SynthVoiceBank() = default;
+
+    void prepare (int maximumBlockSize, double sampleRate);
+    void reset();                                      // silences every voice
+
+    //--------------------------------------------------------------------------
+    // Notes. Starting a note when all voices are busy steals the quietest.
+    //--------------------------------------------------------------------------
+    void noteOn (int note, float velocity, float attackMs);
+    void noteOff (int note);
+    void allNotesOff();
+
+    // Fast-releases the quietest held voices until at most maxVoices are
+    // held. Voices already releasing don't count.
+    void setVoiceLimit (int maxVoices);
+
+    // Pitch offset for every voice, in semitones. Cheap when unchanged;
+    // call once per block before rendering. With glide the pitch moves
+    // there linearly over the next render() instead of jumping.
+    void setDetune (float semitones, bool glide = false);
+
+    // -------------------------------------------------------------------------
+    // Adds the sum of all voices to outputs[0..numChannels) (1 or 2
+    // channels, numSamples each), with the gain ramping linearly from
+    // startGain to endGain. Then retires voices whose release has finished.
+    // -------------------------------------------------------------------------
+    void render (float* const* outputs, int numChannels, int numSamples, float startGain, float endGain);
+
+    // Same result with every option tested inside the sample loops. Kept
+    // as the benchmark's baseline for the specialised kernels.
+    void renderGeneric (float* const* outputs, int numChannels, int numSamples, float startGain, float endGain);
+
+    // Same result, one voice at a time with plain floats. Used when SIMD is
+    // unavailable, and by the benchmark as the baseline.
+    void renderScalar (float* const* outputs, int numChannels, int numSamples, float startGain, float endGain);
+
+    int getNumActiveVoices() const      { return numActive; }
+
+private:
+   #if JUCE_USE_SIMD
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr int kLanes = (int) Vec::size();
+   #else
+    static constexpr int kLanes = 4;     // grouping only, no vector maths
+   #endif
+    static constexpr int kVoiceSlots = ((kMaxVoices + kLanes - 1) / kLanes) * kLanes;
+
+    // One aligned row per variable, one column per voice slot. Unused
+    // slots hold zeros, so a partly filled last group renders silence.
+    struct alignas (64) Row { float value[kVoiceSlots] {}; };
+
+    // One chunk of at most mixLanes.size() samples, starting at offset
+    using Kernel = void (SynthVoiceBank::*) (float* const* outputs, int offset, int numSamples,
+                                             float gain, float gainStep);
+
+    template <int numChannels, bool envelopeMoving, bool gainRamp, bool pitchGlide>
+    void renderKernel (float* const* outputs, int offset, int numSamples, float gain, float gainStep);
+
+    void selectKernel (int numChannels, bool envelopeMoving, bool gainRamp, bool pitchGlide);
+    bool isEnvelopeMoving() const;
+
+    void setRotation (int slot);
+    void beginGlide (int numSamples);    // per-sample steps towards the new detune
+    void endGlide();                     // lands exactly on it
+    void renormalise();
+    void retireFinishedVoices();
+    void removeVoice (int slot);
+    void releaseVoice (int slot, float releaseMs);
+    int  findQuietestVoice (bool heldOnly) const;   // -1 if none
+
+    Row re, im;            // phasor: im is the output sine
+    Row cosW, sinW;        // per-sample rotation
+    Row omega;             // its angle, radians per sample
+    Row cosStep, sinStep;  // rotation of the rotation while gliding
+    Row level;             // envelope, 0..1
+    Row step;              // envelope change per sample: > 0 attack, < 0 release
+    Row velocity;
+
+    std::array<int,   kVoiceSlots> notes {};
+    std::array<float, kVoiceSlots> baseOmega {};   // the note's angle per sample, undetuned
+
+    int    numActive         = 0;
+    float  detuneSemitones   = 0.0f;
+    float  detuneRatio       = 1.0f;
+    bool   glidePending      = false;
+    double currentSampleRate = 44100.0;
+
+   #if JUCE_USE_SIMD
+    std::vector<Vec> mixLanes;           // per-sample sum, still split across lanes
+    Kernel kernel    = nullptr;
+    int    kernelKey = -1;               // the options kernel was chosen for
+   #endif
+    std::vector<float> mix;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SynthVoiceBank)
+};
@@ -0,0 +1,297 @@
+/*
+  ==============================================================================
+    Trace.cpp
+  ==============================================================================
+*/
+
+#include "Trace.h"
+
+#if AT_TRACING
+
+namespace
+{
+    struct Event
+    {
+        const char* name;
+        juce::int64 start;      // high-resolution ticks
+        juce::int64 duration;   // ticks, complete events only
+        juce::int64 value;      // the argument, or a flow's id
+        char        phase;      // Chrome trace phase: X, i, s, t or f
+    };
+
+    // -------------------------------------------------------------------------
+    // One thread's ring. Only its owner writes events; `written` counts every
+    // event ever written, so the reader can tell which slots are still valid.
+    // -------------------------------------------------------------------------
+    struct ThreadBuffer
+    {
+        std::array<Event, Trace::kEventsPerThread> events;
+        std::atomic<juce::uint64> written { 0 };
+        std::atomic<bool>         ready   { false };   // name set, safe to dump
+        std::atomic<bool>         inUse   { false };   // owned by a live thread
+
+        juce::String threadName;
+        bool         isMessageThread = false;
+    };
+
+    struct Recorder
+    {
+        std::unique_ptr<ThreadBuffer[]> buffers;
+        std::atomic<int>          numClaimed  { 0 };
+        std::atomic<juce::uint32> nextFlowId  { 1 };
+        std::atomic<juce::uint64> numDropped  { 0 };   // events from threads with no buffer
+        juce::int64               startTicks  = 0;
+    };
+
+    Recorder recorder;
+
+    constexpr int kUnclaimed = -1;
+
+    // -------------------------------------------------------------------------
+    // CONCEPT: Threads come and go — every device restart brings a new audio
+    // thread — so a slot is handed back when its thread exits. The next
+    // thread to need one takes it over, dropping the dead thread's events.
+    // A thread that finds every slot taken tries again on its next event,
+    // and what it couldn't record is counted.
+    // -------------------------------------------------------------------------
+    struct SlotOwner
+    {
+        int slot = kUnclaimed;
+
+        ~SlotOwner()
+        {
+            if (slot < 0 || recorder.buffers == nullptr)
+                return;
+
+            auto& buffer = recorder.buffers[slot];
+            buffer.ready.store (false, std::memory_order_release);
+            buffer.written.store (0, std::memory_order_release);
+            buffer.inUse.store (false, std::memory_order_release);
+        }
+    };
+
+    thread_local SlotOwner    threadSlot;
+    thread_local juce::uint32 currentFlowId = 0;
+
+    int claimSlot() noexcept
+    {
+        // A never-used slot first, then one a finished thread gave back
+        if (recorder.numClaimed.load (std::memory_order_relaxed) < Trace::kMaxThreads)
+        {
+            const int slot = recorder.numClaimed.fetch_add (1);
+
+            if (slot < Trace::kMaxThreads)
+            {
+                recorder.buffers[slot].inUse.store (true);
+                return slot;
+            }
+        }
+
+        for (int slot = 0; slot < Trace::kMaxThreads; ++slot)
+        {
+            bool expected = false;
+
+            if (recorder.buffers[slot].inUse.compare_exchange_strong (expected, true))
+                return slot;
+        }
+
+        return kUnclaimed;
+    }
+
+    ThreadBuffer* getThreadBuffer() noexcept
+    {
+        if (threadSlot.slot == kUnclaimed)
+        {
+            const int slot = claimSlot();
+
+            if (slot == kUnclaimed)
+                return nullptr;
+
+            // Copying a juce::String only bumps a reference count
+            auto& buffer = recorder.buffers[slot];
+            buffer.threadName = {};
+
+            if (auto* thread = juce::Thread::getCurrentThread())
+                buffer.threadName = thread->getThreadName();
+
+            buffer.isMessageThread = juce::MessageManager::existsAndIsCurrentThread();
+            buffer.ready.store (true, std::memory_order_release);
+            threadSlot.slot = slot;
+        }
+
+        return &recorder.buffers[threadSlot.slot];
+    }
+
+    void record (const Event& event) noexcept
+    {
+        if (auto* buffer = getThreadBuffer())
+        {
+            const auto index = buffer->written.load (std::memory_order_relaxed);
+            buffer->events[(size_t) (index % Trace::kEventsPerThread)] = event;
+            buffer->written.store (index + 1, std::memory_order_release);
+        }
+        else
+        {
+            recorder.numDropped.fetch_add (1, std::memory_order_relaxed);
+        }
+    }
+}
+
+std::atomic<bool> Trace::recording { false };
+
+//==============================================================================
+void Trace::start()
+{
+    if (recorder.buffers == nullptr)
+    {
+        recorder.buffers.reset (new ThreadBuffer[kMaxThreads]);
+        recorder.startTicks = juce::Time::getHighResolutionTicks();
+    }
+
+    recording.store (true);
+}
+
+juce::uint32 Trace::newFlowId() noexcept
+{
+    return recorder.nextFlowId.fetch_add (1, std::memory_order_relaxed);
+}
+
+juce::uint32 Trace::getCurrentFlowId() noexcept
+{
+    return currentFlowId;
+}
+
+juce::uint64 Trace::getNumDroppedEvents() noexcept
+{
+    return recorder.numDropped.load (std::memory_order_relaxed);
+}
+
+void Trace::complete (const char* name, juce::int64 start, juce::int64 duration, juce::int64 value) noexcept
+{
+    record ({ name, start, duration, value, 'X' });
+}
+
+void Trace::instant (const char* name, juce::int64 value) noexcept
+{
+    if (isRecording())
+        record ({ name, juce::Time::getHighResolutionTicks(), 0, value, 'i' });
+}
+
+void Trace::flow (const char* name, char phase, juce::uint32 id) noexcept
+{
+    if (id != 0 && isRecording())
+        record ({ name, juce::Time::getHighResolutionTicks(), 0, (juce::int64) id, phase });
+}
+
+Trace::FlowStep::FlowStep (const char* name, juce::uint32 id) noexcept
+    : previousId (currentFlowId)
+{
+    flow (name, 't', id);
+    currentFlowId = id;
+}
+
+Trace::FlowStep::~FlowStep()
+{
+    currentFlowId = previousId;
+}
+
+//==============================================================================
+juce::String Trace::writeChromeJson (const juce::File& file)
+{
+    if (recorder.buffers == nullptr)
+        return "Tracing hasn't been started (run with --trace)";
+
+    const auto toMicroseconds = [] (juce::int64 ticks)
+    {
+        return juce::String (juce::Time::highResolutionTicksToSeconds (ticks) * 1.0e6, 3);
+    };
+
+    juce::MemoryOutputStream json;
+    json << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":" << (juce::int64) getNumDroppedEvents()
+         << "},\"traceEvents\":[\n";
+
+    bool first = true;
+    const auto separator = [&] { json << (first ? "" : ",\n"); first = false; };
+
+    const int numBuffers = juce::jmin (recorder.numClaimed.load(), kMaxThreads);
+
+    for (int tid = 0; tid < numBuffers; ++tid)
+    {
+        auto& buffer = recorder.buffers[tid];
+
+        if (! buffer.ready.load (std::memory_order_acquire))
+            continue;
+
+        const auto threadName = buffer.isMessageThread        ? juce::String ("Message thread")
+                              : buffer.threadName.isNotEmpty() ? buffer.threadName
+                                                               : "Thread " + juce::String (tid);
+
+        separator();
+        json << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << tid
+             << ",\"args\":{\"name\":" << juce::JSON::toString (threadName) << "}}";
+
+        // ---------------------------------------------------------------------
+        // CONCEPT: The owner keeps writing while we copy. Snapshot the count,
+        // copy, then check it again: any slot the writer may have lapped in
+        // the meantime is thrown away rather than dumped half-written.
+        // ---------------------------------------------------------------------
+        const auto written = buffer.written.load (std::memory_order_acquire);
+        const auto oldest  = written > (juce::uint64) kEventsPerThread ? written - (juce::uint64) kEventsPerThread : 0;
+
+        std::vector<Event> events;
+        events.reserve ((size_t) (written - oldest));
+
+        for (auto i = oldest; i < written; ++i)
+            events.push_back (buffer.events[(size_t) (i % kEventsPerThread)]);
+
+        const auto writtenAfter = buffer.written.load (std::memory_order_acquire);
+        const auto oldestIntact = writtenAfter > (juce::uint64) kEventsPerThread ? writtenAfter - (juce::uint64) kEventsPerThread : 0;
+
+        // The count going backwards means the slot changed hands meanwhile
+        const auto numLapped    = writtenAfter < written
+                                    ? events.size()
+                                    : (size_t) juce::jmin ((juce::uint64) events.size(),
+                                                           oldestIntact > oldest ? oldestIntact - oldest : 0);
+
+        for (size_t i = numLapped; i < events.size(); ++i)
+        {
+            const auto& event = events[i];
+
+            separator();
+            json << "{\"ph\":\"" << juce::String::charToString (event.phase) << "\""
+                 << ",\"name\":" << juce::JSON::toString (juce::String (event.name))
+                 << ",\"pid\":1,\"tid\":" << tid
+                 << ",\"ts\":" << toMicroseconds (event.start - recorder.startTicks);
+
+            switch (event.phase)
+            {
+                case 'X':
+                    json << ",\"dur\":" << toMicroseconds (event.duration)
+                         << ",\"args\":{\"value\":" << event.value << "}";
+                    break;
+
+                case 'i':
+                    json << ",\"s\":\"t\",\"args\":{\"value\":" << event.value << "}";
+                    break;
+
+                default:
+                    // Flows match on category and id; "e" binds the end to
+                    // the slice it happened in rather than the next one
+                    json << ",\"cat\":\"flow\",\"id\":" << event.value
+                         << (event.phase == 'f' ? ",\"bp\":\"e\"" : "");
+                    break;
+            }
+
+            json << "}";
+        }
+    }
+
+    json << "\n]}\n";
+
+    if (! file.getParentDirectory().createDirectory() || ! file.replaceWithData (json.getData(), json.getDataSize()))
+        return "Couldn't write " + file.getFullPathName();
+
+    return {};
+}
+
+#endif
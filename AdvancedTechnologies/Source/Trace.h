@@ -0,0 +1,152 @@
+/*
+  ==============================================================================
+    Trace.h
+    A low-overhead event tracer for the audio, MIDI and message threads,
+    written out as Chrome trace JSON (open it in ui.perfetto.dev or
+    chrome://tracing).
+
+    CONCEPT: To find where a hit's latency goes, you need to line up events
+             from several threads on one timeline: the MIDI callback, the
+             callAsync on the message thread, and the audio block that
+             finally renders it. Logging can't do that from the audio thread
+             (it allocates and locks). A tracer can, if recording an event
+             is just a timestamp and a few stores.
+
+    CONCEPT: Each thread writes into its OWN ring buffer, so there is only
+             ever one writer per buffer and no locks or CAS loops at all.
+             The buffers are allocated up front by start(); a thread claims
+             one the first time it records and hands it back when it exits.
+             When a ring fills, the oldest events are overwritten, so the
+             dump holds the most recent few seconds of each thread. Events
+             from a thread that found all kMaxThreads taken are counted, and
+             the count goes into the dump.
+
+    CONCEPT: Flows connect events across threads. A MIDI note-on starts a
+             flow, the message thread steps it, and the audio block that
+             plays the hit ends it — the viewer draws arrows between them.
+             The id travels with the hit (see StepSequencer::Event).
+
+    Cost: with AT_TRACING set to 0 every macro compiles to nothing. With it
+          on but tracing not started, each macro is one atomic load.
+
+    Threads: record from any thread. start() and writeChromeJson() on the
+             message thread.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+#ifndef AT_TRACING
+ #define AT_TRACING 1
+#endif
+
+class Trace
+{
+public:
+    static constexpr int kMaxThreads      = 16;
+    static constexpr int kEventsPerThread = 16384;
+
+   #if AT_TRACING
+    //--------------------------------------------------------------------------
+    // Message thread
+    //--------------------------------------------------------------------------
+
+    // Allocates the ring buffers and starts recording. Safe to call again.
+    static void start();
+
+    // Writes everything recorded so far. Recording carries on.
+    // Returns an error message, or an empty string.
+    static juce::String writeChromeJson (const juce::File& file);
+
+    //--------------------------------------------------------------------------
+    // Any thread
+    //--------------------------------------------------------------------------
+    static bool isRecording() noexcept     { return recording.load (std::memory_order_acquire); }
+
+    // A new id for a flow, never 0
+    static juce::uint32 newFlowId() noexcept;
+
+    // The flow a FlowStep on this thread is carrying, or 0. Lets code deep
+    // inside a call (DrumEngine::triggerPad) pick up the id without every
+    // function in between passing it along.
+    static juce::uint32 getCurrentFlowId() noexcept;
+
+    // Events lost because every buffer was owned by another live thread
+    static juce::uint64 getNumDroppedEvents() noexcept;
+
+    static void instant (const char* name, juce::int64 value) noexcept;
+    static void flow (const char* name, char phase, juce::uint32 id) noexcept;
+
+    //--------------------------------------------------------------------------
+    // Records the time from construction to destruction as one event
+    //--------------------------------------------------------------------------
+    class Scope
+    {
+    public:
+        explicit Scope (const char* eventName, juce::int64 eventValue = 0) noexcept
+            : name (eventName), value (eventValue),
+              start (isRecording() ? juce::Time::getHighResolutionTicks() : 0) {}
+
+        ~Scope()
+        {
+            if (start != 0)
+                complete (name, start, juce::Time::getHighResolutionTicks() - start, value);
+        }
+
+    private:
+        const char*       name;
+        const juce::int64 value;
+        const juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE (Scope)
+    };
+
+    //--------------------------------------------------------------------------
+    // Steps a flow and makes it this thread's current flow while in scope
+    //--------------------------------------------------------------------------
+    class FlowStep
+    {
+    public:
+        FlowStep (const char* name, juce::uint32 id) noexcept;
+        ~FlowStep();
+
+    private:
+        const juce::uint32 previousId;
+
+        JUCE_DECLARE_NON_COPYABLE (FlowStep)
+    };
+
+private:
+    static std::atomic<bool> recording;
+
+    static void complete (const char* name, juce::int64 start, juce::int64 duration, juce::int64 value) noexcept;
+
+   #else
+    static void         start()                                  {}
+    static juce::String writeChromeJson (const juce::File&)      { return "Tracing was compiled out (AT_TRACING=0)"; }
+    static bool         isRecording() noexcept                   { return false; }
+    static juce::uint32 newFlowId() noexcept                     { return 0; }
+    static juce::uint32 getCurrentFlowId() noexcept              { return 0; }
+    static juce::uint64 getNumDroppedEvents() noexcept           { return 0; }
+   #endif
+};
+
+//==============================================================================
+// Names must be string literals: only the pointer is stored.
+//==============================================================================
+#if AT_TRACING
+ #define AT_TRACE_SCOPE(name)               const Trace::Scope JUCE_JOIN_MACRO (traceScope_, __LINE__) (name)
+ #define AT_TRACE_SCOPE_VALUE(name, value)  const Trace::Scope JUCE_JOIN_MACRO (traceScope_, __LINE__) (name, (juce::int64) (value))
+ #define AT_TRACE_INSTANT(name, value)      Trace::instant (name, (juce::int64) (value))
+ #define AT_TRACE_FLOW_BEGIN(name, id)      Trace::flow (name, 's', id)
+ #define AT_TRACE_FLOW_STEP(name, id)       const Trace::FlowStep JUCE_JOIN_MACRO (traceFlow_, __LINE__) (name, id)
+ #define AT_TRACE_FLOW_END(name, id)        Trace::flow (name, 'f', id)
+#else
+ #define AT_TRACE_SCOPE(name)
+ #define AT_TRACE_SCOPE_VALUE(name, value)
+ #define AT_TRACE_INSTANT(name, value)
+ #define AT_TRACE_FLOW_BEGIN(name, id)
+ #define AT_TRACE_FLOW_STEP(name, id)
+ #define AT_TRACE_FLOW_END(name, id)
+#endif
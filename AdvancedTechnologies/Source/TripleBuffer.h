@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+    TripleBuffer.h
+    Publishes a whole struct from one thread to another without locks.
+
+    CONCEPT: std::atomic<> only works for simple scalars. For anything bigger
+             (a drum pattern, a settings block) we keep three copies:
+               - the writer fills the "back" copy at its leisure
+               - publish() swaps it with the "middle" copy atomically
+               - the reader swaps the middle with its "front" copy when a
+                 new one is waiting, then reads front freely
+             Neither side ever waits, allocates, or sees a half-written value.
+             The reader may skip intermediate versions, which is what we want
+             for UI edits — only the latest one matters.
+
+    One writer thread and one reader thread only. T must be copyable.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    explicit TripleBuffer (const T& initialValue)
+    {
+        for (auto& slot : slots)
+            slot = initialValue;
+    }
+
+    //--------------------------------------------------------------------------
+    // Writer side
+    //--------------------------------------------------------------------------
+
+    // The copy the writer may freely modify before calling publish()
+    T& getWriteBuffer() noexcept                    { return slots[(size_t) backIndex]; }
+
+    // Makes the write buffer visible to the reader
+    void publish() noexcept
+    {
+        backIndex = middle.exchange (backIndex | dirtyBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    void publish (const T& newValue)
+    {
+        getWriteBuffer() = newValue;
+        publish();
+    }
+
+    //--------------------------------------------------------------------------
+    // Reader side
+    //--------------------------------------------------------------------------
+
+    // Picks up the latest published value, if any. Returns true if it changed.
+    bool update() noexcept
+    {
+        if ((middle.load (std::memory_order_relaxed) & dirtyBit) == 0)
+            return false;
+
+        frontIndex = middle.exchange (frontIndex, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    const T& read() const noexcept                  { return slots[(size_t) frontIndex]; }
+
+private:
+    static constexpr int dirtyBit  = 4;
+    static constexpr int indexMask = 3;
+
+    std::array<T, 3> slots {};
+    int frontIndex = 0;               // reader only
+    int backIndex  = 2;               // writer only
+    std::atomic<int> middle { 1 };    // shared
+
+    JUCE_DECLARE_NON_COPYABLE (TripleBuffer)
+};